@@ -81,6 +81,13 @@ miniexact_choose_i_naively_cost(miniexact_algorithm* a,
 miniexact_link
 miniexact_choose_i_mrv(miniexact_algorithm* a, miniexact_problem* p, int32_t t);
 
+// MRV through buckets of active primary items by LEN, instead of scanning all
+// of them. Only supported by Algorithms X and C.
+miniexact_link
+miniexact_choose_i_mrv_bucket(miniexact_algorithm* a,
+                              miniexact_problem* p,
+                              int32_t t);
+
 miniexact_link
 miniexact_choose_i_mrv_cost(miniexact_algorithm* a,
                             miniexact_problem* p,
@@ -128,6 +135,10 @@ miniexact_algorithm*
 miniexact_algorithm_c_allocate(void);
 miniexact_algorithm*
 miniexact_algorithm_m_allocate(void);
+miniexact_algorithm*
+miniexact_algorithm_z_allocate(void);
+miniexact_algorithm*
+miniexact_algorithm_dc_allocate(void);
 
 #ifdef __cplusplus
 }
@@ -22,11 +22,34 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+
 typedef struct miniexact_algorithm miniexact_algorithm;
 
+// Encodings of "at most one option per item". AUTO uses pairwise clauses for
+// short items, the sequential counter for medium and the product encoding for
+// long ones, so the CNF stays linear in the size of the matrix.
+typedef enum miniexact_amo_encoding {
+  MINIEXACT_AMO_AUTO,
+  MINIEXACT_AMO_PAIRWISE,
+  MINIEXACT_AMO_SEQUENTIAL,
+  MINIEXACT_AMO_COMMANDER,
+  MINIEXACT_AMO_PRODUCT
+} miniexact_amo_encoding;
+
 void
 miniexact_algoritihm_knuth_cnf_set(miniexact_algorithm* a);
 
+// Writes the CNF for external solvers in one traversal instead of counting
+// variables and clauses first. The whole CNF is kept in memory until solving.
+void
+miniexact_knuth_cnf_set_one_pass(bool enabled);
+
+// Parses auto, pairwise, sequential, commander or product.
+bool
+miniexact_amo_encoding_from_name(const char* name,
+                                 miniexact_amo_encoding* encoding);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,45 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_ALGORITHM_X_BITSET_H
+#define MINIEXACT_ALGORITHM_X_BITSET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct miniexact_algorithm miniexact_algorithm;
+
+// Larger problems are solved with dancing links (Algorithm X) instead, as the
+// work per search node grows with items times options.
+#define MINIEXACT_BITSET_MAX_ITEMS 512
+#define MINIEXACT_BITSET_MAX_OPTIONS 8192
+
+// Algorithm X on bitsets, for small and dense problems. Every item has the
+// set of options containing it as a bitset over all options. Covering an
+// option clears the options of its items from the active options with AND-NOT,
+// MRV counts the active options of an item with popcount. Colors are ignored,
+// like in Algorithm X. Falls back to Algorithm X for problems that exceed the
+// limits above.
+void
+miniexact_algorithm_x_bitset_set(miniexact_algorithm* a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_ALGORITHM_Z_H
+#define MINIEXACT_ALGORITHM_Z_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct miniexact_algorithm miniexact_algorithm;
+typedef struct miniexact_problem miniexact_problem;
+
+// Algorithm Z (TAOCP 7.2.2.1, "Dancing with ZDDs"): builds a ZDD of all
+// exact covers, sharing subproblems that leave the same items uncovered. The
+// first call to compute_next_result builds the ZDD, every call then yields the
+// next solution encoded in it. Colors are not supported.
+void
+miniexact_algorithm_z_set(miniexact_algorithm* a);
+
+// Number of ZDD nodes, including the two sinks. 0 if not built yet.
+size_t
+miniexact_algorithm_z_size(miniexact_problem* p);
+
+// Exact number of solutions as decimal string, to be freed by the caller. NULL
+// if the ZDD was not built yet.
+char*
+miniexact_algorithm_z_count(miniexact_problem* p);
+
+// Writes the ZDD to path, one node per line: "id option lo hi". Node 0 is the
+// empty family, node 1 the family containing only the empty set. Options are
+// given as indices like printed solutions. Returns NULL on success.
+const char*
+miniexact_algorithm_z_write(miniexact_problem* p, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
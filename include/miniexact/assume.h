@@ -0,0 +1,108 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_ASSUME_H
+#define MINIEXACT_ASSUME_H
+
+// Solving many instances that differ only in forced and forbidden options on
+// one matrix.
+//
+// Forbidden options are unlinked from their items, forced options are
+// committed like in step C5 of Algorithm C. The search then only sees the
+// remaining problem, and undoing the assumptions restores the matrix exactly,
+// so the cost of an instance is proportional to its search. Options are given
+// by the indices returned by miniexact_extract_solution_option_indices, i.e.
+// starting at 1. Works with the dancing links engines of Algorithms X, C, C$
+// and M (without multiplicities).
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "miniexact.h"
+
+typedef struct miniexact_assumptions {
+  // First node of every option by index, 0 for options removed by
+  // preprocessing.
+  miniexact_link* first;
+  miniexact_link options;
+
+  // 1 for forced and 2 for forbidden options.
+  unsigned char* mark;
+
+  // Applied options, in the order they were applied.
+  miniexact_link* forced;
+  size_t forced_size;
+  miniexact_link* forbidden;
+  size_t forbidden_size;
+
+  // Set if the forced options exclude each other, so there is no solution.
+  bool conflict;
+} miniexact_assumptions;
+
+// Indexes the options of the fully built problem p. Returns an error message
+// if the problem has multiplicities.
+const char*
+miniexact_assumptions_init(miniexact_assumptions* s, miniexact_problem* p);
+
+// Undoes the current assumptions and frees s.
+void
+miniexact_assumptions_free(miniexact_assumptions* s,
+                           miniexact_algorithm* a,
+                           miniexact_problem* p);
+
+// Replaces the current assumptions. A running search is backtracked to the
+// root first, and the next call of miniexact_assumptions_solve starts a new
+// search. Returns an error message for unknown option indices.
+const char*
+miniexact_assume(miniexact_assumptions* s,
+                 miniexact_algorithm* a,
+                 miniexact_problem* p,
+                 const miniexact_link* force,
+                 size_t force_count,
+                 const miniexact_link* forbid,
+                 size_t forbid_count);
+
+// Backtracks a running search and restores the original matrix.
+void
+miniexact_assumptions_undo(miniexact_assumptions* s,
+                           miniexact_algorithm* a,
+                           miniexact_problem* p);
+
+// Like miniexact_solve_problem, returning 20 right away if the forced options
+// conflict.
+int
+miniexact_assumptions_solve(miniexact_assumptions* s,
+                            miniexact_algorithm* a,
+                            miniexact_problem* p);
+
+// Writes the forced options followed by the options of the current solution
+// to solution, which needs room for forced_size + p->l entries. Returns the
+// number of options written.
+miniexact_link
+miniexact_assumptions_extract_solution(const miniexact_assumptions* s,
+                                       miniexact_problem* p,
+                                       miniexact_link* solution);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_BINARY_H
+#define MINIEXACT_BINARY_H
+
+// Binary problem files store a fully built problem matrix, including the item
+// and color names. Loading maps the file copy-on-write and lets the problem
+// arrays point directly into the mapping, so no parsing or linking is required
+// and startup time does not depend on the problem size.
+//
+// The format uses the native byte order and node layout of the build that
+// wrote it. Files are rejected if either differs.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct miniexact_problem miniexact_problem;
+typedef struct miniexact_algorithm miniexact_algorithm;
+
+#define MINIEXACT_BINARY_MAGIC "MNXBIN\r\n"
+#define MINIEXACT_BINARY_MAGIC_LEN 8
+
+// Write the problem p, which must not be in the middle of a search, to path.
+// Returns an error message on failure.
+const char*
+miniexact_write_problem_binary(miniexact_problem* p, const char* path);
+
+// True if the buffer starts like a binary problem file.
+bool
+miniexact_is_problem_binary(const char* buf, size_t len);
+
+miniexact_problem*
+miniexact_load_problem_binary(miniexact_algorithm* a, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_BUDGET_H
+#define MINIEXACT_BUDGET_H
+
+// Limits on the time, nodes, solutions and memory of one search.
+//
+// The engines count every node they enter and stop with false from
+// compute_next_result once a limit is exceeded, leaving the problem in a
+// state from which the search could continue. The clock and the memory are
+// only read every few nodes. The solution limit is checked by the driver.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "miniexact.h"
+
+// Exit code of a search that was stopped by its budget, next to 10 (a
+// solution was found) and 20 (no (more) solutions).
+#define MINIEXACT_BUDGET_EXHAUSTED 30
+
+typedef enum miniexact_budget_limit {
+  MINIEXACT_BUDGET_NONE,
+  MINIEXACT_BUDGET_TIME,
+  MINIEXACT_BUDGET_NODES,
+  MINIEXACT_BUDGET_SOLUTIONS,
+  MINIEXACT_BUDGET_MEMORY
+} miniexact_budget_limit;
+
+typedef struct miniexact_budget {
+  // Limits, 0 means unlimited.
+  double time_limit;
+  uint64_t node_limit;
+  long long solution_limit;
+  size_t memory_limit;
+
+  // Resident memory when the budget started. Only what the search adds on top
+  // counts, so an earlier file of the same run does not use up the limit.
+  size_t memory_base;
+
+  double start;
+  uint64_t nodes;
+  long long solutions;
+
+  // Nodes entered again while replaying a checkpoint. They were counted by the
+  // run that wrote it, so they neither count nor stop the search.
+  uint64_t replayed;
+
+  // The limit that stopped the search.
+  miniexact_budget_limit exhausted;
+} miniexact_budget;
+
+// Returns true if cfg sets any limit.
+bool
+miniexact_budget_configured(const miniexact_config* cfg);
+
+// Starts the budget of cfg (time limit in seconds, memory limit in MiB) for
+// the search of p and installs it in p.
+void
+miniexact_budget_init(miniexact_budget* b,
+                      miniexact_problem* p,
+                      const miniexact_config* cfg);
+
+// Called by the engines after entering a new node. Returns false if the
+// search has to stop.
+bool
+miniexact_budget_descend(miniexact_budget* b);
+
+// Called by the driver for every solution. Returns false if no more
+// solutions may be reported.
+bool
+miniexact_budget_solution(miniexact_budget* b);
+
+// Prints the limit that stopped the search together with the nodes, solutions
+// and time so far.
+void
+miniexact_budget_print(const miniexact_budget* b, FILE* f);
+
+// Uninstalls the budget from p.
+void
+miniexact_budget_finish(miniexact_budget* b, miniexact_problem* p);
+
+// Current resident memory of the process in bytes, 0 if unknown.
+size_t
+miniexact_current_memory(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
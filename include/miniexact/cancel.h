@@ -0,0 +1,91 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_CANCEL_H
+#define MINIEXACT_CANCEL_H
+
+// Cooperative cancellation of a running search, e.g. from another thread.
+//
+// Every interval nodes, the engines of Algorithms X, C, M and C$ call the
+// progress callback of the handle and check whether cancellation was
+// requested. Once it was, they refuse to descend any further and backtrack to
+// the root, restoring the matrix on the way, so compute_next_result returns
+// false with the problem in its initial state. After
+// miniexact_cancel_reset and setting p->state to 0, the problem can be
+// solved again.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "miniexact.h"
+
+// Result of miniexact_solve_problem for a cancelled search.
+#define MINIEXACT_CANCELLED 40
+
+#define MINIEXACT_CANCEL_DEFAULT_INTERVAL 4096
+
+// Called every interval nodes with the number of nodes so far. Returning
+// false cancels the search.
+typedef bool (*miniexact_progress_callback)(miniexact_problem* p,
+                                            uint64_t nodes,
+                                            void* userdata);
+
+miniexact_cancel*
+miniexact_cancel_new(void);
+
+void
+miniexact_cancel_free(miniexact_cancel* c);
+
+// Requests the search to stop. Safe to call from any thread.
+void
+miniexact_cancel_request(miniexact_cancel* c);
+
+// Returns true if cancellation was requested since the last reset.
+bool
+miniexact_cancel_requested(miniexact_cancel* c);
+
+// Returns true if the engine noticed a request and stopped the search.
+bool
+miniexact_cancel_stopped(miniexact_cancel* c);
+
+// Clears a request and the node counter, so that the handle can be reused.
+void
+miniexact_cancel_reset(miniexact_cancel* c);
+
+// Sets the callback called every interval nodes, which is also how often a
+// request is noticed. NULL removes the callback, an interval of 0 keeps the
+// current one.
+void
+miniexact_cancel_set_progress(miniexact_cancel* c,
+                              miniexact_progress_callback progress,
+                              unsigned int interval,
+                              void* userdata);
+
+// Called by the engines before descending into option x[l]. Returns false
+// once the search is cancelled.
+bool
+miniexact_cancel_descend(miniexact_cancel* c, miniexact_problem* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
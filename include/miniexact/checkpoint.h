@@ -0,0 +1,99 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_CHECKPOINT_H
+#define MINIEXACT_CHECKPOINT_H
+
+// Checkpoints of long enumerations for Algorithms X, C and M.
+//
+// A checkpoint is the decision stack x[0..l] at the moment the search is about
+// to descend into option x[l], together with the number of solutions found so
+// far. As choosing an item only depends on the matrix, which dancing links
+// restores exactly, a fresh copy of the same problem reaches the same state by
+// replaying the stack: on every level, all options before the recorded one are
+// skipped instead of explored. The search then continues right where the
+// checkpoint was written, so no solution is reported twice. A search suspended
+// right after a solution replays the stack of that solution and drops it.
+//
+// Checkpoints are written at most every interval seconds, after flushing
+// stdout, to a temporary file that is then renamed over the old checkpoint.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <time.h>
+
+#include "miniexact.h"
+
+#define MINIEXACT_CHECKPOINT_DEFAULT_INTERVAL 60
+
+typedef struct miniexact_checkpoint {
+  const char* path;
+  int interval;
+  time_t last_write;
+  unsigned descents;
+
+  // Identifies the problem and the search the checkpoint belongs to.
+  int algorithm_select;
+
+  // Solutions found before the current position, maintained by the driver.
+  long long solutions;
+
+  // Stack still to be replayed, empty once the search caught up.
+  miniexact_link* replay;
+  miniexact_link replay_size;
+
+  // Set if the replayed stack ends in a solution that was reported before.
+  bool skip_solution;
+} miniexact_checkpoint;
+
+// Prepares checkpointing p to cfg->checkpoint and installs it in p. If
+// cfg->resume is set and the file exists, the stack stored in it is replayed
+// by the next search. Returns an error message if the file cannot be read or
+// belongs to another problem.
+const char*
+miniexact_checkpoint_init(miniexact_checkpoint* c,
+                          miniexact_problem* p,
+                          miniexact_config* cfg);
+
+// Called by the engines before descending into option x[l]. Returns false if
+// the option was already explored before the checkpoint and has to be skipped.
+bool
+miniexact_checkpoint_descend(miniexact_checkpoint* c, miniexact_problem* p);
+
+// Called by the driver for every solution. Returns false for the solution a
+// suspended search stopped at, which was already reported.
+bool
+miniexact_checkpoint_solution(miniexact_checkpoint* c);
+
+// Removes the checkpoint file after the search finished and uninstalls c.
+void
+miniexact_checkpoint_finish(miniexact_checkpoint* c, miniexact_problem* p);
+
+// Writes a final checkpoint for a search that stopped right after entering
+// level l (or finding a solution there, if skip_solution is set), so that it
+// is continued when resumed, and uninstalls c.
+void
+miniexact_checkpoint_suspend(miniexact_checkpoint* c, miniexact_problem* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_COMPONENTS_H
+#define MINIEXACT_COMPONENTS_H
+
+// Decomposition into independent components.
+//
+// Two primary items are connected if some active option contains both, or if
+// active options containing them share a secondary item that is not purified
+// yet. Components of this relation are independent subproblems: a solution is
+// the union of one solution per component, so the number of solutions is the
+// product of their numbers. The search below splits the active items into
+// components before branching and again at every node of the search tree.
+// It uses the operations of Algorithm C, so it solves problems for X and C.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "miniexact.h"
+
+// Number of components of the active primary items.
+miniexact_link
+miniexact_components_count(miniexact_problem* p);
+
+// Counts all solutions of p. Returns NULL on success, or an error message if
+// the count does not fit into 64 bits.
+const char*
+miniexact_components_count_solutions(miniexact_problem* p, uint64_t* count);
+
+// Finds one solution of p and writes its options into x, component by
+// component. Returns 10 if there is a solution and 20 otherwise, like
+// miniexact_solve_problem. The matrix is restored afterwards.
+int
+miniexact_components_solve(miniexact_problem* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
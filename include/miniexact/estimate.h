@@ -0,0 +1,135 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_ESTIMATE_H
+#define MINIEXACT_ESTIMATE_H
+
+// Monte Carlo estimate of the search tree of Algorithms X, C and M.
+//
+// Knuth's estimator (TAOCP 7.2.2, "Estimating the running time") follows one
+// random path from the root. On level l, the engine chooses its item as usual
+// and reports the number d_l of options it would try, of which exactly one is
+// taken at random. The products D_l = d_0 * ... * d_{l-1} are unbiased
+// estimates of the number of nodes on level l, so their sum estimates the
+// whole tree, D_l at a solution estimates the number of solutions and the
+// mems and the time spent at a node until it is left, multiplied by D_l,
+// estimate the total cost. Averaging
+// many paths gives the estimate and its confidence interval.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "miniexact.h"
+
+// Sums over all walks of the estimates of one quantity, so that mean and
+// variance can be derived.
+typedef struct miniexact_estimate_sum {
+  double sum;
+  double sum_sq;
+} miniexact_estimate_sum;
+
+typedef struct miniexact_estimate {
+  uint64_t rng;
+
+  // Per level of the current walk: the number of options the engine tries,
+  // the randomly chosen one, how many have been offered so far and the
+  // product D_l of the degrees above.
+  miniexact_link* degree;
+  miniexact_link* choice;
+  miniexact_link* tried;
+  double* weight;
+  size_t levels_capacity;
+
+  // The current walk.
+  double walk_nodes;
+  double walk_mems;
+  double walk_time;
+  double walk_solutions;
+  uint64_t last_mems;
+  double last_time;
+
+  long long walks;
+  miniexact_estimate_sum nodes;
+  miniexact_estimate_sum mems;
+  miniexact_estimate_sum time;
+  miniexact_estimate_sum solutions;
+} miniexact_estimate;
+
+// Installs the estimator on p. Walks are reproducible for the same seed.
+void
+miniexact_estimate_init(miniexact_estimate* e,
+                        miniexact_problem* p,
+                        uint64_t seed);
+
+// Called by the engines after choosing item i on level l, with the number of
+// options they are going to try for it.
+void
+miniexact_estimate_choose(miniexact_estimate* e,
+                          miniexact_problem* p,
+                          miniexact_link degree);
+
+// Called by the engines before descending into option x[l]. Returns false
+// for every option except the randomly chosen one.
+bool
+miniexact_estimate_descend(miniexact_estimate* e, miniexact_problem* p);
+
+// Called by the engines before backtracking from level l.
+void
+miniexact_estimate_leave(miniexact_estimate* e, miniexact_problem* p);
+
+// Follows one random path from the root of p and adds it to the estimate.
+void
+miniexact_estimate_walk(miniexact_estimate* e,
+                        miniexact_algorithm* a,
+                        miniexact_problem* p);
+
+// Adds the walks of another estimator, e.g. one of a worker thread.
+void
+miniexact_estimate_merge(miniexact_estimate* e, const miniexact_estimate* o);
+
+// Mean of an estimated quantity and the half width of its 95% confidence
+// interval.
+double
+miniexact_estimate_mean(const miniexact_estimate* e,
+                        const miniexact_estimate_sum* s,
+                        double* error);
+
+// Prints the estimated nodes, solutions, mems and time to f.
+void
+miniexact_estimate_print(const miniexact_estimate* e, FILE* f);
+
+// Uninstalls the estimator from p and releases its levels.
+void
+miniexact_estimate_finish(miniexact_estimate* e, miniexact_problem* p);
+
+// Runs cfg->estimate random walks, spread over cfg->threads workers, and
+// prints the estimate instead of solving p.
+int
+miniexact_estimate_and_print(miniexact_algorithm* a,
+                             miniexact_problem* p,
+                             miniexact_config* cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
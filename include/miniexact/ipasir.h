@@ -0,0 +1,84 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_IPASIR_H
+#define MINIEXACT_IPASIR_H
+
+// Incremental SAT solvers loaded at runtime through the IPASIR interface.
+//
+// Any shared library exporting the ipasir_* functions (e.g. CaDiCaL) can be
+// used. The problem is then encoded only once, and further solutions are found
+// by adding blocking clauses and solving again, instead of starting a new
+// solver process for every solution.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct miniexact_ipasir {
+  void* library;
+  void* solver;
+
+  const char* (*signature)(void);
+  void* (*init)(void);
+  void (*release)(void* solver);
+  void (*add)(void* solver, int32_t lit);
+  int (*solve)(void* solver);
+  int32_t (*val)(void* solver, int32_t lit);
+} miniexact_ipasir;
+
+// Loads the library at path and creates a solver. Returns false if the library
+// cannot be loaded or misses some function.
+bool
+miniexact_ipasir_open(miniexact_ipasir* s, const char* path);
+
+// Opens library (the --ipasir option) if given, else the one in
+// $MINIEXACT_IPASIR or the first known one that is installed. Returns false
+// if there is none, so the caller can start an external solver instead.
+bool
+miniexact_ipasir_find(miniexact_ipasir* s, const char* library);
+
+// Releases the solver and unloads the library.
+void
+miniexact_ipasir_close(miniexact_ipasir* s);
+
+// Adds a literal of the current clause, 0 ends the clause.
+static inline void
+miniexact_ipasir_add(miniexact_ipasir* s, int32_t lit) {
+  s->add(s->solver, lit);
+}
+
+// Returns 10 (SAT), 20 (UNSAT) or 0 (interrupted), like external solvers.
+static inline int
+miniexact_ipasir_solve(miniexact_ipasir* s) {
+  return s->solve(s->solver);
+}
+
+// Returns true if the variable is true in the model of the last SAT result.
+static inline bool
+miniexact_ipasir_value(miniexact_ipasir* s, int32_t var) {
+  return s->val(s->solver, var) > 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -30,6 +30,12 @@ typedef int32_t miniexact_link;
 typedef miniexact_link miniexact_color;
 typedef char* miniexact_name;
 typedef struct miniexact_algorithm miniexact_algorithm;
+typedef struct miniexact_parallel_worker miniexact_parallel_worker;
+typedef struct miniexact_checkpoint miniexact_checkpoint;
+typedef struct miniexact_profile miniexact_profile;
+typedef struct miniexact_estimate miniexact_estimate;
+typedef struct miniexact_budget miniexact_budget;
+typedef struct miniexact_cancel miniexact_cancel;
 
 #define MINIEXACT_LINK_MAX INT32_MAX
 
@@ -45,14 +51,32 @@ typedef struct miniexact_algorithm miniexact_algorithm;
   size_t NAME##_size;   \
   size_t NAME##_capacity;
 
-#define MINIEXACT_ARR_ALLOC(TYPE, ARR)                     \
-  p->ARR##_capacity = 65536;                         \
-  p->ARR = malloc(p->ARR##_capacity * sizeof(TYPE)); \
+// Arrays start small and double when full. Parsers reserve capacity up front
+// when they can estimate the final size, and the problem is compacted into a
+// single arena once all options are known (see miniexact_problem_compact).
+#define MINIEXACT_ARR_INITIAL_CAPACITY 64
+
+#define MINIEXACT_ARR_ALLOC(TYPE, ARR)                               \
+  p->ARR##_capacity = MINIEXACT_ARR_INITIAL_CAPACITY;                \
+  p->ARR = miniexact_malloc(p->ARR##_capacity * sizeof(TYPE));       \
   p->ARR##_size = 0;
 
-#define MINIEXACT_ARR_REALLOC(ARR)                 \
-  p->ARR##_capacity = p->ARR##_capacity * 4; \
-  p->ARR = realloc(p->ARR, p->ARR##_capacity * sizeof(p->ARR[0]));
+#define MINIEXACT_ARR_RESIZE(ARR, CAPACITY)                               \
+  p->ARR = miniexact_problem_realloc(p,                                   \
+                                     p->ARR,                              \
+                                     p->ARR##_capacity * sizeof(p->ARR[0]), \
+                                     (CAPACITY) * sizeof(p->ARR[0]));     \
+  p->ARR##_capacity = (CAPACITY);
+
+#define MINIEXACT_ARR_REALLOC(ARR)                                  \
+  MINIEXACT_ARR_RESIZE(ARR,                                         \
+                       p->ARR##_capacity ? p->ARR##_capacity * 2    \
+                                         : MINIEXACT_ARR_INITIAL_CAPACITY)
+
+#define MINIEXACT_ARR_RESERVE(ARR, N)      \
+  if(p->ARR##_capacity < (size_t)(N)) {    \
+    MINIEXACT_ARR_RESIZE(ARR, (size_t)(N)) \
+  }
 
 #define MINIEXACT_ARR_PLUSN(ARR, N)                     \
   while(p->ARR##_size + N >= p->ARR##_capacity) { \
@@ -68,6 +92,12 @@ typedef struct miniexact_algorithm miniexact_algorithm;
 
 #define MINIEXACT_ARR_PLUS1(ARR) MINIEXACT_ARR_PLUSN(ARR, 1)
 
+#define MINIEXACT_ARR_CLONE(ARR)                                      \
+  if(o->ARR) {                                                        \
+    p->ARR = miniexact_malloc(o->ARR##_capacity * sizeof(o->ARR[0])); \
+    memcpy(p->ARR, o->ARR, o->ARR##_size * sizeof(o->ARR[0]));        \
+  }
+
 typedef struct miniexact_config {
   int verbose;
   int print_options;
@@ -76,6 +106,26 @@ typedef struct miniexact_config {
   int transform_to_libexact;
   int algorithm_select;
   int solutions;
+  int threads;
+  const char* write_binary;
+  const char* write_zdd;
+  int count;
+  int components;
+  int stats;
+  int profile;
+  const char* profile_csv;
+  long long estimate;
+  double time_limit;
+  long long node_limit;
+  long long solution_limit;
+  long long memory_limit;
+  const char* ipasir;
+  int amo;
+  int one_pass;
+  const char* portfolio;
+  const char* checkpoint;
+  int checkpoint_interval;
+  int resume;
   char* const* input_files;
   size_t input_files_count;
   size_t current_input_file;
@@ -90,15 +140,116 @@ typedef enum miniexact_algorithm_id {
   MINIEXACT_ALGORITHM_M = 1 << 6,
   MINIEXACT_ALGORITHM_KNUTH_CNF = 1 << 7,
   MINIEXACT_ALGORITHM_DOLLARS = 1 << 8,
-  MINIEXACT_ALGORITHM_C_DOLLAR = 1 << 8
+  MINIEXACT_ALGORITHM_C_DOLLAR = 1 << 8,
+  MINIEXACT_ALGORITHM_MRV_BUCKET = 1 << 9,
+  MINIEXACT_ALGORITHM_Z = 1 << 10,
+  MINIEXACT_ALGORITHM_DC = 1 << 11,
+  MINIEXACT_ALGORITHM_BITSET = 1 << 12,
+  MINIEXACT_ALGORITHM_PREPROCESS = 1 << 13
 } miniexact_algorithm_id;
 
 #define MINIEXACT_LONG_OPTIONS (1 << 20)
 #define MINIEXACT_OPTION_PRINT_X (MINIEXACT_LONG_OPTIONS + 1)
+#define MINIEXACT_OPTION_WRITE_ZDD (MINIEXACT_LONG_OPTIONS + 2)
+#define MINIEXACT_OPTION_COMPONENTS (MINIEXACT_LONG_OPTIONS + 3)
+#define MINIEXACT_OPTION_CHECKPOINT (MINIEXACT_LONG_OPTIONS + 4)
+#define MINIEXACT_OPTION_CHECKPOINT_INTERVAL (MINIEXACT_LONG_OPTIONS + 5)
+#define MINIEXACT_OPTION_PROFILE_CSV (MINIEXACT_LONG_OPTIONS + 6)
+#define MINIEXACT_OPTION_ESTIMATE (MINIEXACT_LONG_OPTIONS + 7)
+#define MINIEXACT_OPTION_TIME_LIMIT (MINIEXACT_LONG_OPTIONS + 8)
+#define MINIEXACT_OPTION_NODE_LIMIT (MINIEXACT_LONG_OPTIONS + 9)
+#define MINIEXACT_OPTION_SOLUTION_LIMIT (MINIEXACT_LONG_OPTIONS + 10)
+#define MINIEXACT_OPTION_MEMORY_LIMIT (MINIEXACT_LONG_OPTIONS + 11)
+#define MINIEXACT_OPTION_IPASIR (MINIEXACT_LONG_OPTIONS + 12)
+#define MINIEXACT_OPTION_AMO (MINIEXACT_LONG_OPTIONS + 13)
+#define MINIEXACT_OPTION_PORTFOLIO (MINIEXACT_LONG_OPTIONS + 14)
+
+#ifdef MINIEXACT_INTERLEAVED_NODES
+// All fields of a node that are read together while hiding and unhiding
+// options. Keeping them in one record means every step of hide/unhide only
+// touches a single cache line instead of one per array.
+typedef struct miniexact_node {
+  miniexact_link ulink;
+  miniexact_link dlink;
+#ifndef SWIG
+  union {
+#endif
+    miniexact_link top;
+#ifndef SWIG
+    miniexact_link len;
+  };
+#endif
+  miniexact_color color;
+} miniexact_node;
+
+#define MINIEXACT_NODES_ALLOC() MINIEXACT_ARR_ALLOC(miniexact_node, node)
+#define MINIEXACT_NODES_PLUSN(N) MINIEXACT_ARR_PLUSN(node, N)
+#define MINIEXACT_NODES_RESERVE(N) MINIEXACT_ARR_RESERVE(node, N)
+#define MINIEXACT_NODES_CLONE() MINIEXACT_ARR_CLONE(node)
+#define MINIEXACT_NODES_SIZE(P) ((P)->node_size)
+#else
+#define MINIEXACT_NODES_ALLOC()                \
+  MINIEXACT_ARR_ALLOC(miniexact_link, ulink)   \
+  MINIEXACT_ARR_ALLOC(miniexact_link, dlink)   \
+  MINIEXACT_ARR_ALLOC(miniexact_link, len)     \
+  MINIEXACT_ARR_ALLOC(miniexact_color, color)
+#define MINIEXACT_NODES_PLUSN(N) \
+  MINIEXACT_ARR_PLUSN(ulink, N)  \
+  MINIEXACT_ARR_PLUSN(dlink, N)  \
+  MINIEXACT_ARR_PLUSN(len, N)    \
+  MINIEXACT_ARR_PLUSN(color, N)
+#define MINIEXACT_NODES_RESERVE(N) \
+  MINIEXACT_ARR_RESERVE(ulink, N)  \
+  MINIEXACT_ARR_RESERVE(dlink, N)  \
+  MINIEXACT_ARR_RESERVE(len, N)    \
+  MINIEXACT_ARR_RESERVE(color, N)
+#define MINIEXACT_NODES_CLONE() \
+  MINIEXACT_ARR_CLONE(ulink)    \
+  MINIEXACT_ARR_CLONE(dlink)    \
+  MINIEXACT_ARR_CLONE(top)      \
+  MINIEXACT_ARR_CLONE(color)
+#define MINIEXACT_NODES_SIZE(P) ((P)->ulink_size)
+#endif
+
+// What miniexact_preprocess removed from a problem.
+typedef struct miniexact_preprocess_stats {
+  int rounds;
+  int removed_options;
+  int removed_secondary_items;
+} miniexact_preprocess_stats;
+
+// Counters of a search, in the spirit of Knuth's mems and updates. The
+// counters are only maintained if built with MINIEXACT_STATS, the times always.
+typedef struct miniexact_stats {
+  // Options the search descended into.
+  uint64_t nodes;
+  // Links, lengths and colors written by the operations in ops.h.
+  uint64_t updates;
+  // Reads and writes of node and item records by the operations in ops.h and
+  // choose_i, counting one per record.
+  uint64_t mems;
+  // Items (or buckets) inspected by choose_i.
+  uint64_t choose_scans;
+
+  // Seconds spent reading the problem and in compute_next_result.
+  double parse_time;
+  double solve_time;
+} miniexact_stats;
+
+// Open-addressing hash table from names to their index in a name array. Empty
+// slots are -1, the capacity is always a power of two.
+typedef struct miniexact_name_index {
+  miniexact_link* slots;
+  size_t capacity;
+  size_t count;
+} miniexact_name_index;
 
 typedef struct miniexact_problem {
   ARR(miniexact_link, llink)
   ARR(miniexact_link, rlink)
+#ifdef MINIEXACT_INTERLEAVED_NODES
+  ARR(miniexact_node, node)
+#else
   ARR(miniexact_link, ulink)
   ARR(miniexact_link, dlink)
 #ifndef SWIG
@@ -112,11 +263,16 @@ typedef struct miniexact_problem {
       ARR(miniexact_link, len)
     };
   };
+#endif
 #endif
 
   ARR(miniexact_name, name)
   ARR(miniexact_name, color_name)
+  miniexact_name_index name_index;
+  miniexact_name_index color_name_index;
+#ifndef MINIEXACT_INTERLEAVED_NODES
   ARR(miniexact_color, color)
+#endif
   ARR(miniexact_link, ft)
   ARR(miniexact_link, slack)
   ARR(miniexact_link, bound)
@@ -128,6 +284,14 @@ typedef struct miniexact_problem {
   // Solution
   ARR(miniexact_link, x)
 
+  // Active primary items in doubly linked lists by LEN, only maintained once
+  // miniexact_choose_i_mrv_bucket was first called. Entries 1..N_1 are the
+  // items, the list heads of the buckets start at bucket_head.
+  ARR(miniexact_link, bucket_next)
+  ARR(miniexact_link, bucket_prev)
+  miniexact_link bucket_head;
+  miniexact_link bucket_min;
+
   int N, N_1, M, i, j, l, p, q, Z, K;
   int primary_item_count;
   int secondary_item_count;
@@ -136,12 +300,90 @@ typedef struct miniexact_problem {
   int longest_option;
   int32_t max_option_cost;
 
+  miniexact_preprocess_stats preprocess;
+  miniexact_stats stats;
+
   void* algorithm_userdata;
   miniexact_config* cfg;
+
+  // Set if the problem was loaded from a binary file. Arrays may point into
+  // this copy-on-write mapping, they are copied out when grown.
+  void* mapped;
+  size_t mapped_size;
+
+  // Set once the problem was compacted. Arrays may point into this single
+  // allocation, they are copied out when grown.
+  void* arena;
+  size_t arena_size;
+
+  // Set if this problem is explored by a worker of a parallel search.
+  miniexact_parallel_worker* worker;
+
+  // Set if the search writes checkpoints or replays one.
+  miniexact_checkpoint* checkpoint;
+
+  // Set if the search records a per-level profile.
+  miniexact_profile* profile;
+
+  // Set if the search only follows one random path to estimate the tree.
+  miniexact_estimate* estimate;
+
+  // Set if the search stops after some time, nodes or memory.
+  miniexact_budget* budget;
+
+  // Set if the search can be cancelled from the outside.
+  miniexact_cancel* cancel;
 } miniexact_problem;
 
 #undef ARR
 
+// Allocation functions used for problems and all of their arrays. Embedders
+// may install their own (e.g. to serve many small problems from a pool). The
+// allocator is global and must only be changed while no problem exists.
+typedef struct miniexact_allocator {
+  void* (*malloc)(size_t size, void* userdata);
+  void* (*realloc)(void* ptr, size_t size, void* userdata);
+  void (*free)(void* ptr, void* userdata);
+  void* userdata;
+} miniexact_allocator;
+
+// Installs the given allocator, or restores the C library one if NULL.
+void
+miniexact_set_allocator(const miniexact_allocator* allocator);
+
+void*
+miniexact_malloc(size_t size);
+
+void*
+miniexact_realloc(void* ptr, size_t size);
+
+void
+miniexact_free(void* ptr);
+
+char*
+miniexact_strdup(const char* str);
+
+// Grows or shrinks an array of p. Arrays inside the arena or the mapped binary
+// file are copied into a fresh allocation instead of being reallocated.
+void*
+miniexact_problem_realloc(miniexact_problem* p,
+                          void* ptr,
+                          size_t old_size,
+                          size_t new_size);
+
+// Reserves room for the given number of items, nodes and colors, so that
+// parsing a problem of known size does not have to grow arrays repeatedly.
+void
+miniexact_problem_reserve(miniexact_problem* p,
+                          size_t items,
+                          size_t nodes,
+                          size_t colors);
+
+// Moves all arrays that are fixed once the options are known, including the
+// names, into one right-sized arena allocation. Called after end_options.
+void
+miniexact_problem_compact(miniexact_problem* p);
+
 int
 miniexact_search_for_name(const char* needle,
                     const miniexact_name* names,
@@ -153,12 +395,23 @@ miniexact_has_item(miniexact_link needle, miniexact_link* list, size_t len);
 miniexact_problem*
 miniexact_problem_allocate(void);
 
+/** @brief Deep copy of a problem that is not currently being searched.
+ *
+ * The copy owns its own link arrays and names, so it can be searched
+ * independently (e.g. by another thread). Algorithm userdata is not copied.
+ */
+miniexact_problem*
+miniexact_problem_clone(const miniexact_problem* o);
+
 void
 miniexact_problem_free_inner(miniexact_problem* p, miniexact_algorithm* a);
 
 void
 miniexact_problem_free(miniexact_problem* p, miniexact_algorithm* a);
 
+// Looks up names inserted by miniexact_insert_ident_as_name (or colors inserted
+// by miniexact_color_from_ident_or_insert) through a hash index. Returns -1 if
+// the name is unknown.
 miniexact_link
 miniexact_item_from_ident(miniexact_problem* p, const char* ident);
 
@@ -25,11 +25,19 @@ extern "C" {
 #define NAME(n) p->name[n]
 #define LLINK(n) p->llink[n]
 #define RLINK(n) p->rlink[n]
+#ifdef MINIEXACT_INTERLEAVED_NODES
+#define ULINK(n) p->node[n].ulink
+#define DLINK(n) p->node[n].dlink
+#define COLOR(n) p->node[n].color
+#define LEN(n) p->node[n].len
+#define TOP(n) p->node[n].top
+#else
 #define ULINK(n) p->ulink[n]
 #define DLINK(n) p->dlink[n]
 #define COLOR(n) p->color[n]
 #define LEN(n) p->len[n]
 #define TOP(n) p->top[n]
+#endif
 #define FT(l) p->ft[l]
 #define SLACK(l) p->slack[l]
 #define BOUND(l) p->bound[l]
@@ -37,6 +45,8 @@ extern "C" {
 #define COST(l) p->cost[l]
 #define THO(l) p->tho[l]
 #define TH(l) p->th[l]
+#define BUCKET_NEXT(n) p->bucket_next[n]
+#define BUCKET_PREV(n) p->bucket_prev[n]
 
 #include "miniexact.h"
 
@@ -44,6 +54,13 @@ extern "C" {
 #include <stdio.h>
 #include <stdlib.h>
 
+inline static void
+miniexact_bucket_remove(miniexact_problem*, miniexact_link);
+inline static void
+miniexact_bucket_insert(miniexact_problem*, miniexact_link);
+inline static void
+miniexact_bucket_update(miniexact_problem*, miniexact_link);
+
 inline static void
 miniexact_cover(miniexact_problem*, miniexact_link);
 inline static void
@@ -99,6 +116,37 @@ miniexact_untweak_prime(miniexact_problem* p, miniexact_link l);
 inline static void
 miniexact_unhide_prime_dollar(miniexact_problem* p, miniexact_link p_);
 
+// Only primary items are bucketed, and only if the bucket heuristic is used.
+#define BUCKETED(X) (p->bucket_next && (X) <= p->N_1)
+#define BUCKET_REMOVE(I)         \
+  do {                           \
+    if(BUCKETED(I))              \
+      miniexact_bucket_remove(p, I); \
+  } while(false)
+#define BUCKET_INSERT(I)         \
+  do {                           \
+    if(BUCKETED(I))              \
+      miniexact_bucket_insert(p, I); \
+  } while(false)
+#define BUCKET_UPDATE(X)         \
+  do {                           \
+    if(BUCKETED(X))              \
+      miniexact_bucket_update(p, X); \
+  } while(false)
+
+// Counters of miniexact_stats, only maintained if built with MINIEXACT_STATS.
+#ifdef MINIEXACT_STATS
+#define STAT_NODE() (++p->stats.nodes)
+#define STAT_UPDATES(N) (p->stats.updates += (N))
+#define STAT_MEMS(N) (p->stats.mems += (N))
+#define STAT_SCANS(N) (p->stats.choose_scans += (N))
+#else
+#define STAT_NODE() ((void)0)
+#define STAT_UPDATES(N) ((void)0)
+#define STAT_MEMS(N) ((void)0)
+#define STAT_SCANS(N) ((void)0)
+#endif
+
 #define COVER(I) miniexact_cover(p, I)
 #define UNCOVER(I) miniexact_uncover(p, I)
 #define HIDE(P) miniexact_hide(p, P)
@@ -142,16 +190,49 @@ miniexact_unhide_prime_dollar(miniexact_problem* p, miniexact_link p_);
 #define MONUS(X, Y) MAX(X - Y, 0)
 #define THETA(P) MONUS(LEN(P) + 1, MONUS(BOUND(P), SLACK(P)))
 
+inline static void
+miniexact_bucket_remove(miniexact_problem* p, miniexact_link i) {
+  miniexact_link b = BUCKET_PREV(i), n = BUCKET_NEXT(i);
+  BUCKET_NEXT(b) = n;
+  BUCKET_PREV(n) = b;
+  BUCKET_PREV(i) = -1;
+}
+
+inline static void
+miniexact_bucket_insert(miniexact_problem* p, miniexact_link i) {
+  miniexact_link h = p->bucket_head + LEN(i);
+  assert((size_t)h < p->bucket_next_size);
+  miniexact_link n = BUCKET_NEXT(h);
+  BUCKET_NEXT(h) = i;
+  BUCKET_PREV(i) = h;
+  BUCKET_NEXT(i) = n;
+  BUCKET_PREV(n) = i;
+  if(LEN(i) < p->bucket_min)
+    p->bucket_min = LEN(i);
+}
+
+// Moves x into the bucket of its changed LEN, unless x is covered.
+inline static void
+miniexact_bucket_update(miniexact_problem* p, miniexact_link x) {
+  if(BUCKET_PREV(x) < 0)
+    return;
+  miniexact_bucket_remove(p, x);
+  miniexact_bucket_insert(p, x);
+}
+
 inline static void
 miniexact_cover(miniexact_problem* p, miniexact_link i) {
   miniexact_link p_ = DLINK(i);
   while(p_ != i) {
     HIDE(p_);
     p_ = DLINK(p_);
+    STAT_MEMS(1);
   }
   miniexact_link l = LLINK(i), r = RLINK(i);
   RLINK(l) = r;
   LLINK(r) = l;
+  STAT_MEMS(3);
+  BUCKET_REMOVE(i);
 }
 
 inline static void
@@ -160,10 +241,13 @@ miniexact_cover_prime(miniexact_problem* p, miniexact_link i) {
   while(p_ != i) {
     HIDE_PRIME(p_);
     p_ = DLINK(p_);
+    STAT_MEMS(1);
   }
   miniexact_link l = LLINK(i), r = RLINK(i);
   RLINK(l) = r;
   LLINK(r) = l;
+  STAT_MEMS(3);
+  BUCKET_REMOVE(i);
 }
 
 inline static void
@@ -174,10 +258,13 @@ miniexact_cover_prime_threshold(miniexact_problem* p,
   while(p_ != i && COST(p_) < t) {
     HIDE_PRIME(p_);
     p_ = DLINK(p_);
+    STAT_MEMS(1);
   }
   miniexact_link l = LLINK(i), r = RLINK(i);
   RLINK(l) = r;
   LLINK(r) = l;
+  STAT_MEMS(3);
+  BUCKET_REMOVE(i);
 }
 
 inline static void
@@ -186,10 +273,13 @@ miniexact_uncover(miniexact_problem* p, miniexact_link i) {
   miniexact_link r = RLINK(i);
   RLINK(l) = i;
   LLINK(r) = i;
+  STAT_MEMS(3);
+  BUCKET_INSERT(i);
   miniexact_link p_ = ULINK(i);
   while(p_ != i) {
     UNHIDE(p_);
     p_ = ULINK(p_);
+    STAT_MEMS(1);
   }
 }
 
@@ -199,10 +289,13 @@ miniexact_uncover_prime(miniexact_problem* p, miniexact_link i) {
   miniexact_link r = RLINK(i);
   RLINK(l) = i;
   LLINK(r) = i;
+  STAT_MEMS(3);
+  BUCKET_INSERT(i);
   miniexact_link p_ = ULINK(i);
   while(p_ != i) {
     UNHIDE_PRIME(p_);
     p_ = ULINK(p_);
+    STAT_MEMS(1);
   }
 }
 
@@ -214,10 +307,13 @@ miniexact_uncover_prime_threshold(miniexact_problem* p,
   miniexact_link r = RLINK(i);
   RLINK(l) = i;
   LLINK(r) = i;
+  STAT_MEMS(3);
+  BUCKET_INSERT(i);
   miniexact_link p_ = ULINK(i);
   while(p_ != i && COST(p_) < t) {
     UNHIDE_PRIME_DOLLAR(p_);
     p_ = DLINK(p_);
+    STAT_MEMS(1);
   }
 }
 
@@ -226,10 +322,11 @@ miniexact_hide(miniexact_problem* p, miniexact_link p_) {
   miniexact_link q = p_ + 1;
   while(q != p_) {
     assert(q >= 0);
-    assert(((size_t)q) < p->top_size);
+    assert(((size_t)q) < MINIEXACT_NODES_SIZE(p));
     miniexact_link x = TOP(q);
     miniexact_link u = ULINK(q);
     miniexact_link d = DLINK(q);
+    STAT_MEMS(1);
 
     assert(x != 0);
 
@@ -239,6 +336,9 @@ miniexact_hide(miniexact_problem* p, miniexact_link p_) {
       DLINK(u) = d;
       ULINK(d) = u;
       LEN(x) = LEN(x) - 1;
+      STAT_MEMS(3);
+      STAT_UPDATES(1);
+      BUCKET_UPDATE(x);
       q = q + 1;
     }
   }
@@ -251,12 +351,16 @@ miniexact_unhide(miniexact_problem* p, miniexact_link p_) {
     miniexact_link x = TOP(q);
     miniexact_link u = ULINK(q);
     miniexact_link d = DLINK(q);
+    STAT_MEMS(1);
     if(x <= 0) {
       q = d; /* q was a spacer */
     } else {
       DLINK(u) = q;
       ULINK(d) = q;
       LEN(x) = LEN(x) + 1;
+      STAT_MEMS(3);
+      STAT_UPDATES(1);
+      BUCKET_UPDATE(x);
       q = q - 1;
     }
   }
@@ -269,6 +373,7 @@ miniexact_hide_prime(miniexact_problem* p, miniexact_link p_) {
     miniexact_link x = TOP(q);
     miniexact_link u = ULINK(q);
     miniexact_link d = DLINK(q);
+    STAT_MEMS(1);
 
     if(x <= 0) {
       q = u; /* q was a spacer */
@@ -278,6 +383,9 @@ miniexact_hide_prime(miniexact_problem* p, miniexact_link p_) {
       DLINK(u) = d;
       ULINK(d) = u;
       LEN(x) = LEN(x) - 1;
+      STAT_MEMS(3);
+      STAT_UPDATES(1);
+      BUCKET_UPDATE(x);
       q = q + 1;
     }
   }
@@ -290,6 +398,7 @@ miniexact_unhide_prime(miniexact_problem* p, miniexact_link p_) {
     miniexact_link x = TOP(q);
     miniexact_link u = ULINK(q);
     miniexact_link d = DLINK(q);
+    STAT_MEMS(1);
     if(x <= 0) {
       q = d; /* q was a spacer */
     } else if(COLOR(q) < 0) {
@@ -298,6 +407,9 @@ miniexact_unhide_prime(miniexact_problem* p, miniexact_link p_) {
       DLINK(u) = q;
       ULINK(d) = q;
       LEN(x) = LEN(x) + 1;
+      STAT_MEMS(3);
+      STAT_UPDATES(1);
+      BUCKET_UPDATE(x);
       q = q - 1;
     }
   }
@@ -310,6 +422,7 @@ miniexact_unhide_prime_dollar(miniexact_problem* p, miniexact_link p_) {
     miniexact_link x = TOP(q);
     miniexact_link u = ULINK(q);
     miniexact_link d = DLINK(q);
+    STAT_MEMS(1);
     if(x <= 0) {
       q = d; /* q was a spacer */
     } else if(COLOR(q) < 0) {
@@ -318,6 +431,9 @@ miniexact_unhide_prime_dollar(miniexact_problem* p, miniexact_link p_) {
       DLINK(u) = q;
       ULINK(d) = q;
       LEN(x) = LEN(x) + 1;
+      STAT_MEMS(3);
+      STAT_UPDATES(1);
+      BUCKET_UPDATE(x);
       q = q - 1;
     }
   }
@@ -367,13 +483,16 @@ miniexact_purify(miniexact_problem* p, miniexact_link p_) {
   miniexact_link i = TOP(p_);
   // Inserted according to err4f5 (Errata)
   COLOR(i) = c;
+  STAT_MEMS(2);
   miniexact_link q = DLINK(i);
   while(q != i) {
-    if(COLOR(q) == c)
+    if(COLOR(q) == c) {
       COLOR(q) = -1;
-    else
+      STAT_UPDATES(1);
+    } else
       HIDE_PRIME(q);
     q = DLINK(q);
+    STAT_MEMS(1);
   }
 }
 
@@ -383,25 +502,31 @@ miniexact_purify_threshold(miniexact_problem* p, miniexact_link p_, int32_t t) {
   miniexact_link i = TOP(p_);
   // Inserted according to err4f5 (Errata)
   COLOR(i) = c;
+  STAT_MEMS(2);
   miniexact_link q = DLINK(i);
   while(q != i && COST(q) < t) {
-    if(COLOR(q) == c)
+    if(COLOR(q) == c) {
       COLOR(q) = -1;
-    else
+      STAT_UPDATES(1);
+    } else
       HIDE_PRIME(q);
     q = DLINK(q);
+    STAT_MEMS(1);
   }
 }
 
 inline static void
 miniexact_unpurify(miniexact_problem* p, miniexact_link p_) {
   miniexact_link c = COLOR(p_), i = TOP(p_), q = ULINK(i);
+  STAT_MEMS(2);
   while(q != i) {
-    if(COLOR(q) < 0)
+    if(COLOR(q) < 0) {
       COLOR(q) = c;
-    else
+      STAT_UPDATES(1);
+    } else
       UNHIDE_PRIME(q);
     q = ULINK(q);
+    STAT_MEMS(1);
   }
 }
 
@@ -410,12 +535,15 @@ miniexact_unpurify_threshold(miniexact_problem* p,
                              miniexact_link p_,
                              int32_t t) {
   miniexact_link c = COLOR(p_), i = TOP(p_), q = ULINK(i);
+  STAT_MEMS(2);
   while(q != i && COST(q) < t) {
-    if(COLOR(q) < 0)
+    if(COLOR(q) < 0) {
       COLOR(q) = c;
-    else
+      STAT_UPDATES(1);
+    } else
       UNHIDE_PRIME_DOLLAR(q);
     q = DLINK(q);
+    STAT_MEMS(1);
   }
 }
 
@@ -428,6 +556,8 @@ miniexact_tweak(miniexact_problem* p, miniexact_link x, miniexact_link p_) {
   DLINK(p_) = d;
   ULINK(d) = p_;
   LEN(p_) = LEN(p_) - 1;
+  STAT_MEMS(3);
+  STAT_UPDATES(1);
 }
 
 inline static void
@@ -437,10 +567,13 @@ miniexact_untweak(miniexact_problem* p, miniexact_link l) {
   miniexact_link x = a, y = p_;
   miniexact_link z = DLINK(p_);
   DLINK(p_) = x;
+  STAT_MEMS(2);
   miniexact_link k = 0;
   while(x != z) {
     ULINK(x) = y;
     k = k + 1;
+    STAT_MEMS(1);
+    STAT_UPDATES(1);
     UNHIDE_PRIME(x);
     y = x;
     x = DLINK(x);
@@ -459,6 +592,8 @@ miniexact_tweak_prime(miniexact_problem* p,
   DLINK(p_) = d;
   ULINK(d) = p_;
   LEN(p_) = LEN(p_) - 1;
+  STAT_MEMS(3);
+  STAT_UPDATES(1);
 }
 
 inline static void
@@ -468,10 +603,13 @@ miniexact_untweak_prime(miniexact_problem* p, miniexact_link l) {
   miniexact_link x = a, y = p_;
   miniexact_link z = DLINK(p_);
   DLINK(p_) = x;
+  STAT_MEMS(2);
   miniexact_link k = 0;
   while(x != z) {
     ULINK(x) = y;
     k = k + 1;
+    STAT_MEMS(1);
+    STAT_UPDATES(1);
     y = x;
     x = DLINK(x);
   }
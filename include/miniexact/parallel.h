@@ -0,0 +1,54 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_PARALLEL_H
+#define MINIEXACT_PARALLEL_H
+
+// Parallel enumeration for Algorithms X and C.
+//
+// Every worker owns a clone of the problem and walks the same shallow part of
+// the search tree. At the split level, the subtrees below are numbered in the
+// order they are encountered. Idle workers take the next unexplored subtree by
+// drawing a ticket from a shared counter and skip over all subtrees that
+// belong to somebody else. As all workers walk the shallow tree in the same
+// deterministic order, every subtree is explored exactly once.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "miniexact.h"
+
+// Called by the engines before descending into option x[l]. Returns false if
+// the subtree below belongs to another worker and has to be skipped.
+bool
+miniexact_parallel_claim(miniexact_parallel_worker* w, miniexact_link l);
+
+// Enumerate all solutions of p using cfg->threads workers, printing them to
+// one merged output stream. Only Algorithms X and C support the split.
+int
+miniexact_parallel_solve_and_print_solutions(miniexact_algorithm* a,
+                                             miniexact_problem* p,
+                                             miniexact_config* cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_PREPROCESS_H
+#define MINIEXACT_PREPROCESS_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct miniexact_problem miniexact_problem;
+
+// Preprocessing in the spirit of Knuth's DLX-PRE, run once all options are
+// known and before the matrix is compacted.
+//
+// An option is blocked if committing it leaves some other primary item
+// without any option. Blocked options can never be part of a solution, so
+// they are removed from the matrix for good. Secondary items that can no
+// longer cause a conflict (at most one option, or the same color in all of
+// them) are unlinked from the secondary items, but stay in their options so
+// that solutions are printed as before. Removing options may block others,
+// so both steps are repeated until nothing changes.
+//
+// Afterwards, the nodes of the remaining options are moved together. Spacers
+// keep their original option index, so solutions still refer to the options
+// of the input. option_count is kept as an upper bound of these indices.
+//
+// If colors is false, colors are ignored like in Algorithm X. Problems with
+// multiplicities (Algorithm M) or a primary item without options are left
+// unchanged. The result is stored in p->preprocess.
+void
+miniexact_preprocess(miniexact_problem* p, bool colors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef MINIEXACT_PROFILE_H
+#define MINIEXACT_PROFILE_H
+
+// Per-level profile of a search with Algorithms X, C, M and C$.
+//
+// For every level l of the search tree, the profile records how many nodes
+// were entered, the LEN of the items chosen there, how often the search
+// backtracked from it and the wall-clock time spent at exactly this level.
+// The ratio of nodes on consecutive levels is the branching factor, so the
+// table shows where the tree explodes.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "miniexact.h"
+
+typedef struct miniexact_profile_level {
+  uint64_t nodes;
+  uint64_t choices;
+  uint64_t len_sum;
+  uint64_t backtracks;
+  double time;
+} miniexact_profile_level;
+
+typedef struct miniexact_profile {
+  miniexact_profile_level* levels;
+  size_t levels_size;
+  size_t levels_capacity;
+
+  // Level of the search when the clock was last read.
+  miniexact_link level;
+  double last;
+
+  // Set (e.g. from a signal handler) to print the profile so far to stderr
+  // on the next change of the level.
+  volatile sig_atomic_t dump_requested;
+} miniexact_profile;
+
+// Starts profiling the search of p from its root.
+void
+miniexact_profile_init(miniexact_profile* pr, miniexact_problem* p);
+
+// Called by the engines after choosing item i on level l.
+void
+miniexact_profile_choose(miniexact_profile* pr, miniexact_problem* p);
+
+// Called by the engines after descending to level l.
+void
+miniexact_profile_enter(miniexact_profile* pr, miniexact_problem* p);
+
+// Called by the engines before backtracking from level l.
+void
+miniexact_profile_leave(miniexact_profile* pr, miniexact_problem* p);
+
+// Prints an aligned table of all levels.
+void
+miniexact_profile_print(miniexact_profile* pr, FILE* f);
+
+// Prints all levels as CSV, with a header line.
+void
+miniexact_profile_print_csv(miniexact_profile* pr, FILE* f);
+
+// Uninstalls the profile from p and releases its levels.
+void
+miniexact_profile_finish(miniexact_profile* pr, miniexact_problem* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
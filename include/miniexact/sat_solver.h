@@ -18,6 +18,7 @@
 #ifndef MINIEXACT_SAT_SOLVER
 #define MINIEXACT_SAT_SOLVER
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <sys/types.h>
 
@@ -25,14 +26,36 @@
 extern "C" {
 #endif
 
-typedef struct miniexact_sat_solver {
-  int infd[2];
-  int outfd[2];
-  FILE* infd_handle;
-  FILE* outfd_handle;
+// One running solver. The parent keeps the write end of its stdin and the read
+// end of its stdout.
+typedef struct miniexact_sat_solver_process {
+  int in;
+  int out;
   pid_t pid;
+  size_t portfolio_id;
+
+  // Everything printed so far, only the winner's output is parsed.
+  char* output;
+  size_t output_size;
+  size_t output_len;
+} miniexact_sat_solver_process;
+
+typedef struct miniexact_sat_solver {
+  // In portfolio mode, every solver gets the same CNF and the first one that
+  // answers SAT or UNSAT wins, the others are killed.
+  miniexact_sat_solver_process* processes;
+  size_t processes_count;
+
   unsigned int variables, clauses;
   char* assignments;
+
+  // Clauses are formatted into this buffer and written to the solver whenever
+  // it is full. In one-pass mode, the header is only known after the last
+  // clause, so the buffer keeps the whole CNF until solving.
+  char* buffer;
+  size_t buffer_size;
+  size_t buffer_len;
+  bool one_pass;
 } miniexact_sat_solver;
 
 void
@@ -43,11 +66,24 @@ miniexact_sat_solver_init(miniexact_sat_solver* solver,
                     char* const argv[],
                     char* envp[]);
 
+// Starts the solver without knowing the header. Clauses are counted while
+// adding them, variables is raised to the largest variable added.
+void
+miniexact_sat_solver_init_one_pass(miniexact_sat_solver* solver,
+                                   unsigned int variables,
+                                   char* binary,
+                                   char* const argv[],
+                                   char* envp[]);
+
 void
 miniexact_sat_solver_find_and_init(miniexact_sat_solver* solver,
                              unsigned int variables,
                              unsigned int clauses);
 
+void
+miniexact_sat_solver_find_and_init_one_pass(miniexact_sat_solver* solver,
+                                            unsigned int variables);
+
 void
 miniexact_sat_solver_destroy(miniexact_sat_solver* solver);
 
@@ -63,6 +99,21 @@ miniexact_sat_solver_ternary(miniexact_sat_solver* solver, int a, int b, int c);
 int
 miniexact_sat_solver_solve(miniexact_sat_solver* solver);
 
+// Races all solvers of the comma separated list (names in $PATH or paths)
+// against each other. An empty list selects all known solvers found in $PATH,
+// NULL only the first of them (the default). Solvers and statistics of an
+// earlier list are dropped.
+void
+miniexact_sat_solver_set_portfolio(const char* list);
+
+bool
+miniexact_sat_solver_portfolio_configured(void);
+
+// Prints how often every solver of the portfolio was started and how often and
+// how fast it answered first.
+void
+miniexact_sat_solver_print_portfolio_stats(FILE* f);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,7 @@ extern "C" {
 #include <stdint.h>
 
 struct miniexact_problem;
+struct miniexact_stats;
 struct miniexacts;
 
 typedef void (*miniexacts_solution_iterator)(struct miniexacts*,
@@ -41,6 +42,22 @@ typedef void (*miniexacts_solution_iterator)(struct miniexacts*,
                                              unsigned int items_count,
                                              void* userdata);
 
+// Called with a batch of count solutions by miniexacts_enumerate. Solution k
+// consists of the option indices options[offsets[k]] up to (excluding)
+// options[offsets[k + 1]]. The arrays are only valid during the call.
+// Returning 0 stops the enumeration.
+typedef int (*miniexacts_solutions_callback)(struct miniexacts*,
+                                             const int32_t* options,
+                                             const uint32_t* offsets,
+                                             unsigned int count,
+                                             void* userdata);
+
+// Called every interval nodes of miniexacts_solve. Returning 0 cancels the
+// search.
+typedef int (*miniexacts_progress_callback)(struct miniexacts*,
+                                            uint64_t nodes,
+                                            void* userdata);
+
 struct miniexacts*
 miniexacts_init_x();
 
@@ -86,9 +103,39 @@ miniexacts_add(struct miniexacts* h,
                int32_t color,
                uint32_t cost);
 
+// Returns 10 for the next solution, 20 if there are no more and 40 if the
+// search was cancelled. After cancellation, the next call starts the search
+// again from the first solution.
 int
 miniexacts_solve(struct miniexacts* h);
 
+// Enumerates all remaining solutions inside the library and hands them to it in
+// batches of up to batch_size solutions (1024 if 0). If it returns 0, the
+// enumeration stops after that batch and continues with the next solution on
+// the next call of miniexacts_solve or miniexacts_enumerate. Returns 10 if it
+// stopped the enumeration, 20 once the search is exhausted and 40 if it was
+// cancelled, and sets reported_count (if not NULL) to the number of solutions
+// passed to it.
+int
+miniexacts_enumerate(struct miniexacts* h,
+                     miniexacts_solutions_callback it,
+                     unsigned int batch_size,
+                     void* userdata,
+                     long long* reported_count);
+
+// Requests the running (or next) miniexacts_solve to stop and return 40. Safe
+// to call from any thread, it is noticed within the progress interval.
+void
+miniexacts_cancel(struct miniexacts* h);
+
+// Calls progress every interval nodes (4096 if 0) while solving. NULL removes
+// the callback.
+void
+miniexacts_set_progress(struct miniexacts* h,
+                        miniexacts_progress_callback progress,
+                        unsigned int interval,
+                        void* userdata);
+
 void
 miniexacts_solution(struct miniexacts* h,
                     miniexacts_solution_iterator it,
@@ -103,6 +150,11 @@ miniexacts_extract_solution(struct miniexacts* h, int32_t* arr);
 miniexact_problem*
 miniexacts_problem(struct miniexacts* h);
 
+// Times and search counters accumulated over all calls to miniexacts_solve.
+// The counters stay 0 unless the library was built with MINIEXACT_STATS.
+const struct miniexact_stats*
+miniexacts_stats(struct miniexacts* h);
+
 void
 miniexacts_free(struct miniexacts* h);
 
@@ -15,6 +15,12 @@ class miniexacts_wrapper {
   bool solution_valid_ = false;
   int last_res_ = 0;
 
+  public:
+  using progress_cb_func = std::function<bool(uint64_t)>;
+
+  private:
+  progress_cb_func progress_;
+
   void extract_solution() {
     if(solution_valid_)
       return;
@@ -94,6 +100,47 @@ class miniexacts_wrapper {
       &cb);
   }
 
+  // Runs the enumeration inside the library, handing over batches of solutions
+  // as in miniexacts_enumerate. Returning false stops after the batch. Returns
+  // the number of solutions passed to cb, cancelled() tells if it was stopped
+  // by cancel().
+  using solutions_cb_func = std::function<
+    bool(const int32_t* options, const uint32_t* offsets, unsigned int count)>;
+  long long enumerate(solutions_cb_func cb, unsigned int batch_size = 0) {
+    solution_valid_ = false;
+    long long count = 0;
+    last_res_ = miniexacts_enumerate(
+      h_.get(),
+      [](miniexacts* h,
+         const int32_t* options,
+         const uint32_t* offsets,
+         unsigned int count,
+         void* userdata) -> int {
+        solutions_cb_func* cb = reinterpret_cast<solutions_cb_func*>(userdata);
+        return (*cb)(options, offsets, count);
+      },
+      batch_size,
+      &cb,
+      &count);
+    return count;
+  }
+
+  // Up to max_count further solutions as lists of option indices, empty once
+  // all were found. Needs only one call per batch from scripting languages.
+  std::vector<std::vector<int32_t>> next_solutions(
+    unsigned int max_count = 1024) {
+    std::vector<std::vector<int32_t>> solutions;
+    enumerate(
+      [&solutions, max_count](
+        const int32_t* options, const uint32_t* offsets, unsigned int count) {
+        for(unsigned int k = 0; k < count; ++k)
+          solutions.emplace_back(options + offsets[k], options + offsets[k + 1]);
+        return solutions.size() < max_count;
+      },
+      max_count);
+    return solutions;
+  }
+
   const std::vector<int32_t>& selected_options() {
     extract_solution();
     return selected_options_;
@@ -126,7 +173,24 @@ class miniexacts_wrapper {
     std::cout << std::endl;
   }
 
+  // Safe to call from another thread while solve() runs.
+  void cancel() { miniexacts_cancel(h_.get()); }
+  bool cancelled() const { return last_res_ == 40; }
+
+  // Called every interval nodes while solving, returning false cancels.
+  void progress(progress_cb_func cb, unsigned int interval = 0) {
+    progress_ = std::move(cb);
+    miniexacts_progress_callback it = nullptr;
+    if(progress_)
+      it = [](miniexacts* h, uint64_t nodes, void* userdata) -> int {
+        progress_cb_func* cb = reinterpret_cast<progress_cb_func*>(userdata);
+        return (*cb)(nodes);
+      };
+    miniexacts_set_progress(h_.get(), it, interval, &progress_);
+  }
+
   miniexact_problem* problem() { return miniexacts_problem(h_.get()); }
+  const miniexact_stats& stats() { return *miniexacts_stats(h_.get()); }
 };
 
 using miniexacts_x = miniexacts_wrapper<&miniexacts_init_x>;
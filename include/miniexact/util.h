@@ -25,6 +25,7 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 // Small utility function to extract the sign out of an integer. Positive is
 // true.
@@ -40,6 +41,20 @@ struct miniexact_algorithm;
 struct miniexact_problem;
 struct miniexact_config;
 
+// Print the solution currently held in p according to the output switches in
+// cfg. Returns true if something was printed that counts as a solution.
+bool
+miniexact_print_solution(struct miniexact_problem* p,
+                         struct miniexact_config* cfg);
+
+// Seconds from a monotonic clock, for measuring durations.
+double
+miniexact_seconds(void);
+
+// Print the times and search counters of p (see miniexact_stats).
+void
+miniexact_print_stats(struct miniexact_problem* p, FILE* f);
+
 // Utility function to solve the given problem and print solutions. Both used in
 // the web version and the CLI version of miniexactsolve.
 int
@@ -47,7 +62,9 @@ miniexact_solve_problem_and_print_solutions(struct miniexact_algorithm* a,
                                       struct miniexact_problem* p,
                                       struct miniexact_config* cfg);
 
-// Utility function to solve a given problem and return if there are solutions.
+// Utility function to solve a given problem and return if there are solutions:
+// 10 for the next solution, 20 if there is none, MINIEXACT_CANCELLED or
+// MINIEXACT_BUDGET_EXHAUSTED if the search was stopped before.
 int
 miniexact_solve_problem(struct miniexact_algorithm* a, struct miniexact_problem* p);
 
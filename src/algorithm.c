@@ -19,10 +19,14 @@
 #include <miniexact/algorithm.h>
 #include <miniexact/algorithm_c.h>
 #include <miniexact/algorithm_c_dollar.h>
+#include <miniexact/algorithm_dc.h>
 #include <miniexact/algorithm_knuth_cnf.h>
 #include <miniexact/algorithm_m.h>
 #include <miniexact/algorithm_x.h>
+#include <miniexact/algorithm_x_bitset.h>
+#include <miniexact/algorithm_z.h>
 #include <miniexact/ops.h>
+#include <miniexact/preprocess.h>
 #include <stdint.h>
 
 static inline const char*
@@ -54,8 +58,8 @@ define_primary_item(miniexact_algorithm* a,
   ++p->primary_item_count;
 
   // Always track them with as the base-case w.r.t. primary items.
-  MINIEXACT_ARR_PLUS1(slack)
-  MINIEXACT_ARR_PLUS1(bound)
+  MINIEXACT_ARR_HASN(slack, p->i + 1)
+  MINIEXACT_ARR_HASN(bound, p->i + 1)
   SLACK(p->i) = 1;
   BOUND(p->i) = 0;
 
@@ -82,8 +86,8 @@ define_primary_item_with_range(miniexact_algorithm* a,
 
   ++p->primary_item_count;
 
-  MINIEXACT_ARR_PLUS1(slack)
-  MINIEXACT_ARR_PLUS1(bound)
+  MINIEXACT_ARR_HASN(slack, p->i + 1)
+  MINIEXACT_ARR_HASN(bound, p->i + 1)
 
   SLACK(p->i) = v - u;
   BOUND(p->i) = v;
@@ -115,6 +119,9 @@ prepare_options(miniexact_algorithm* a, miniexact_problem* p) {
   p->N = p->i;
   if(p->N_1 < 0)
     p->N_1 = p->N;
+  // The head of the secondary items must survive compaction and cloning.
+  MINIEXACT_ARR_HASN(llink, p->N + 2)
+  MINIEXACT_ARR_HASN(rlink, p->N + 2)
   LLINK(p->N + 1) = p->N;
   RLINK(p->N) = p->N + 1;
   LLINK(p->N_1 + 1) = p->N + 1;
@@ -123,10 +130,9 @@ prepare_options(miniexact_algorithm* a, miniexact_problem* p) {
   RLINK(p->N_1) = 0;
 
   // Step N3
-  MINIEXACT_ARR_PLUSN(len, p->N + 2);
-  MINIEXACT_ARR_PLUSN(ulink, p->N + 2);
-  MINIEXACT_ARR_PLUSN(dlink, p->N + 2);
-  MINIEXACT_ARR_PLUSN(color, p->N + 2);
+  MINIEXACT_NODES_PLUSN(p->N + 2)
+  // Costs are indexed by node, so they have to cover the header nodes too.
+  MINIEXACT_ARR_PLUSN(cost, p->N + 2)
 
   // Normalize the don't cares
   ULINK(p->N + 1) = 0;
@@ -161,10 +167,7 @@ add_item_with_color(miniexact_algorithm* a,
   if(ij < 1)
     return "Invalid ij given for add_item!";
 
-  MINIEXACT_ARR_PLUS1(len)
-  MINIEXACT_ARR_PLUS1(dlink)
-  MINIEXACT_ARR_PLUS1(ulink)
-  MINIEXACT_ARR_PLUS1(color)
+  MINIEXACT_NODES_PLUSN(1)
   MINIEXACT_ARR_PLUS1(cost)
 
   ++p->j;
@@ -188,10 +191,7 @@ add_item(miniexact_algorithm* a, miniexact_problem* p, miniexact_link ij) {
 
 static const char*
 end_option(miniexact_algorithm* a, miniexact_problem* p, int32_t cost) {
-  MINIEXACT_ARR_PLUS1(len)
-  MINIEXACT_ARR_PLUS1(dlink)
-  MINIEXACT_ARR_PLUS1(ulink)
-  MINIEXACT_ARR_PLUS1(color)
+  MINIEXACT_NODES_PLUSN(1)
   MINIEXACT_ARR_PLUS1(cost)
 
   if(cost < p->max_option_cost) {
@@ -220,7 +220,28 @@ end_option(miniexact_algorithm* a, miniexact_problem* p, int32_t cost) {
 
 static const char*
 end_options(miniexact_algorithm* a, miniexact_problem* p) {
-  DLINK(p->dlink_size - 1) = 0;
+  DLINK(MINIEXACT_NODES_SIZE(p) - 1) = 0;
+  miniexact_problem_compact(p);
+  return NULL;
+}
+
+// Preprocessing runs before compacting, so the arena is right-sized for the
+// reduced matrix.
+static const char*
+end_options_preprocess(miniexact_algorithm* a, miniexact_problem* p) {
+  DLINK(MINIEXACT_NODES_SIZE(p) - 1) = 0;
+  miniexact_preprocess(p, true);
+  miniexact_problem_compact(p);
+  return NULL;
+}
+
+// Algorithm X treats colored secondary items like uncolored ones.
+static const char*
+end_options_preprocess_without_colors(miniexact_algorithm* a,
+                                      miniexact_problem* p) {
+  DLINK(MINIEXACT_NODES_SIZE(p) - 1) = 0;
+  miniexact_preprocess(p, false);
+  miniexact_problem_compact(p);
   return NULL;
 }
 
@@ -235,11 +256,8 @@ miniexact_default_init_problem(miniexact_algorithm* a, miniexact_problem* p) {
   MINIEXACT_ARR_ALLOC(miniexact_link, rlink)
   MINIEXACT_ARR_ALLOC(miniexact_name, name)
   MINIEXACT_ARR_ALLOC(miniexact_name, color_name)
-  MINIEXACT_ARR_ALLOC(miniexact_name, len)
-  MINIEXACT_ARR_ALLOC(miniexact_name, ulink)
-  MINIEXACT_ARR_ALLOC(miniexact_name, dlink)
-  MINIEXACT_ARR_ALLOC(miniexact_name, x)
-  MINIEXACT_ARR_ALLOC(miniexact_color, color)
+  MINIEXACT_NODES_ALLOC()
+  MINIEXACT_ARR_ALLOC(miniexact_link, x)
   MINIEXACT_ARR_ALLOC(miniexact_link, ft)
   MINIEXACT_ARR_ALLOC(miniexact_link, slack)
   MINIEXACT_ARR_ALLOC(miniexact_link, bound)
@@ -274,6 +292,8 @@ miniexact_choose_i_naively(miniexact_algorithm* a,
                            miniexact_problem* p,
                            int32_t t) {
   (void)t;
+  STAT_SCANS(1);
+  STAT_MEMS(1);
   return RLINK(0);
 }
 
@@ -281,6 +301,8 @@ miniexact_link
 miniexact_choose_i_naively_cost(miniexact_algorithm* a,
                                 miniexact_problem* p,
                                 int32_t t) {
+  STAT_SCANS(1);
+  STAT_MEMS(1);
   return RLINK(0);
 }
 
@@ -293,6 +315,8 @@ miniexact_choose_i_mrv(miniexact_algorithm* a,
   miniexact_link p_ = RLINK(0), theta = MINIEXACT_LINK_MAX;
   while(p_ != 0) {
     miniexact_link lambda = LEN(p_);
+    STAT_SCANS(1);
+    STAT_MEMS(1);
     if(lambda < theta) {
       theta = lambda;
       i = p_;
@@ -305,6 +329,58 @@ miniexact_choose_i_mrv(miniexact_algorithm* a,
   return i;
 }
 
+// Sorts all active primary items into buckets by LEN. Afterwards, the buckets
+// are kept up to date by every change of LEN in ops.h.
+static void
+build_buckets(miniexact_problem* p) {
+  miniexact_link max_len = 0;
+  for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i))
+    max_len = MINIEXACT_MAX(max_len, LEN(i));
+
+  p->bucket_head = p->N_1 + 1;
+  size_t size = p->bucket_head + max_len + 1;
+  MINIEXACT_ARR_RESIZE(bucket_next, size)
+  MINIEXACT_ARR_RESIZE(bucket_prev, size)
+  p->bucket_next_size = size;
+  p->bucket_prev_size = size;
+
+  for(miniexact_link i = 0; i < p->bucket_head; ++i)
+    BUCKET_PREV(i) = -1;
+  for(miniexact_link h = p->bucket_head; (size_t)h < size; ++h) {
+    BUCKET_NEXT(h) = h;
+    BUCKET_PREV(h) = h;
+  }
+
+  // Items are pushed to the front, so walking backwards keeps the item order
+  // and ties are broken like in miniexact_choose_i_mrv.
+  p->bucket_min = max_len;
+  for(miniexact_link i = LLINK(0); i != 0; i = LLINK(i))
+    miniexact_bucket_insert(p, i);
+}
+
+miniexact_link
+miniexact_choose_i_mrv_bucket(miniexact_algorithm* a,
+                              miniexact_problem* p,
+                              int32_t t) {
+  (void)t;
+  if(!p->bucket_next)
+    build_buckets(p);
+
+  // bucket_min is a lower bound of the smallest LEN, as it is lowered on every
+  // insert. Raising it here is amortized by the decreases that preceded it.
+  miniexact_link h = p->bucket_head + p->bucket_min;
+  STAT_SCANS(1);
+  STAT_MEMS(1);
+  while(BUCKET_NEXT(h) == h) {
+    ++h;
+    assert((size_t)h < p->bucket_next_size);
+    STAT_SCANS(1);
+    STAT_MEMS(1);
+  }
+  p->bucket_min = h - p->bucket_head;
+  return BUCKET_NEXT(h);
+}
+
 miniexact_link
 miniexact_choose_i_mrv_cost(miniexact_algorithm* a,
                             miniexact_problem* p,
@@ -321,6 +397,8 @@ miniexact_choose_i_mrv_cost(miniexact_algorithm* a,
     miniexact_link s = 0;
     miniexact_link p_ = DLINK(j);
     int32_t c_prime = COST(p_);
+    STAT_SCANS(1);
+    STAT_MEMS(2);
     if(p_ == j || c_prime >= cutoff) {
       return -1;
     } else {
@@ -338,6 +416,7 @@ miniexact_choose_i_mrv_cost(miniexact_algorithm* a,
 	} else {
 	  s = s + 1;
 	  p_ = DLINK(p_);
+	  STAT_MEMS(1);
 	}
       }
       if(s < t || (s == t && c < c_prime)) {
@@ -360,6 +439,8 @@ miniexact_choose_i_mrv_slacker(miniexact_algorithm* a,
   miniexact_link p_ = RLINK(0);
   while(p_ != 0) {
     miniexact_link lambda = THETA(p_);
+    STAT_SCANS(1);
+    STAT_MEMS(1);
     if(lambda < theta || (lambda == theta && SLACK(p_) < SLACK(i)) ||
        (lambda == theta && SLACK(p_) == SLACK(i) && LEN(p_) > LEN(i))) {
       theta = lambda;
@@ -395,12 +476,23 @@ bool
 miniexact_algorithm_from_select(int algorithm_select,
                                 miniexact_algorithm* algorithm) {
   bool success = false;
-  if(algorithm_select & MINIEXACT_ALGORITHM_X) {
-    miniexact_algorithm_x_set(algorithm);
+  // Z is checked first, as the CLI also uses the flag to find out how to count.
+  if(algorithm_select & MINIEXACT_ALGORITHM_Z) {
+    miniexact_algorithm_z_set(algorithm);
+    success = true;
+  } else if(algorithm_select & MINIEXACT_ALGORITHM_X) {
+    // The bitset engine falls back to dancing links for large problems.
+    if(algorithm_select & MINIEXACT_ALGORITHM_BITSET)
+      miniexact_algorithm_x_bitset_set(algorithm);
+    else
+      miniexact_algorithm_x_set(algorithm);
     success = true;
   } else if(algorithm_select & MINIEXACT_ALGORITHM_C) {
     miniexact_algorithm_c_set(algorithm);
     success = true;
+  } else if(algorithm_select & MINIEXACT_ALGORITHM_DC) {
+    miniexact_algorithm_dc_set(algorithm);
+    success = true;
   } else if(algorithm_select & MINIEXACT_ALGORITHM_C_DOLLAR) {
     miniexact_algorithm_c_dollar_set(algorithm);
     success = true;
@@ -417,6 +509,13 @@ miniexact_algorithm_from_select(int algorithm_select,
 #endif
   }
 
+  if(algorithm_select & MINIEXACT_ALGORITHM_PREPROCESS) {
+    if(algorithm_select & (MINIEXACT_ALGORITHM_X | MINIEXACT_ALGORITHM_Z))
+      algorithm->end_options = &end_options_preprocess_without_colors;
+    else
+      algorithm->end_options = &end_options_preprocess;
+  }
+
   if(algorithm_select & MINIEXACT_ALGORITHM_DOLLARS) {
     if(algorithm_select & MINIEXACT_ALGORITHM_NAIVE) {
       algorithm->choose_i = &miniexact_choose_i_naively_cost;
@@ -434,6 +533,12 @@ miniexact_algorithm_from_select(int algorithm_select,
     if(algorithm_select & MINIEXACT_ALGORITHM_MRV) {
       algorithm->choose_i = &miniexact_choose_i_mrv;
     }
+    // Buckets are only kept up to date by the operations of X and C. M also
+    // changes LEN while tweaking, so it keeps scanning.
+    if((algorithm_select & MINIEXACT_ALGORITHM_MRV_BUCKET) &&
+       (algorithm_select & (MINIEXACT_ALGORITHM_X | MINIEXACT_ALGORITHM_C))) {
+      algorithm->choose_i = &miniexact_choose_i_mrv_bucket;
+    }
   }
 
   return success;
@@ -465,6 +570,20 @@ miniexact_algorithm_m_allocate() {
   return a;
 }
 
+miniexact_algorithm*
+miniexact_algorithm_z_allocate() {
+  miniexact_algorithm* a = miniexact_algorithm_allocate();
+  miniexact_algorithm_z_set(a);
+  return a;
+}
+
+miniexact_algorithm*
+miniexact_algorithm_dc_allocate() {
+  miniexact_algorithm* a = miniexact_algorithm_allocate();
+  miniexact_algorithm_dc_set(a);
+  return a;
+}
+
 miniexact_algorithm*
 miniexact_algorithm_c_dollar_allocate() {
   miniexact_algorithm* a = miniexact_algorithm_allocate();
@@ -22,15 +22,22 @@
 
 #include <miniexact/algorithm.h>
 #include <miniexact/algorithm_c.h>
+#include <miniexact/budget.h>
+#include <miniexact/cancel.h>
+#include <miniexact/checkpoint.h>
+#include <miniexact/estimate.h>
 #include <miniexact/ops.h>
+#include <miniexact/profile.h>
+#include <miniexact/parallel.h>
 
 typedef enum c_state { C1, C2, C3, C4, C5, C6, C7, C8 } c_state;
 
 static bool
 compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
-  if(p->x_capacity < p->option_count) {
-    p->x = realloc(p->x, sizeof(miniexact_link) * p->option_count);
-    p->x_capacity = p->option_count;
+  // The deepest level may still try to choose an option for an item that
+  // cannot be covered anymore.
+  if(p->x_capacity < p->option_count + 1) {
+    MINIEXACT_ARR_RESIZE(x, p->option_count + 1)
     p->x_size = 0;
   }
 
@@ -41,14 +48,12 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
     // printf("State: %d i:%d l:%d x[0]:%d\n", p->state, p->i, p->l, p->x[0]);
     switch(p->state) {
       case C1: {
-        miniexact_link i = 0;
-        do {
-          i = RLINK(i);
+        for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i)) {
           if(DLINK(i) == 0 && ULINK(i) == 0) {
             fprintf(stderr, "Some item never occurs in the options!\n");
             return false;
           }
-        } while(RLINK(i) != 0);
+        }
 
         p->l = 0;
         p->state = C2;
@@ -65,6 +70,10 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
         break;
       case C3:
         p->i = a->choose_i(a, p, 0);
+        if(p->profile)
+          miniexact_profile_choose(p->profile, p);
+        if(p->estimate)
+          miniexact_estimate_choose(p->estimate, p, LEN(p->i));
         p->state = C4;
         break;
       case C4:
@@ -77,6 +86,27 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
           p->state = C7;
           break;
         }
+        if(p->cancel && !miniexact_cancel_descend(p->cancel, p)) {
+          // Cancelled, backtrack to the root.
+          p->x[p->l] = DLINK(p->x[p->l]);
+          break;
+        }
+        if(p->worker && !miniexact_parallel_claim(p->worker, p->l)) {
+          // Subtree is explored by another worker.
+          p->x[p->l] = DLINK(p->x[p->l]);
+          break;
+        }
+        if(p->checkpoint &&
+           !miniexact_checkpoint_descend(p->checkpoint, p)) {
+          // Subtree was explored before the checkpoint.
+          p->x[p->l] = DLINK(p->x[p->l]);
+          break;
+        }
+        if(p->estimate && !miniexact_estimate_descend(p->estimate, p)) {
+          // Not on the random path.
+          p->x[p->l] = DLINK(p->x[p->l]);
+          break;
+        }
         p->p = p->x[p->l] + 1;
         while(p->p != p->x[p->l]) {
           miniexact_link j = TOP(p->p);
@@ -87,8 +117,13 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
             p->p = p->p + 1;
           }
         }
+        STAT_NODE();
         p->l = p->l + 1;
+        if(p->profile)
+          miniexact_profile_enter(p->profile, p);
         p->state = C2;
+        if(p->budget && !miniexact_budget_descend(p->budget))
+          return false;// Out of budget, could continue at C2.
         break;
       case C6:
         p->p = p->x[p->l] - 1;
@@ -113,6 +148,10 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
         if(p->l == 0) {
           return false;
         }
+        if(p->profile)
+          miniexact_profile_leave(p->profile, p);
+        if(p->estimate)
+          miniexact_estimate_leave(p->estimate, p);
         p->l = p->l - 1;
         p->state = C6;
         break;
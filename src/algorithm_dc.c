@@ -0,0 +1,366 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <miniexact/algorithm.h>
+#include <miniexact/algorithm_dc.h>
+#include <miniexact/budget.h>
+#include <miniexact/ops.h>
+
+typedef struct dc_saved_size {
+  miniexact_link item;
+  miniexact_link size;
+} dc_saved_size;
+
+typedef struct algorithm_dc {
+  // Per node of the matrix, using the same indices: item (<= 0 for spacers)
+  // and color. loc is the position of the node inside the set of its item,
+  // for spacers it is the first node of the option before, like ULINK.
+  miniexact_link* itm;
+  miniexact_link* clr;
+  miniexact_link* loc;
+
+  // The options of item i are set[start[i]], ..., set[start[i] + size[i] - 1],
+  // each one given by its node in column i.
+  miniexact_link* set;
+  miniexact_link* start;
+  miniexact_link* size;
+
+  // Active items as sparse sets: primary items are item[0], ...,
+  // item[primary_active - 1], secondary items follow from item[N_1] on.
+  miniexact_link* item;
+  miniexact_link* ipos;
+  miniexact_link primary_active;
+  miniexact_link secondary_active;
+
+  // Sizes before they were changed, saved once per item and commit.
+  dc_saved_size* trail;
+  size_t trail_size;
+  size_t trail_capacity;
+  size_t* stamp;
+  size_t stamp_now;
+
+  // Per level: trail position, active counts, chosen item and which of its
+  // options is tried.
+  size_t* level_trail;
+  miniexact_link* level_primary_active;
+  miniexact_link* level_secondary_active;
+  miniexact_link* level_item;
+  miniexact_link* level_k;
+} algorithm_dc;
+
+typedef enum dc_state { D1, D2, D3, D4, D5, D6, D7, D8 } dc_state;
+
+static inline bool
+is_active(miniexact_problem* p, algorithm_dc* d, miniexact_link j) {
+  if(j <= p->N_1)
+    return d->ipos[j] < d->primary_active;
+  return d->ipos[j] < p->N_1 + d->secondary_active;
+}
+
+static inline void
+swap_items(algorithm_dc* d, miniexact_link j, miniexact_link pos) {
+  miniexact_link other = d->item[pos];
+  d->item[d->ipos[j]] = other;
+  d->ipos[other] = d->ipos[j];
+  d->item[pos] = j;
+  d->ipos[j] = pos;
+}
+
+static inline void
+deactivate(miniexact_problem* p, algorithm_dc* d, miniexact_link j) {
+  if(j <= p->N_1)
+    swap_items(d, j, --d->primary_active);
+  else
+    swap_items(d, j, p->N_1 + --d->secondary_active);
+}
+
+// Removes node q from the set of item k by swapping it behind the end.
+static inline void
+remove_node(algorithm_dc* d, miniexact_link k, miniexact_link q) {
+  if(d->stamp[k] != d->stamp_now) {
+    d->stamp[k] = d->stamp_now;
+    if(d->trail_size == d->trail_capacity) {
+      d->trail_capacity *= 2;
+      d->trail = realloc(d->trail, d->trail_capacity * sizeof(dc_saved_size));
+    }
+    d->trail[d->trail_size++] = (dc_saved_size){ k, d->size[k] };
+  }
+
+  miniexact_link last = d->start[k] + --d->size[k];
+  miniexact_link pos = d->loc[q];
+  miniexact_link r = d->set[last];
+  d->set[pos] = r;
+  d->loc[r] = pos;
+  d->set[last] = q;
+  d->loc[q] = last;
+}
+
+// Removes the option of node r from the sets of all other active items. Like
+// unlinking a node in dancing links, each removal counts as one update.
+static void
+hide_option(miniexact_problem* p, algorithm_dc* d, miniexact_link r) {
+  miniexact_link q = r + 1;
+  while(q != r) {
+    miniexact_link k = d->itm[q];
+    STAT_MEMS(1);
+    if(k <= 0) {
+      q = d->loc[q];
+    } else {
+      if(is_active(p, d, k)) {
+        remove_node(d, k, q);
+        STAT_MEMS(4);
+        STAT_UPDATES(1);
+      }
+      ++q;
+    }
+  }
+}
+
+// Covers the items of the option of node x and hides all options that are not
+// compatible with it anymore. Each item is deactivated before its options are
+// hidden, so its own set stays untouched while it is scanned.
+static void
+commit_option(miniexact_problem* p, algorithm_dc* d, miniexact_link x) {
+  ++d->stamp_now;
+
+  miniexact_link q = x;
+  do {
+    miniexact_link j = d->itm[q];
+    STAT_MEMS(1);
+    if(j <= 0) {
+      q = d->loc[q];
+      continue;
+    }
+
+    // Inactive secondary items are purified already and agree with x.
+    if(is_active(p, d, j)) {
+      deactivate(p, d, j);
+      miniexact_link c = j <= p->N_1 ? 0 : d->clr[q];
+      miniexact_link end = d->start[j] + d->size[j];
+      STAT_MEMS(2);
+      STAT_UPDATES(1);
+      for(miniexact_link s = d->start[j]; s < end; ++s) {
+        miniexact_link r = d->set[s];
+        STAT_MEMS(2);
+        if(r != q && (c == 0 || d->clr[r] != c))
+          hide_option(p, d, r);
+      }
+    }
+    ++q;
+  } while(q != x);
+}
+
+static void
+restore_level(algorithm_dc* d, miniexact_link l) {
+  while(d->trail_size > d->level_trail[l]) {
+    dc_saved_size* s = &d->trail[--d->trail_size];
+    d->size[s->item] = s->size;
+  }
+  d->primary_active = d->level_primary_active[l];
+  d->secondary_active = d->level_secondary_active[l];
+}
+
+static void
+free_userdata(miniexact_algorithm* a, miniexact_problem* p) {
+  (void)a;
+  algorithm_dc* d = p->algorithm_userdata;
+  if(!d)
+    return;
+
+  free(d->itm);
+  free(d->clr);
+  free(d->loc);
+  free(d->set);
+  free(d->start);
+  free(d->size);
+  free(d->item);
+  free(d->ipos);
+  free(d->trail);
+  free(d->stamp);
+  free(d->level_trail);
+  free(d->level_primary_active);
+  free(d->level_secondary_active);
+  free(d->level_item);
+  free(d->level_k);
+  free(d);
+  p->algorithm_userdata = NULL;
+}
+
+// Copies the dancing links matrix into sparse sets.
+static algorithm_dc*
+build(miniexact_problem* p) {
+  algorithm_dc* d = calloc(1, sizeof(algorithm_dc));
+  size_t nodes = MINIEXACT_NODES_SIZE(p);
+  size_t items = p->N + 1;
+  size_t levels = p->option_count + 1;
+
+  d->itm = malloc(nodes * sizeof(miniexact_link));
+  d->clr = malloc(nodes * sizeof(miniexact_link));
+  d->loc = malloc(nodes * sizeof(miniexact_link));
+  d->set = malloc(nodes * sizeof(miniexact_link));
+  d->start = malloc(items * sizeof(miniexact_link));
+  d->size = malloc(items * sizeof(miniexact_link));
+  d->item = malloc(items * sizeof(miniexact_link));
+  d->ipos = malloc(items * sizeof(miniexact_link));
+  d->stamp = calloc(items, sizeof(size_t));
+  d->trail_capacity = items;
+  d->trail = malloc(d->trail_capacity * sizeof(dc_saved_size));
+  d->level_trail = malloc(levels * sizeof(size_t));
+  d->level_primary_active = malloc(levels * sizeof(miniexact_link));
+  d->level_secondary_active = malloc(levels * sizeof(miniexact_link));
+  d->level_item = malloc(levels * sizeof(miniexact_link));
+  d->level_k = malloc(levels * sizeof(miniexact_link));
+
+  for(size_t x = p->N + 1; x < nodes; ++x) {
+    d->itm[x] = TOP(x);
+    d->clr[x] = COLOR(x) > 0 ? COLOR(x) : 0;
+    d->loc[x] = TOP(x) <= 0 ? ULINK(x) : 0;
+  }
+
+  // Secondary items detached by preprocessing are placed behind the active
+  // ones and stay inactive, so their self-linked nodes are never touched.
+  miniexact_link s = 0;
+  miniexact_link detached = p->N;
+  d->secondary_active = 0;
+  for(miniexact_link i = 1; i <= p->N; ++i) {
+    d->start[i] = s;
+    for(miniexact_link x = DLINK(i); x != i; x = DLINK(x)) {
+      d->set[s] = x;
+      d->loc[x] = s;
+      ++s;
+    }
+    d->size[i] = s - d->start[i];
+
+    miniexact_link pos = i - 1;
+    if(i > p->N_1)
+      pos = LLINK(i) == i ? --detached
+                          : p->N_1 + d->secondary_active++;
+    d->item[pos] = i;
+    d->ipos[i] = pos;
+  }
+  d->primary_active = p->N_1;
+
+  return d;
+}
+
+static bool
+compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
+  if(p->x_capacity < p->option_count + 1) {
+    MINIEXACT_ARR_RESIZE(x, p->option_count + 1)
+    p->x_size = 0;
+  }
+
+  (void)a;
+  algorithm_dc* d = p->algorithm_userdata;
+
+  while(true) {
+    switch(p->state) {
+      case D1: {
+        for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i)) {
+          if(DLINK(i) == 0 && ULINK(i) == 0) {
+            fprintf(stderr, "Some item never occurs in the options!\n");
+            return false;
+          }
+        }
+
+        if(!d)
+          p->algorithm_userdata = d = build(p);
+
+        p->l = 0;
+        p->state = D2;
+        break;
+      }
+      case D2:
+        if(d->primary_active == 0) {
+          p->state = D8;
+          p->x_size = p->l;
+          return true;
+        }
+        p->state = D3;
+        break;
+      case D3: {
+        // MRV over the active primary items.
+        miniexact_link i = d->item[0];
+        STAT_SCANS(1);
+        STAT_MEMS(2);
+        for(miniexact_link k = 1; k < d->primary_active && d->size[i]; ++k) {
+          miniexact_link j = d->item[k];
+          STAT_SCANS(1);
+          STAT_MEMS(2);
+          if(d->size[j] < d->size[i])
+            i = j;
+        }
+        p->i = i;
+        p->state = D4;
+        break;
+      }
+      case D4:
+        d->level_trail[p->l] = d->trail_size;
+        d->level_primary_active[p->l] = d->primary_active;
+        d->level_secondary_active[p->l] = d->secondary_active;
+        d->level_item[p->l] = p->i;
+        d->level_k[p->l] = 0;
+        p->state = D5;
+        break;
+      case D5: {
+        miniexact_link i = d->level_item[p->l];
+        if(d->level_k[p->l] == d->size[i]) {
+          p->state = D7;
+          break;
+        }
+        p->x[p->l] = d->set[d->start[i] + d->level_k[p->l]];
+        commit_option(p, d, p->x[p->l]);
+        STAT_NODE();
+        p->l = p->l + 1;
+        p->state = D2;
+        if(p->budget && !miniexact_budget_descend(p->budget))
+          return false;// Out of budget, could continue at D2.
+        break;
+      }
+      case D6:
+        restore_level(d, p->l);
+        d->level_k[p->l] = d->level_k[p->l] + 1;
+        p->state = D5;
+        break;
+      case D7:
+        p->state = D8;
+        break;
+      case D8:
+        if(p->l == 0) {
+          return false;
+        }
+        p->l = p->l - 1;
+        p->state = D6;
+        break;
+    }
+  }
+
+  return false;
+}
+
+void
+miniexact_algorithm_dc_set(miniexact_algorithm* a) {
+  miniexact_algorithm_standard_functions(a);
+
+  a->compute_next_result = &compute_next_result;
+  a->free_userdata = &free_userdata;
+}
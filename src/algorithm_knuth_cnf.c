@@ -6,23 +6,43 @@
 
 #include <miniexact/algorithm.h>
 #include <miniexact/algorithm_knuth_cnf.h>
+#include <miniexact/ipasir.h>
 #include <miniexact/log.h>
 #include <miniexact/ops.h>
 #include <miniexact/sat_solver.h>
 
 struct algorithm_knuth_cnf {
   miniexact_sat_solver solver;
+
+  // Set if an incremental solver was loaded. It keeps the encoding and the
+  // blocking clauses of all solutions between calls.
+  miniexact_ipasir ipasir;
+  bool incremental;
+  bool encoded;
+
+  // Set if some item has a range [u;v] with u < v, so that a solution may
+  // contain another one. Their blocking clauses have to list all options.
+  bool supersets;
+
+  // Set once a solution was returned. It may be empty, so p->x_size cannot
+  // tell whether there is a solution to block.
+  bool found;
+
   miniexact_link* past_solutions;
   size_t past_solutions_size;
   size_t past_solutions_count;
 };
 
 static struct algorithm_knuth_cnf*
-create_k() {
+create_k(miniexact_problem* p) {
   struct algorithm_knuth_cnf* k = calloc(1, sizeof(struct algorithm_knuth_cnf));
   k->past_solutions = NULL;
   k->past_solutions_size = 0;
   k->past_solutions_count = 0;
+  // A portfolio races external solvers, so no library is loaded then.
+  k->incremental =
+    !miniexact_sat_solver_portfolio_configured() &&
+    miniexact_ipasir_find(&k->ipasir, p->cfg ? p->cfg->ipasir : NULL);
   return k;
 }
 
@@ -33,94 +53,484 @@ get_option_id(miniexact_problem* p, miniexact_link i) {
   return -TOP(i);
 }
 
-struct vars_clauses {
+static inline void
+add(struct algorithm_knuth_cnf* k, int lit) {
+  if(k->incremental)
+    miniexact_ipasir_add(&k->ipasir, lit);
+  else
+    miniexact_sat_solver_add(&k->solver, lit);
+}
+
+static bool one_pass = false;
+
+void
+miniexact_knuth_cnf_set_one_pass(bool enabled) {
+  one_pass = enabled;
+}
+
+bool
+miniexact_amo_encoding_from_name(const char* name,
+                                 miniexact_amo_encoding* encoding) {
+  static const char* names[] = {
+    "auto", "pairwise", "sequential", "commander", "product", NULL
+  };
+  for(int i = 0; names[i]; ++i) {
+    if(strcmp(name, names[i]) == 0) {
+      *encoding = (miniexact_amo_encoding)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// The encoding is traversed twice for the external solver: once to count the
+// variables and clauses of the header, then to write the clauses. Auxiliary
+// variables are numbered after the options in the same order both times. In
+// one-pass mode, the solver keeps the clauses until the header is known.
+typedef struct encoder {
+  struct algorithm_knuth_cnf* k;
+  bool counting;
   int variables;
   int clauses;
-};
-static struct vars_clauses
-compute_vars_clauses(miniexact_problem* p) {
-  struct algorithm_knuth_cnf* k = p->algorithm_userdata;
-  miniexact_sat_solver* s = &k->solver;
+  miniexact_amo_encoding amo;
+} encoder;
 
-  struct vars_clauses v = { p->option_count, 0 };
+static inline int
+new_variable(encoder* e) {
+  return ++e->variables;
+}
 
-  // Go downwards from items so that every option is captured.
-  for(miniexact_link i = 1; i <= p->N_1; ++i) {
-    ++v.clauses;
-    for(miniexact_link down1 = DLINK(i); down1 > ULINK(down1); down1 = DLINK(down1)) {
-      miniexact_link option1 = get_option_id(p, down1);
-      for(miniexact_link down2 = DLINK(i); down2 > ULINK(down2);
-          down2 = DLINK(down2)) {
-        if(down1 == down2)
-          continue;
-        ++v.clauses;
-      }
+static void
+clause(encoder* e, const int* lits, int n) {
+  ++e->clauses;
+  if(e->counting)
+    return;
+  for(int i = 0; i < n; ++i)
+    add(e->k, lits[i]);
+  add(e->k, 0);
+}
+
+static inline void
+binary(encoder* e, int a, int b) {
+  int lits[2] = { a, b };
+  clause(e, lits, 2);
+}
+
+// Below this many literals, the pairwise encoding is the smallest one.
+#define AMO_PAIRWISE_MAX 6
+#define AMO_SEQUENTIAL_MAX 128
+#define AMO_COMMANDER_GROUP 3
+
+static void
+at_most_one(encoder* e,
+            const int* lits,
+            int n,
+            miniexact_amo_encoding encoding);
+
+// n(n-1)/2 clauses, no auxiliary variables.
+static void
+amo_pairwise(encoder* e, const int* lits, int n) {
+  for(int i = 0; i < n; ++i)
+    for(int j = i + 1; j < n; ++j)
+      binary(e, -lits[i], -lits[j]);
+}
+
+// Sinz' sequential counter: s_i is true if one of the first i literals is.
+// 3n-4 clauses and n-1 auxiliary variables.
+static void
+amo_sequential(encoder* e, const int* lits, int n) {
+  int s = new_variable(e);
+  binary(e, -lits[0], s);
+  for(int i = 1; i < n - 1; ++i) {
+    int next = new_variable(e);
+    binary(e, -lits[i], next);
+    binary(e, -s, next);
+    binary(e, -lits[i], -s);
+    s = next;
+  }
+  binary(e, -lits[n - 1], -s);
+}
+
+// Klieber and Kwon's commander encoding: at most one literal per group of
+// three, whose commander is true iff one of them is, and at most one
+// commander. About 3.5n clauses and n/2 auxiliary variables.
+static void
+amo_commander(encoder* e, const int* lits, int n) {
+  int groups = (n + AMO_COMMANDER_GROUP - 1) / AMO_COMMANDER_GROUP;
+  int* commanders = malloc(groups * sizeof(int));
+  for(int g = 0; g < groups; ++g) {
+    const int* group = lits + g * AMO_COMMANDER_GROUP;
+    int size = n - g * AMO_COMMANDER_GROUP;
+    if(size > AMO_COMMANDER_GROUP)
+      size = AMO_COMMANDER_GROUP;
+    int c = new_variable(e);
+    commanders[g] = c;
+
+    amo_pairwise(e, group, size);
+    int implied[AMO_COMMANDER_GROUP + 1];
+    implied[0] = -c;
+    for(int i = 0; i < size; ++i) {
+      implied[i + 1] = group[i];
+      binary(e, -group[i], c);
     }
+    clause(e, implied, size + 1);
   }
+  at_most_one(e, commanders, groups, MINIEXACT_AMO_COMMANDER);
+  free(commanders);
+}
+
+// Chen's product encoding: the literals are placed in a grid, and a true
+// literal implies its row and its column. At most one row and one column may
+// be true. 2n + O(sqrt n) clauses and O(sqrt n) auxiliary variables.
+static void
+amo_product(encoder* e, const int* lits, int n) {
+  int rows = 1;
+  while(rows * rows < n)
+    ++rows;
+  int columns = (n + rows - 1) / rows;
 
-  return v;
+  int* r = malloc((rows + columns) * sizeof(int));
+  int* c = r + rows;
+  for(int i = 0; i < rows; ++i)
+    r[i] = new_variable(e);
+  for(int j = 0; j < columns; ++j)
+    c[j] = new_variable(e);
+
+  for(int x = 0; x < n; ++x) {
+    binary(e, -lits[x], r[x / columns]);
+    binary(e, -lits[x], c[x % columns]);
+  }
+  at_most_one(e, r, rows, MINIEXACT_AMO_PRODUCT);
+  at_most_one(e, c, columns, MINIEXACT_AMO_PRODUCT);
+  free(r);
 }
 
 static void
-encode_problem(miniexact_problem* p, size_t additional_clauses) {
-  struct algorithm_knuth_cnf* k = p->algorithm_userdata;
-  miniexact_sat_solver* s = &k->solver;
+at_most_one(encoder* e,
+            const int* lits,
+            int n,
+            miniexact_amo_encoding encoding) {
+  if(n < 2)
+    return;
+  if(encoding == MINIEXACT_AMO_AUTO)
+    encoding = n <= AMO_PAIRWISE_MAX     ? MINIEXACT_AMO_PAIRWISE
+               : n <= AMO_SEQUENTIAL_MAX ? MINIEXACT_AMO_SEQUENTIAL
+                                         : MINIEXACT_AMO_PRODUCT;
+  // The recursive encodings end with a few literals.
+  if(n <= 4 && (encoding == MINIEXACT_AMO_COMMANDER ||
+                encoding == MINIEXACT_AMO_PRODUCT))
+    encoding = MINIEXACT_AMO_PAIRWISE;
+
+  switch(encoding) {
+    case MINIEXACT_AMO_SEQUENTIAL:
+      amo_sequential(e, lits, n);
+      break;
+    case MINIEXACT_AMO_COMMANDER:
+      amo_commander(e, lits, n);
+      break;
+    case MINIEXACT_AMO_PRODUCT:
+      amo_product(e, lits, n);
+      break;
+    default:
+      amo_pairwise(e, lits, n);
+      break;
+  }
+}
+
+static inline void
+unit(encoder* e, int a) {
+  clause(e, &a, 1);
+}
 
-  struct vars_clauses v = compute_vars_clauses(p);
-  miniexact_sat_solver_find_and_init(s, v.variables, v.clauses + additional_clauses);
+static inline void
+ternary(encoder* e, int a, int b, int c) {
+  int lits[3] = { a, b, c };
+  clause(e, lits, 3);
+}
 
-  if(p->N != p->N_1) {
-    miniexact_err("No secondary items supported by the SAT solver (yet)!");
+// Between u and v of the literals are true. Sinz' sequential counter with
+// both directions, so that also the lower bound can be asserted: s[i][j] is
+// true iff at least j of the first i+1 literals are. Only the counts up to
+// v+1 (or u if v >= n) are tracked.
+static void
+cardinality(encoder* e, const int* lits, int n, int u, int v) {
+  if(u > n) {
+    clause(e, NULL, 0);
+    return;
+  }
+  int K = v < n ? v + 1 : u;
+  if(K == 0)
     return;
+
+  int* s = calloc((size_t)n * (K + 1), sizeof(int));
+#define S(I, J) s[(I) * (K + 1) + (J)]
+  for(int i = 0; i < n; ++i) {
+    int x = lits[i];
+    for(int j = 1; j <= K && j <= i + 1; ++j) {
+      int r = new_variable(e);
+      S(i, j) = r;
+      // Counts of the first i literals, if they can reach j resp. j-1.
+      int same = j <= i ? S(i - 1, j) : 0;
+      int less = j >= 2 ? S(i - 1, j - 1) : 0;
+
+      if(same)
+        binary(e, -same, r);
+      if(j == 1)
+        binary(e, -x, r);
+      else
+        ternary(e, -x, -less, r);
+
+      if(same)
+        ternary(e, -r, same, x);
+      else
+        binary(e, -r, x);
+      if(j >= 2) {
+        if(same)
+          ternary(e, -r, same, less);
+        else
+          binary(e, -r, less);
+      }
+    }
   }
+  if(v < n)
+    unit(e, -S(n - 1, v + 1));
+  if(u >= 1)
+    unit(e, S(n - 1, u));
+#undef S
+  free(s);
+}
 
+// Every primary item is covered by exactly one of its options, or by u to v
+// options if it has a multiplicity [u;v].
+static void
+encode_primary_items(miniexact_problem* p, encoder* e, int* lits) {
   // Go downwards from items so that every option is captured.
   for(miniexact_link i = 1; i <= p->N_1; ++i) {
+    int n = 0;
+    for(miniexact_link down = DLINK(i); down > ULINK(down); down = DLINK(down))
+      lits[n++] = get_option_id(p, down);
+    assert(n == LEN(i));
+
+    // Plain primary items have BOUND 0, see define_primary_item.
+    int u = 1, v = 1;
+    if(BOUND(i) > 0) {
+      u = BOUND(i) - SLACK(i);
+      v = BOUND(i);
+    }
+
+    if(u <= 1 && v == 1) {
+      if(u == 1)
+        clause(e, lits, n);
+      at_most_one(e, lits, n, e->amo);
+    } else {
+      cardinality(e, lits, n, u, v);
+    }
+  }
+}
+
+typedef struct occurrence {
+  int option;
+  miniexact_color color;
+} occurrence;
+
+static int
+compare_occurrences(const void* a, const void* b) {
+  const occurrence* x = a;
+  const occurrence* y = b;
+  if(x->color != y->color)
+    return x->color < y->color ? -1 : 1;
+  return x->option - y->option;
+}
+
+// Options that give a secondary item the same color may be chosen together,
+// all others exclude each other. Every color gets a variable that is implied
+// by its options, and at most one of these is true. Options without a color
+// stand for themselves.
+static void
+encode_secondary_items(miniexact_problem* p,
+                       encoder* e,
+                       int* lits,
+                       occurrence* occurrences) {
+  for(miniexact_link i = p->N_1 + 1; i <= p->N; ++i) {
+    int n = 0;
     for(miniexact_link down = DLINK(i); down > ULINK(down); down = DLINK(down)) {
-      miniexact_link option = get_option_id(p, down);
-      miniexact_sat_solver_add(s, option);
+      occurrences[n].option = get_option_id(p, down);
+      occurrences[n].color = COLOR(down);
+      ++n;
     }
-    miniexact_sat_solver_add(s, 0);
-    for(miniexact_link down1 = DLINK(i); down1 > ULINK(down1); down1 = DLINK(down1)) {
-      miniexact_link option1 = get_option_id(p, down1);
-      for(miniexact_link down2 = DLINK(i); down2 > ULINK(down2);
-          down2 = DLINK(down2)) {
-        if(down1 == down2)
-          continue;
-        miniexact_link option2 = get_option_id(p, down2);
-        miniexact_sat_solver_binary(s, -option1, -option2);
+    qsort(occurrences, n, sizeof(occurrence), &compare_occurrences);
+
+    int classes = 0;
+    for(int k = 0; k < n;) {
+      int end = k + 1;
+      if(occurrences[k].color > 0)
+        while(end < n && occurrences[end].color == occurrences[k].color)
+          ++end;
+
+      if(end - k == 1) {
+        lits[classes++] = occurrences[k].option;
+      } else {
+        int c = new_variable(e);
+        for(int o = k; o < end; ++o)
+          binary(e, -occurrences[o].option, c);
+        lits[classes++] = c;
       }
+      k = end;
+    }
+    at_most_one(e, lits, classes, e->amo);
+  }
+}
+
+// The search only chooses options through their primary items, so options
+// without any are never part of a solution.
+static void
+encode_options_without_primary_items(miniexact_problem* p, encoder* e) {
+  bool primary = false;
+  for(miniexact_link q = p->N + 2; q <= p->Z; ++q) {
+    miniexact_link t = TOP(q);
+    if(t > 0) {
+      primary |= t <= p->N_1;
+    } else {
+      if(!primary && TOP(q - 1) > 0)
+        unit(e, -get_option_id(p, q));
+      primary = false;
     }
   }
 }
 
+static void
+encode_items(miniexact_problem* p, encoder* e) {
+  size_t longest = 0;
+  for(miniexact_link i = 1; i <= p->N; ++i)
+    if((size_t)LEN(i) > longest)
+      longest = LEN(i);
+
+  int* lits = malloc((longest + 1) * sizeof(int));
+  occurrence* occurrences = malloc((longest + 1) * sizeof(occurrence));
+  encode_primary_items(p, e, lits);
+  encode_secondary_items(p, e, lits, occurrences);
+  encode_options_without_primary_items(p, e);
+  free(lits);
+  free(occurrences);
+}
+
+static void
+encode_problem(miniexact_problem* p, size_t additional_clauses) {
+  struct algorithm_knuth_cnf* k = p->algorithm_userdata;
+
+  k->supersets = false;
+  for(miniexact_link i = 1; i <= p->N_1; ++i)
+    k->supersets |= BOUND(i) > 0 && SLACK(i) > 0;
+  miniexact_amo_encoding amo = p->cfg ? p->cfg->amo : MINIEXACT_AMO_AUTO;
+
+  // The external solver needs the header before the clauses.
+  if(!k->incremental && one_pass) {
+    miniexact_sat_solver_find_and_init_one_pass(&k->solver, p->option_count);
+  } else if(!k->incremental) {
+    encoder count = { k, true, p->option_count, 0, amo };
+    encode_items(p, &count);
+    miniexact_sat_solver_find_and_init(
+      &k->solver, count.variables, count.clauses + additional_clauses);
+  }
+
+  encoder e = { k, false, p->option_count, 0, amo };
+  encode_items(p, &e);
+}
+
+// Options are numbered by the spacers after them, their variables are the
+// option indices.
+static void
+extract_solution(miniexact_problem* p, const char* assignments) {
+  p->x_size = 0;
+  for(miniexact_link i = p->N + 2; i <= p->Z; ++i) {
+    miniexact_link t = TOP(i);
+    if(t < 0) {
+      bool active = assignments[-t];
+      if(active) {
+        MINIEXACT_ARR_PLUS1(x)
+        p->x[p->x_size - 1] = i - 1;
+      }
+    }
+  }
+  p->l = p->x_size;
+}
+
+// Writes the clause that excludes the last solution to clause, which has room
+// for all options. Returns the number of literals.
+static size_t
+blocking_clause(miniexact_problem* p,
+                struct algorithm_knuth_cnf* k,
+                miniexact_link* clause) {
+  if(!k->supersets) {
+    size_t size = miniexact_extract_solution_option_indices(p, clause);
+    for(size_t i = 0; i < size; ++i)
+      clause[i] = -clause[i];
+    return size;
+  }
+  for(int v = 1; v <= p->option_count; ++v)
+    clause[v - 1] = k->solver.assignments[v] ? -v : v;
+  return p->option_count;
+}
+
+static bool
+compute_next_result_incremental(miniexact_problem* p) {
+  struct algorithm_knuth_cnf* k = p->algorithm_userdata;
+
+  if(!k->encoded) {
+    encode_problem(p, 0);
+    k->encoded = true;
+  } else if(k->found) {
+    // Block the last solution, the solver keeps everything it learned so far.
+    miniexact_link* clause = malloc(p->option_count * sizeof(miniexact_link));
+    size_t size = blocking_clause(p, k, clause);
+    for(size_t i = 0; i < size; ++i)
+      miniexact_ipasir_add(&k->ipasir, clause[i]);
+    miniexact_ipasir_add(&k->ipasir, 0);
+    free(clause);
+  }
+
+  int r = miniexact_ipasir_solve(&k->ipasir);
+  if(r != 10) {
+    if(r != 20)
+      miniexact_err("IPASIR solver returned unexpected result %d!", r);
+    return false;
+  }
+
+  k->solver.assignments =
+    realloc(k->solver.assignments, sizeof(char) * (p->option_count + 1));
+  for(int v = 1; v <= p->option_count; ++v)
+    k->solver.assignments[v] = miniexact_ipasir_value(&k->ipasir, v);
+  extract_solution(p, k->solver.assignments);
+  k->found = true;
+  return true;
+}
+
 static bool
 compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
   if(!p->algorithm_userdata) {
-    p->algorithm_userdata = create_k();
+    p->algorithm_userdata = create_k(p);
   }
   struct algorithm_knuth_cnf* k = p->algorithm_userdata;
 
-  encode_problem(p, k->past_solutions_count + (p->x_size != 0 ? 1 : 0));
+  if(k->incremental)
+    return compute_next_result_incremental(p);
 
-  if(p->x_size != 0) {
+  encode_problem(p, k->past_solutions_count + (k->found ? 1 : 0));
+
+  if(k->found) {
     // The last found result has to be added to the last solutions! This cost is
     // only paid if multiple solutions should be enumerated. Would be nicer with
     // incremental SAT, but without dependencies, this is what it is.
     //
     // +1 so that the trailing 0 is also saved.
-    size_t new_size = k->past_solutions_size + p->x_size + 1;
-    k->past_solutions = realloc(k->past_solutions, new_size * sizeof(int32_t));
-
-    miniexact_link options[p->x_size];
-    miniexact_extract_solution_option_indices(p, options);
-    miniexact_sat_solver* s = &k->solver;
-    for(size_t i = 0; i < p->x_size; ++i) {
-      k->past_solutions[k->past_solutions_size + i] = -options[i];
-    }
-    k->past_solutions[k->past_solutions_size + p->x_size] = 0;
+    k->past_solutions =
+      realloc(k->past_solutions,
+              (k->past_solutions_size + p->option_count + 1) * sizeof(int32_t));
+    size_t size =
+      blocking_clause(p, k, k->past_solutions + k->past_solutions_size);
+    k->past_solutions[k->past_solutions_size + size] = 0;
 
-    k->past_solutions_size = new_size;
+    k->past_solutions_size += size + 1;
 
     ++k->past_solutions_count;
   }
@@ -134,18 +544,8 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
   if(r == 20)
     return false;
   else if(r == 10) {
-    p->x_size = 0;
-    for(miniexact_link i = p->N + 2; i <= p->Z; ++i) {
-      miniexact_link t = TOP(i);
-      if(t < 0) {
-        bool active = k->solver.assignments[-t];
-        if(active) {
-          MINIEXACT_ARR_PLUS1(x)
-          p->x[p->x_size - 1] = i - 1;
-        }
-      }
-    }
-    p->l = p->x_size;
+    extract_solution(p, k->solver.assignments);
+    k->found = true;
     return true;
   }
 
@@ -158,10 +558,10 @@ free_userdata(miniexact_algorithm* a, miniexact_problem* p) {
     return;
 
   struct algorithm_knuth_cnf* k = p->algorithm_userdata;
-  if(k->solver.assignments) {
-    free(k->solver.assignments);
-    k->solver.assignments = NULL;
-  }
+  miniexact_sat_solver_destroy(&k->solver);
+  if(k->incremental)
+    miniexact_ipasir_close(&k->ipasir);
+  free(k->past_solutions);
 
   free(k);
 }
@@ -22,31 +22,53 @@
 
 #include <miniexact/algorithm.h>
 #include <miniexact/algorithm_m.h>
+#include <miniexact/budget.h>
+#include <miniexact/cancel.h>
+#include <miniexact/checkpoint.h>
+#include <miniexact/estimate.h>
 #include <miniexact/ops.h>
+#include <miniexact/profile.h>
 
 typedef enum m_state { M1, M2, M3, M4, M5, M6, M7, M8, M9 } m_state;
 
+// Skips the branch of M6 as if its subtree had been explored. For an option,
+// continue like M7, there is nothing to undo. The branch without an option of
+// i is the last one, continue like M9 after it.
+static void
+skip_branch(miniexact_problem* p) {
+  if(p->x[p->l] != p->i) {
+    p->x[p->l] = DLINK(p->x[p->l]);
+    p->state = M5;
+  } else {
+    p->p = LLINK(p->i);
+    p->q = RLINK(p->i);
+    RLINK(p->p) = p->i;
+    LLINK(p->q) = p->i;
+    p->state = M8;
+  }
+}
+
 static bool
 compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
-  if(p->x_capacity < p->option_count) {
-    p->x = realloc(p->x, sizeof(miniexact_link) * p->option_count);
-    p->x_capacity = p->option_count;
+  // Every level either chooses an option or drops a primary item.
+  size_t max_depth = p->option_count + p->primary_item_count + 1;
+  if(p->x_capacity < max_depth) {
+    MINIEXACT_ARR_RESIZE(x, max_depth)
     p->x_size = 0;
   }
+  MINIEXACT_ARR_RESERVE(ft, max_depth)
 
   assert(a->choose_i);
 
   while(true) {
     switch(p->state) {
       case M1: {
-        miniexact_link i = 0;
-        do {
-          i = RLINK(i);
+        for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i)) {
           if(DLINK(i) == 0 && ULINK(i) == 0) {
             fprintf(stderr, "Some item never occurs in the options!\n");
             return false;
           }
-        } while(RLINK(i) != 0);
+        }
 
         p->l = 0;
         p->state = M2;
@@ -63,6 +85,11 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
         break;
       case M3:
         p->i = a->choose_i(a, p, 0);
+        if(p->profile)
+          miniexact_profile_choose(p->profile, p);
+        // M5 lets M6 descend once for each of the THETA(i) branches.
+        if(p->estimate)
+          miniexact_estimate_choose(p->estimate, p, THETA(p->i));
         assert(p->i <= p->primary_item_count);
         if(THETA(p->i) == 0) {
           p->state = M9;
@@ -106,9 +133,24 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
         p->state = M6;
         break;
       case M6:
+        if(p->cancel && !miniexact_cancel_descend(p->cancel, p)) {
+          // Cancelled, backtrack to the root.
+          skip_branch(p);
+          break;
+        }
+        if(p->checkpoint && !miniexact_checkpoint_descend(p->checkpoint, p)) {
+          // Subtree was explored before the checkpoint.
+          skip_branch(p);
+          break;
+        }
+        if(p->estimate && !miniexact_estimate_descend(p->estimate, p)) {
+          // Not on the random path.
+          skip_branch(p);
+          break;
+        }
         if(p->x[p->l] != p->i) {
           p->p = p->x[p->l] + 1;
-          assert(p->p < p->top_size);
+          assert(p->p < MINIEXACT_NODES_SIZE(p));
           while(p->x[p->l] != p->p) {
             miniexact_link j = TOP(p->p);
             if(j <= 0) {
@@ -125,8 +167,13 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
             }
           }
         }
+        STAT_NODE();
         p->l = p->l + 1;
+        if(p->profile)
+          miniexact_profile_enter(p->profile, p);
         p->state = M2;
+        if(p->budget && !miniexact_budget_descend(p->budget))
+          return false;// Out of budget, could continue at M2.
         break;
       case M7:
         p->p = p->x[p->l] - 1;
@@ -163,6 +210,10 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
         if(p->l == 0) {
           return false;
         }
+        if(p->profile)
+          miniexact_profile_leave(p->profile, p);
+        if(p->estimate)
+          miniexact_estimate_leave(p->estimate, p);
         p->l = p->l - 1;
         if(p->x[p->l] <= p->N) {
           p->i = p->x[p->l];
@@ -22,15 +22,22 @@
 
 #include <miniexact/algorithm.h>
 #include <miniexact/algorithm_x.h>
+#include <miniexact/budget.h>
+#include <miniexact/cancel.h>
+#include <miniexact/checkpoint.h>
+#include <miniexact/estimate.h>
 #include <miniexact/ops.h>
+#include <miniexact/profile.h>
+#include <miniexact/parallel.h>
 
 typedef enum x_state { X1, X2, X3, X4, X5, X6, X7, X8 } x_state;
 
 static bool
 compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
-  if(p->x_capacity < p->option_count) {
-    p->x = realloc(p->x, sizeof(miniexact_link) * p->option_count);
-    p->x_capacity = p->option_count;
+  // The deepest level may still try to choose an option for an item that
+  // cannot be covered anymore.
+  if(p->x_capacity < p->option_count + 1) {
+    MINIEXACT_ARR_RESIZE(x, p->option_count + 1)
     p->x_size = 0;
   }
 
@@ -39,14 +46,12 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
   while(true) {
     switch(p->state) {
       case X1: {
-        miniexact_link i = 0;
-        do {
-          i = RLINK(i);
+        for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i)) {
           if(DLINK(i) == 0 && ULINK(i) == 0) {
             fprintf(stderr, "Some item never occurs in the options!\n");
             return false;
           }
-        } while(RLINK(i) != 0);
+        }
 
         p->l = 0;
         p->state = X2;
@@ -63,6 +68,10 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
         break;
       case X3:
         p->i = a->choose_i(a, p, 0);
+        if(p->profile)
+          miniexact_profile_choose(p->profile, p);
+        if(p->estimate)
+          miniexact_estimate_choose(p->estimate, p, LEN(p->i));
         p->state = X4;
         break;
       case X4:
@@ -74,6 +83,24 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
         if(p->x[p->l] == p->i) {
           p->state = X7;
           break;
+        } else if(p->cancel && !miniexact_cancel_descend(p->cancel, p)) {
+          // Cancelled, backtrack to the root.
+          p->x[p->l] = DLINK(p->x[p->l]);
+          break;
+        } else if(p->worker && !miniexact_parallel_claim(p->worker, p->l)) {
+          // Subtree is explored by another worker.
+          p->x[p->l] = DLINK(p->x[p->l]);
+          break;
+        } else if(p->checkpoint &&
+                  !miniexact_checkpoint_descend(p->checkpoint, p)) {
+          // Subtree was explored before the checkpoint.
+          p->x[p->l] = DLINK(p->x[p->l]);
+          break;
+        } else if(p->estimate &&
+                  !miniexact_estimate_descend(p->estimate, p)) {
+          // Not on the random path.
+          p->x[p->l] = DLINK(p->x[p->l]);
+          break;
         } else {
           p->p = p->x[p->l] + 1;
           while(p->p != p->x[p->l]) {
@@ -86,8 +113,13 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
             }
           }
         }
+        STAT_NODE();
         p->l = p->l + 1;
+        if(p->profile)
+          miniexact_profile_enter(p->profile, p);
         p->state = X2;
+        if(p->budget && !miniexact_budget_descend(p->budget))
+          return false;// Out of budget, could continue at X2.
         break;
       case X6:
         p->p = p->x[p->l] - 1;
@@ -112,6 +144,10 @@ compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
         if(p->l == 0) {
           return false;
         }
+        if(p->profile)
+          miniexact_profile_leave(p->profile, p);
+        if(p->estimate)
+          miniexact_estimate_leave(p->estimate, p);
         p->l = p->l - 1;
         p->state = X6;
         break;
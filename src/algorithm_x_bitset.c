@@ -0,0 +1,291 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <miniexact/algorithm.h>
+#include <miniexact/algorithm_x.h>
+#include <miniexact/algorithm_x_bitset.h>
+#include <miniexact/budget.h>
+#include <miniexact/ops.h>
+
+typedef struct algorithm_x_bitset {
+  // Words per bitset of options and per bitset of items (bit j is item j).
+  size_t words;
+  size_t item_words;
+
+  // Per item, the bitset of the options containing it.
+  uint64_t* col;
+  // Per option, its first node in the matrix and its items.
+  miniexact_link* first;
+  miniexact_link* start;
+  miniexact_link* items;
+  uint64_t* primary;
+
+  // Per level: active options, active items and the options of the chosen
+  // item that were not tried yet.
+  uint64_t* active;
+  uint64_t* active_items;
+  uint64_t* candidates;
+} algorithm_x_bitset;
+
+typedef enum x_bitset_state { B1, B2, B3, B4, B5, B6, B7, B8 } x_bitset_state;
+
+// The kernels are plain loops over words, so that compilers turn them into
+// SIMD instructions (SSE/AVX2 or NEON) where available.
+static inline void
+copy_and(uint64_t* restrict dst,
+         const uint64_t* restrict a,
+         const uint64_t* restrict b,
+         size_t words) {
+  for(size_t w = 0; w < words; ++w)
+    dst[w] = a[w] & b[w];
+}
+
+static inline void
+and_not(uint64_t* restrict dst, const uint64_t* restrict b, size_t words) {
+  for(size_t w = 0; w < words; ++w)
+    dst[w] &= ~b[w];
+}
+
+static inline size_t
+popcount_and(const uint64_t* restrict a,
+             const uint64_t* restrict b,
+             size_t words) {
+  size_t count = 0;
+  for(size_t w = 0; w < words; ++w)
+    count += __builtin_popcountll(a[w] & b[w]);
+  return count;
+}
+
+#define COL(J) (b->col + (size_t)(J) * b->words)
+#define ACTIVE(L) (b->active + (size_t)(L) * b->words)
+#define CANDIDATES(L) (b->candidates + (size_t)(L) * b->words)
+#define ACTIVE_ITEMS(L) (b->active_items + (size_t)(L) * b->item_words)
+
+static void
+free_userdata(miniexact_algorithm* a, miniexact_problem* p) {
+  (void)a;
+  algorithm_x_bitset* b = p->algorithm_userdata;
+  if(!b)
+    return;
+
+  free(b->col);
+  free(b->first);
+  free(b->start);
+  free(b->items);
+  free(b->primary);
+  free(b->active);
+  free(b->active_items);
+  free(b->candidates);
+  free(b);
+  p->algorithm_userdata = NULL;
+}
+
+// Copies the options of the matrix into bitsets.
+static algorithm_x_bitset*
+build(miniexact_problem* p) {
+  algorithm_x_bitset* b = calloc(1, sizeof(algorithm_x_bitset));
+  size_t nodes = MINIEXACT_NODES_SIZE(p);
+  // An upper bound, preprocessing may have removed some options.
+  size_t options = p->option_count;
+  size_t levels = p->N_1 + 1;
+
+  b->words = (options + 63) / 64;
+  b->item_words = (p->N + 64) / 64;
+  b->col = calloc((p->N + 1) * b->words, sizeof(uint64_t));
+  b->first = malloc(options * sizeof(miniexact_link));
+  b->start = malloc((options + 1) * sizeof(miniexact_link));
+  b->items = malloc(nodes * sizeof(miniexact_link));
+  b->primary = calloc(b->item_words, sizeof(uint64_t));
+  b->active = calloc((levels + 1) * b->words, sizeof(uint64_t));
+  b->active_items = calloc((levels + 1) * b->item_words, sizeof(uint64_t));
+  b->candidates = calloc(levels * b->words, sizeof(uint64_t));
+
+  size_t o = 0, n = 0;
+  for(size_t x = p->N + 1; x < nodes; ++x) {
+    miniexact_link j = TOP(x);
+    if(j <= 0)
+      continue;
+    if(TOP(x - 1) <= 0) {
+      b->first[o] = x;
+      b->start[o] = n;
+      ++o;
+    }
+    b->items[n++] = j;
+    COL(j)[(o - 1) / 64] |= UINT64_C(1) << ((o - 1) % 64);
+  }
+  assert(o <= options);
+  options = o;
+  b->start[o] = n;
+
+  for(size_t w = 0; w < options / 64; ++w)
+    ACTIVE(0)[w] = ~UINT64_C(0);
+  if(options % 64)
+    ACTIVE(0)[options / 64] = (UINT64_C(1) << (options % 64)) - 1;
+
+  for(miniexact_link j = 1; j <= p->N; ++j) {
+    ACTIVE_ITEMS(0)[j / 64] |= UINT64_C(1) << (j % 64);
+    if(j <= p->N_1)
+      b->primary[j / 64] |= UINT64_C(1) << (j % 64);
+  }
+
+  return b;
+}
+
+static bool
+fall_back(miniexact_algorithm* a, miniexact_problem* p) {
+  miniexact_choose_i choose_i = a->choose_i;
+  miniexact_algorithm_x_set(a);
+  a->choose_i = choose_i;
+  return a->compute_next_result(a, p);
+}
+
+static bool
+compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
+  if(p->x_capacity < p->option_count + 1) {
+    MINIEXACT_ARR_RESIZE(x, p->option_count + 1)
+    p->x_size = 0;
+  }
+
+  algorithm_x_bitset* b = p->algorithm_userdata;
+
+  while(true) {
+    switch(p->state) {
+      case B1: {
+        if(p->N > MINIEXACT_BITSET_MAX_ITEMS ||
+           p->option_count > MINIEXACT_BITSET_MAX_OPTIONS)
+          return fall_back(a, p);
+
+        miniexact_link i = 0;
+        do {
+          i = RLINK(i);
+          if(DLINK(i) == 0 && ULINK(i) == 0) {
+            fprintf(stderr, "Some item never occurs in the options!\n");
+            return false;
+          }
+        } while(RLINK(i) != 0);
+
+        if(!b)
+          p->algorithm_userdata = b = build(p);
+
+        p->l = 0;
+        p->state = B2;
+        break;
+      }
+      case B2:
+      case B3: {
+        // MRV over the active primary items, the first one wins ties. An item
+        // with only one option left is taken right away, as counting the
+        // others costs more than it could save.
+        miniexact_link i = 0;
+        size_t theta = SIZE_MAX;
+        const uint64_t* active = ACTIVE(p->l);
+        const uint64_t* items = ACTIVE_ITEMS(p->l);
+        for(size_t w = 0; w < b->item_words && theta > 1; ++w) {
+          uint64_t bits = items[w] & b->primary[w];
+          while(bits && theta > 1) {
+            miniexact_link j = w * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            size_t lambda = popcount_and(COL(j), active, b->words);
+            STAT_SCANS(1);
+            STAT_MEMS(2 * b->words);
+            if(lambda < theta) {
+              theta = lambda;
+              i = j;
+            }
+          }
+        }
+        if(i == 0) {
+          p->state = B8;
+          p->x_size = p->l;
+          return true;
+        }
+        p->i = i;
+        p->state = B4;
+        break;
+      }
+      case B4:
+        copy_and(CANDIDATES(p->l), COL(p->i), ACTIVE(p->l), b->words);
+        STAT_MEMS(3 * b->words);
+        p->state = B5;
+        break;
+      case B5: {
+        uint64_t* candidates = CANDIDATES(p->l);
+        size_t w = 0;
+        while(w < b->words && !candidates[w])
+          ++w;
+        if(w == b->words) {
+          p->state = B7;
+          break;
+        }
+        size_t o = w * 64 + __builtin_ctzll(candidates[w]);
+        candidates[w] &= candidates[w] - 1;
+        p->x[p->l] = b->first[o];
+
+        // Cover all items of option o. Every word read or written is a mem,
+        // every covered item an update.
+        uint64_t* active = ACTIVE(p->l + 1);
+        uint64_t* items = ACTIVE_ITEMS(p->l + 1);
+        memcpy(active, ACTIVE(p->l), b->words * sizeof(uint64_t));
+        memcpy(items, ACTIVE_ITEMS(p->l), b->item_words * sizeof(uint64_t));
+        STAT_MEMS(2 * (b->words + b->item_words));
+        for(miniexact_link k = b->start[o]; k < b->start[o + 1]; ++k) {
+          miniexact_link j = b->items[k];
+          and_not(active, COL(j), b->words);
+          items[j / 64] &= ~(UINT64_C(1) << (j % 64));
+          STAT_MEMS(3 * b->words + 2);
+          STAT_UPDATES(1);
+        }
+
+        STAT_NODE();
+        p->l = p->l + 1;
+        p->state = B2;
+        if(p->budget && !miniexact_budget_descend(p->budget))
+          return false;// Out of budget, could continue at B2.
+        break;
+      }
+      case B6:
+        p->state = B5;
+        break;
+      case B7:
+        p->state = B8;
+        break;
+      case B8:
+        if(p->l == 0) {
+          return false;
+        }
+        p->l = p->l - 1;
+        p->state = B6;
+        break;
+    }
+  }
+
+  return false;
+}
+
+void
+miniexact_algorithm_x_bitset_set(miniexact_algorithm* a) {
+  miniexact_algorithm_standard_functions(a);
+
+  a->compute_next_result = &compute_next_result;
+  a->free_userdata = &free_userdata;
+}
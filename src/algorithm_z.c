@@ -0,0 +1,514 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <miniexact/algorithm.h>
+#include <miniexact/algorithm_z.h>
+#include <miniexact/ops.h>
+
+// Sinks of the ZDD. Every other node has a label (a node of the matrix inside
+// the chosen option), a LO child (the option is not taken) and a HI child (the
+// option is taken). Children always have smaller ids than their parents.
+#define Z_BOT 0u
+#define Z_TOP 1u
+
+typedef struct zdd_node {
+  miniexact_link label;
+  uint32_t lo;
+  uint32_t hi;
+} zdd_node;
+
+typedef struct zdd_frame {
+  uint32_t node;
+  bool hi;
+} zdd_frame;
+
+typedef struct algorithm_z {
+  zdd_node* nodes;
+  size_t nodes_size;
+  size_t nodes_capacity;
+  uint32_t root;
+  uint32_t result;
+
+  // Memo from the set of uncovered items (a bitset of words words) to the ZDD
+  // node of the subproblem. Slots store entry index + 1, 0 marks empty slots.
+  size_t words;
+  uint64_t* keys;
+  uint32_t* values;
+  size_t entries_size;
+  size_t entries_capacity;
+  uint32_t* slots;
+  size_t slots_capacity;
+
+  // Per level of the search: the key of the subproblem and the ZDD of the
+  // options tried so far.
+  uint64_t* level_keys;
+  uint32_t* acc;
+  size_t levels_capacity;
+
+  // Enumeration of the paths to Z_TOP.
+  zdd_frame* path;
+  size_t path_size;
+  size_t path_capacity;
+} algorithm_z;
+
+typedef enum z_state { Z1, Z2, Z3, Z4, Z5, Z6, Z7, Z8, Z9, Z10 } z_state;
+
+static void*
+grow(void* ptr, size_t* capacity, size_t needed, size_t element_size) {
+  if(needed <= *capacity)
+    return ptr;
+  size_t c = *capacity ? *capacity : 64;
+  while(c < needed)
+    c *= 2;
+  void* n = realloc(ptr, c * element_size);
+  if(!n) {
+    fprintf(stderr, "Algorithm Z ran out of memory!\n");
+    abort();
+  }
+  *capacity = c;
+  return n;
+}
+
+static algorithm_z*
+get_z(miniexact_problem* p) {
+  if(!p->algorithm_userdata)
+    p->algorithm_userdata = calloc(1, sizeof(algorithm_z));
+  return p->algorithm_userdata;
+}
+
+static uint32_t
+make_node(algorithm_z* z, miniexact_link label, uint32_t lo, uint32_t hi) {
+  z->nodes =
+    grow(z->nodes, &z->nodes_capacity, z->nodes_size + 1, sizeof(zdd_node));
+  z->nodes[z->nodes_size] = (zdd_node){ label, lo, hi };
+  return z->nodes_size++;
+}
+
+static inline uint64_t*
+level_key(algorithm_z* z, miniexact_link l) {
+  return z->level_keys + (size_t)l * z->words;
+}
+
+static void
+compute_key(miniexact_problem* p, algorithm_z* z, uint64_t* key) {
+  memset(key, 0, z->words * sizeof(uint64_t));
+  for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i))
+    key[i / 64] |= UINT64_C(1) << (i % 64);
+  for(miniexact_link i = RLINK(p->N + 1); i != p->N + 1; i = RLINK(i))
+    key[i / 64] |= UINT64_C(1) << (i % 64);
+}
+
+static inline size_t
+hash_key(algorithm_z* z, const uint64_t* key) {
+  uint64_t h = UINT64_C(14695981039346656037);
+  for(size_t w = 0; w < z->words; ++w) {
+    h ^= key[w];
+    h *= UINT64_C(1099511628211);
+    h ^= h >> 29;
+  }
+  return h;
+}
+
+static inline uint32_t*
+memo_slot(algorithm_z* z, const uint64_t* key) {
+  size_t mask = z->slots_capacity - 1;
+  size_t s = hash_key(z, key) & mask;
+  while(z->slots[s]) {
+    const uint64_t* k = z->keys + (size_t)(z->slots[s] - 1) * z->words;
+    if(memcmp(k, key, z->words * sizeof(uint64_t)) == 0)
+      break;
+    s = (s + 1) & mask;
+  }
+  return &z->slots[s];
+}
+
+static void
+memo_rehash(algorithm_z* z, size_t capacity) {
+  free(z->slots);
+  z->slots = calloc(capacity, sizeof(uint32_t));
+  if(!z->slots) {
+    fprintf(stderr, "Algorithm Z ran out of memory!\n");
+    abort();
+  }
+  z->slots_capacity = capacity;
+  for(size_t e = 0; e < z->entries_size; ++e)
+    *memo_slot(z, z->keys + e * z->words) = e + 1;
+}
+
+static bool
+memo_find(algorithm_z* z, const uint64_t* key, uint32_t* value) {
+  uint32_t s = *memo_slot(z, key);
+  if(!s)
+    return false;
+  *value = z->values[s - 1];
+  return true;
+}
+
+static void
+memo_insert(algorithm_z* z, const uint64_t* key, uint32_t value) {
+  if((z->entries_size + 1) * 2 > z->slots_capacity)
+    memo_rehash(z, z->slots_capacity * 2);
+
+  // Keys and values grow together.
+  size_t capacity = z->entries_capacity;
+  z->values = grow(z->values, &capacity, z->entries_size + 1, sizeof(uint32_t));
+  capacity = z->entries_capacity;
+  z->keys = grow(
+    z->keys, &capacity, z->entries_size + 1, z->words * sizeof(uint64_t));
+  z->entries_capacity = capacity;
+
+  memcpy(
+    z->keys + z->entries_size * z->words, key, z->words * sizeof(uint64_t));
+  z->values[z->entries_size] = value;
+  *memo_slot(z, key) = ++z->entries_size;
+}
+
+static void
+path_push(algorithm_z* z, uint32_t node) {
+  z->path =
+    grow(z->path, &z->path_capacity, z->path_size + 1, sizeof(zdd_frame));
+  z->path[z->path_size++] = (zdd_frame){ node, true };
+}
+
+// Follows HI edges from n, which always end in Z_TOP. Returns the sink reached.
+static uint32_t
+path_descend(algorithm_z* z, uint32_t n) {
+  while(n > Z_TOP) {
+    path_push(z, n);
+    n = z->nodes[n].hi;
+  }
+  return n;
+}
+
+// Writes the options on the current path into x, so that the solution can be
+// printed like with the other algorithms.
+static void
+path_to_solution(miniexact_problem* p, algorithm_z* z) {
+  p->l = 0;
+  for(size_t i = 0; i < z->path_size; ++i)
+    if(z->path[i].hi)
+      p->x[p->l++] = z->nodes[z->path[i].node].label;
+  p->x_size = p->l;
+}
+
+static bool
+compute_next_result(miniexact_algorithm* a, miniexact_problem* p) {
+  if(p->x_capacity < p->option_count + 1) {
+    MINIEXACT_ARR_RESIZE(x, p->option_count + 1)
+    p->x_size = 0;
+  }
+
+  assert(a->choose_i);
+
+  algorithm_z* z = get_z(p);
+
+  while(true) {
+    switch(p->state) {
+      case Z1: {
+        miniexact_link i = 0;
+        do {
+          i = RLINK(i);
+          if(DLINK(i) == 0 && ULINK(i) == 0) {
+            fprintf(stderr, "Some item never occurs in the options!\n");
+            return false;
+          }
+        } while(RLINK(i) != 0);
+
+        for(miniexact_link n = p->N + 1; n < MINIEXACT_NODES_SIZE(p); ++n) {
+          if(COLOR(n) > 0) {
+            fprintf(stderr, "Algorithm Z does not support colors!\n");
+            return false;
+          }
+        }
+
+        z->words = (p->N + 64) / 64;
+        z->levels_capacity = p->option_count + 1;
+        z->level_keys = calloc(z->levels_capacity * z->words, sizeof(uint64_t));
+        z->acc = calloc(z->levels_capacity, sizeof(uint32_t));
+        z->nodes_size = 0;
+        make_node(z, 0, Z_BOT, Z_BOT);
+        make_node(z, 0, Z_TOP, Z_TOP);
+        memo_rehash(z, 1024);
+
+        p->l = 0;
+        p->state = Z2;
+        p->i = 0;
+        break;
+      }
+      case Z2:
+        if(RLINK(0) == 0) {
+          z->result = Z_TOP;
+          p->state = Z8;
+          break;
+        }
+        compute_key(p, z, level_key(z, p->l));
+        if(memo_find(z, level_key(z, p->l), &z->result)) {
+          p->state = Z8;
+          break;
+        }
+        p->state = Z3;
+        break;
+      case Z3:
+        p->i = a->choose_i(a, p, 0);
+        if(LEN(p->i) == 0) {
+          z->result = Z_BOT;
+          memo_insert(z, level_key(z, p->l), Z_BOT);
+          p->state = Z8;
+          break;
+        }
+        p->state = Z4;
+        break;
+      case Z4:
+        COVER(p->i);
+        p->x[p->l] = DLINK(p->i);
+        z->acc[p->l] = Z_BOT;
+        p->state = Z5;
+        break;
+      case Z5:
+        if(p->x[p->l] == p->i) {
+          p->state = Z7;
+          break;
+        }
+        p->p = p->x[p->l] + 1;
+        while(p->p != p->x[p->l]) {
+          miniexact_link j = TOP(p->p);
+          if(j <= 0) {
+            p->p = ULINK(p->p);
+          } else {
+            COVER(j);
+            p->p = p->p + 1;
+          }
+        }
+        STAT_NODE();
+        p->l = p->l + 1;
+        p->state = Z2;
+        break;
+      case Z6:
+        p->p = p->x[p->l] - 1;
+        while(p->p != p->x[p->l]) {
+          miniexact_link j = TOP(p->p);
+          if(j <= 0) {
+            p->p = DLINK(p->p);
+          } else {
+            UNCOVER(j);
+            p->p = p->p - 1;
+          }
+        }
+        if(z->result != Z_BOT)
+          z->acc[p->l] = make_node(z, p->x[p->l], z->acc[p->l], z->result);
+        p->i = TOP(p->x[p->l]);
+        p->x[p->l] = DLINK(p->x[p->l]);
+        p->state = Z5;
+        break;
+      case Z7:
+        UNCOVER(p->i);
+        z->result = z->acc[p->l];
+        memo_insert(z, level_key(z, p->l), z->result);
+        p->state = Z8;
+        break;
+      case Z8:
+        if(p->l == 0) {
+          z->root = z->result;
+          p->state = Z9;
+          break;
+        }
+        p->l = p->l - 1;
+        p->state = Z6;
+        break;
+      case Z9:
+        // The ZDD is complete, now visit the first path to Z_TOP.
+        p->state = Z10;
+        z->path_size = 0;
+        if(path_descend(z, z->root) != Z_TOP)
+          return false;
+        path_to_solution(p, z);
+        return true;
+      case Z10:
+        // Switch the deepest HI edge to LO and follow HI edges from there.
+        while(z->path_size > 0) {
+          zdd_frame* f = &z->path[z->path_size - 1];
+          if(!f->hi) {
+            --z->path_size;
+            continue;
+          }
+          f->hi = false;
+          if(path_descend(z, z->nodes[f->node].lo) == Z_TOP) {
+            path_to_solution(p, z);
+            return true;
+          }
+        }
+        return false;
+    }
+  }
+
+  return false;
+}
+
+static void
+free_userdata(miniexact_algorithm* a, miniexact_problem* p) {
+  (void)a;
+  algorithm_z* z = p->algorithm_userdata;
+  if(!z)
+    return;
+
+  free(z->nodes);
+  free(z->keys);
+  free(z->values);
+  free(z->slots);
+  free(z->level_keys);
+  free(z->acc);
+  free(z->path);
+  free(z);
+  p->algorithm_userdata = NULL;
+}
+
+static bool
+is_built(miniexact_problem* p) {
+  return p->algorithm_userdata && p->state >= Z9;
+}
+
+size_t
+miniexact_algorithm_z_size(miniexact_problem* p) {
+  if(!is_built(p))
+    return 0;
+  algorithm_z* z = p->algorithm_userdata;
+  return z->nodes_size;
+}
+
+// Counts are little endian numbers in base 2^32, all stored in one array.
+typedef struct z_count {
+  size_t offset;
+  size_t length;
+} z_count;
+
+char*
+miniexact_algorithm_z_count(miniexact_problem* p) {
+  if(!is_built(p))
+    return NULL;
+  algorithm_z* z = p->algorithm_userdata;
+
+  z_count* counts = malloc(z->nodes_size * sizeof(z_count));
+  uint32_t* limbs = NULL;
+  size_t limbs_size = 2, limbs_capacity = 0;
+  limbs = grow(limbs, &limbs_capacity, limbs_size, sizeof(uint32_t));
+  limbs[0] = 0;
+  limbs[1] = 1;
+  counts[Z_BOT] = (z_count){ 0, 1 };
+  counts[Z_TOP] = (z_count){ 1, 1 };
+
+  for(size_t n = 2; n < z->nodes_size; ++n) {
+    z_count lo = counts[z->nodes[n].lo], hi = counts[z->nodes[n].hi];
+    size_t length = (lo.length > hi.length ? lo.length : hi.length) + 1;
+    limbs = grow(limbs, &limbs_capacity, limbs_size + length, sizeof(uint32_t));
+
+    uint32_t* r = limbs + limbs_size;
+    uint64_t carry = 0;
+    for(size_t i = 0; i < length; ++i) {
+      uint64_t s = carry;
+      if(i < lo.length)
+        s += limbs[lo.offset + i];
+      if(i < hi.length)
+        s += limbs[hi.offset + i];
+      r[i] = (uint32_t)s;
+      carry = s >> 32;
+    }
+    while(length > 1 && r[length - 1] == 0)
+      --length;
+
+    counts[n] = (z_count){ limbs_size, length };
+    limbs_size += length;
+  }
+
+  // Repeated division by 10^9 yields the decimal digits in groups of nine.
+  z_count root = counts[z->root];
+  uint32_t* num = limbs + root.offset;
+  size_t length = root.length;
+  uint32_t* groups = malloc((length * 10 / 9 + 2) * sizeof(uint32_t));
+  size_t groups_size = 0;
+  do {
+    uint64_t rem = 0;
+    for(size_t i = length; i-- > 0;) {
+      uint64_t cur = (rem << 32) | num[i];
+      num[i] = cur / 1000000000u;
+      rem = cur % 1000000000u;
+    }
+    groups[groups_size++] = rem;
+    while(length > 0 && num[length - 1] == 0)
+      --length;
+  } while(length > 0);
+
+  char* str = malloc(groups_size * 9 + 1);
+  char* s = str;
+  s += sprintf(s, "%" PRIu32, groups[groups_size - 1]);
+  for(size_t g = groups_size - 1; g-- > 0;)
+    s += sprintf(s, "%09" PRIu32, groups[g]);
+
+  free(groups);
+  free(limbs);
+  free(counts);
+  return str;
+}
+
+static miniexact_link
+option_index(miniexact_problem* p, miniexact_link r) {
+  while(TOP(r) >= 0)
+    ++r;
+  return -TOP(r);
+}
+
+const char*
+miniexact_algorithm_z_write(miniexact_problem* p, const char* path) {
+  if(!is_built(p))
+    return "ZDD was not built yet";
+  algorithm_z* z = p->algorithm_userdata;
+
+  FILE* f = fopen(path, "w");
+  if(!f)
+    return strerror(errno);
+
+  fprintf(f, "zdd %zu %" PRIu32 "\n", z->nodes_size, z->root);
+  for(size_t n = 2; n < z->nodes_size; ++n) {
+    const zdd_node* d = &z->nodes[n];
+    fprintf(f,
+            "%zu %d %" PRIu32 " %" PRIu32 "\n",
+            n,
+            option_index(p, d->label),
+            d->lo,
+            d->hi);
+  }
+
+  if(fclose(f) != 0)
+    return strerror(errno);
+  return NULL;
+}
+
+void
+miniexact_algorithm_z_set(miniexact_algorithm* a) {
+  miniexact_algorithm_standard_functions(a);
+
+  a->compute_next_result = &compute_next_result;
+  a->choose_i = &miniexact_choose_i_mrv;
+  a->free_userdata = &free_userdata;
+}
@@ -0,0 +1,278 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <miniexact/algorithm.h>
+#include <miniexact/assume.h>
+#include <miniexact/cancel.h>
+#include <miniexact/ops.h>
+#include <miniexact/util.h>
+
+#define FORCED 1
+#define FORBIDDEN 2
+
+const char*
+miniexact_assumptions_init(miniexact_assumptions* s, miniexact_problem* p) {
+  assert(s);
+  assert(p);
+  memset(s, 0, sizeof(*s));
+
+  for(miniexact_link i = 1; i <= p->N_1; ++i)
+    if(BOUND(i) > 1 || (BOUND(i) == 1 && SLACK(i) > 0))
+      return "Assumptions are not supported for items with multiplicities!";
+
+  // The spacer after option k has TOP -k, also if preprocessing removed
+  // options before it.
+  for(miniexact_link x = p->N + 1; x <= p->Z; ++x)
+    if(TOP(x) <= 0)
+      s->options = MINIEXACT_MAX(s->options, -TOP(x));
+
+  s->first = calloc(s->options + 1, sizeof(miniexact_link));
+  s->mark = calloc(s->options + 1, sizeof(unsigned char));
+  s->forced = malloc((s->options + 1) * sizeof(miniexact_link));
+  s->forbidden = malloc((s->options + 1) * sizeof(miniexact_link));
+
+  for(miniexact_link x = p->N + 2; x <= p->Z; ++x) {
+    miniexact_link e = x;
+    while(TOP(e) > 0)
+      ++e;
+    if(e > x)
+      s->first[-TOP(e)] = x;
+    x = e;
+  }
+  return NULL;
+}
+
+// Options are committed like in step C5 of Algorithm C: the first primary item
+// is covered, which hides the option itself, and all other items are
+// committed.
+static miniexact_link
+first_primary(miniexact_problem* p, miniexact_link x) {
+  for(miniexact_link q = x; TOP(q) > 0; ++q)
+    if(TOP(q) <= p->N_1)
+      return q;
+  return 0;
+}
+
+static void
+force(miniexact_problem* p, miniexact_link x) {
+  miniexact_link f = first_primary(p, x);
+  if(f)
+    COVER_PRIME(TOP(f));
+  for(miniexact_link q = x; TOP(q) > 0; ++q)
+    if(q != f)
+      COMMIT(q, TOP(q));
+}
+
+static void
+unforce(miniexact_problem* p, miniexact_link x) {
+  miniexact_link f = first_primary(p, x);
+  miniexact_link e = x;
+  while(TOP(e) > 0)
+    ++e;
+  for(miniexact_link q = e - 1; q >= x; --q)
+    if(q != f)
+      UNCOMMIT(q, TOP(q));
+  if(f)
+    UNCOVER_PRIME(TOP(f));
+}
+
+// An option can still be chosen if all its items are active and it was not
+// hidden from any of them. Nodes that were purified to the color of an earlier
+// option are compatible.
+static bool
+available(miniexact_problem* p, miniexact_link x) {
+  for(miniexact_link q = x; TOP(q) > 0; ++q) {
+    if(COLOR(q) < 0)
+      continue;
+    miniexact_link j = TOP(q);
+    if(RLINK(LLINK(j)) != j || DLINK(ULINK(q)) != q)
+      return false;
+  }
+  return true;
+}
+
+static void
+forbid(miniexact_problem* p, miniexact_link x) {
+  for(miniexact_link q = x; TOP(q) > 0; ++q) {
+    // Nodes of detached secondary items are linked to themselves.
+    if(ULINK(q) == q)
+      continue;
+    miniexact_link j = TOP(q);
+    DLINK(ULINK(q)) = DLINK(q);
+    ULINK(DLINK(q)) = ULINK(q);
+    LEN(j) = LEN(j) - 1;
+    BUCKET_UPDATE(j);
+  }
+}
+
+static void
+unforbid(miniexact_problem* p, miniexact_link x) {
+  miniexact_link e = x;
+  while(TOP(e) > 0)
+    ++e;
+  for(miniexact_link q = e - 1; q >= x; --q) {
+    if(ULINK(q) == q)
+      continue;
+    miniexact_link j = TOP(q);
+    DLINK(ULINK(q)) = q;
+    ULINK(DLINK(q)) = q;
+    LEN(j) = LEN(j) + 1;
+  }
+}
+
+// Cancels the search with a handle that is already requested, so the engine
+// refuses every descent and backtracks to the root.
+static void
+backtrack_to_root(miniexact_algorithm* a, miniexact_problem* p) {
+  if(p->state == 0)
+    return;
+  miniexact_cancel* c = miniexact_cancel_new();
+  miniexact_cancel_set_progress(c, NULL, 1, NULL);
+  miniexact_cancel_request(c);
+  miniexact_cancel* previous = p->cancel;
+  p->cancel = c;
+  while(a->compute_next_result(a, p))
+    ;
+  p->cancel = previous;
+  miniexact_cancel_free(c);
+  p->state = 0;
+}
+
+void
+miniexact_assumptions_undo(miniexact_assumptions* s,
+                           miniexact_algorithm* a,
+                           miniexact_problem* p) {
+  assert(s);
+  assert(a);
+  assert(p);
+  backtrack_to_root(a, p);
+
+  // Buckets are sized for the longest active item when they are built, which
+  // may have been shortened or covered by the assumptions. They are built
+  // again when the next search chooses an item.
+  if(p->bucket_next && (s->forced_size || s->forbidden_size)) {
+    miniexact_free(p->bucket_next);
+    miniexact_free(p->bucket_prev);
+    p->bucket_next = NULL;
+    p->bucket_prev = NULL;
+    p->bucket_next_size = p->bucket_next_capacity = 0;
+    p->bucket_prev_size = p->bucket_prev_capacity = 0;
+  }
+
+  while(s->forced_size) {
+    miniexact_link o = s->forced[--s->forced_size];
+    unforce(p, s->first[o]);
+    s->mark[o] = 0;
+  }
+  while(s->forbidden_size) {
+    miniexact_link o = s->forbidden[--s->forbidden_size];
+    unforbid(p, s->first[o]);
+    s->mark[o] = 0;
+  }
+  // Conflicting and removed options were only marked.
+  if(s->mark)
+    memset(s->mark, 0, s->options + 1);
+  s->conflict = false;
+}
+
+void
+miniexact_assumptions_free(miniexact_assumptions* s,
+                           miniexact_algorithm* a,
+                           miniexact_problem* p) {
+  assert(s);
+  miniexact_assumptions_undo(s, a, p);
+  free(s->first);
+  free(s->mark);
+  free(s->forced);
+  free(s->forbidden);
+  memset(s, 0, sizeof(*s));
+}
+
+const char*
+miniexact_assume(miniexact_assumptions* s,
+                 miniexact_algorithm* a,
+                 miniexact_problem* p,
+                 const miniexact_link* force_,
+                 size_t force_count,
+                 const miniexact_link* forbid_,
+                 size_t forbid_count) {
+  assert(s);
+  assert(a);
+  assert(p);
+  miniexact_assumptions_undo(s, a, p);
+
+  for(size_t k = 0; k < force_count; ++k)
+    if(force_[k] < 1 || force_[k] > s->options)
+      return "Unknown option index given to force!";
+  for(size_t k = 0; k < forbid_count; ++k)
+    if(forbid_[k] < 1 || forbid_[k] > s->options)
+      return "Unknown option index given to forbid!";
+
+  // Forbidding first lets forced options check that they are still allowed.
+  for(size_t k = 0; k < forbid_count; ++k) {
+    miniexact_link o = forbid_[k];
+    if(s->mark[o])
+      continue;
+    s->mark[o] = FORBIDDEN;
+    // Options removed by preprocessing are never chosen anyway.
+    if(!s->first[o])
+      continue;
+    forbid(p, s->first[o]);
+    s->forbidden[s->forbidden_size++] = o;
+  }
+
+  for(size_t k = 0; k < force_count && !s->conflict; ++k) {
+    miniexact_link o = force_[k];
+    if(s->mark[o] == FORCED)
+      continue;
+    if(s->mark[o] == FORBIDDEN || !s->first[o] || !available(p, s->first[o])) {
+      s->conflict = true;
+      break;
+    }
+    s->mark[o] = FORCED;
+    force(p, s->first[o]);
+    s->forced[s->forced_size++] = o;
+  }
+
+  p->state = 0;
+  return NULL;
+}
+
+int
+miniexact_assumptions_solve(miniexact_assumptions* s,
+                            miniexact_algorithm* a,
+                            miniexact_problem* p) {
+  assert(s);
+  if(s->conflict)
+    return 20;
+  return miniexact_solve_problem(a, p);
+}
+
+miniexact_link
+miniexact_assumptions_extract_solution(const miniexact_assumptions* s,
+                                       miniexact_problem* p,
+                                       miniexact_link* solution) {
+  assert(s);
+  assert(solution);
+  memcpy(solution, s->forced, s->forced_size * sizeof(miniexact_link));
+  return s->forced_size +
+         miniexact_extract_solution_option_indices(p, solution + s->forced_size);
+}
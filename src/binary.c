@@ -0,0 +1,422 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <miniexact/algorithm.h>
+#include <miniexact/binary.h>
+#include <miniexact/log.h>
+#include <miniexact/miniexact.h>
+
+#define BINARY_VERSION 1
+#define BINARY_BYTE_ORDER 0x01020304u
+#define BINARY_FLAG_INTERLEAVED_NODES (1u << 0)
+
+// Sections are aligned to cache lines.
+#define BINARY_ALIGN 64
+
+typedef enum section_id {
+  SEC_LLINK,
+  SEC_RLINK,
+  SEC_ULINK,
+  SEC_DLINK,
+  SEC_TOP,
+  SEC_COLOR,
+  SEC_NODE,
+  SEC_COST,
+  SEC_SLACK,
+  SEC_BOUND,
+  SEC_NAME_OFFSETS,
+  SEC_NAME_DATA,
+  SEC_NAME_INDEX,
+  SEC_COLOR_NAME_OFFSETS,
+  SEC_COLOR_NAME_DATA,
+  SEC_COLOR_NAME_INDEX,
+  SEC_COUNT
+} section_id;
+
+typedef struct section {
+  uint64_t offset;
+  uint64_t count;
+} section;
+
+typedef struct header {
+  char magic[MINIEXACT_BINARY_MAGIC_LEN];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t flags;
+
+  int32_t N, N_1, M, Z;
+  int32_t primary_item_count;
+  int32_t secondary_item_count;
+  int32_t option_count;
+  int32_t longest_option;
+  int32_t max_option_cost;
+
+  uint64_t name_index_count;
+  uint64_t color_name_index_count;
+
+  section sections[SEC_COUNT];
+} header;
+
+static size_t
+element_size(section_id s) {
+  switch(s) {
+    case SEC_NODE:
+#ifdef MINIEXACT_INTERLEAVED_NODES
+      return sizeof(miniexact_node);
+#else
+      return 0;
+#endif
+    case SEC_NAME_OFFSETS:
+    case SEC_COLOR_NAME_OFFSETS:
+      return sizeof(int64_t);
+    case SEC_NAME_DATA:
+    case SEC_COLOR_NAME_DATA:
+      return sizeof(char);
+    default:
+      return sizeof(miniexact_link);
+  }
+}
+
+static uint32_t
+layout_flags(void) {
+#ifdef MINIEXACT_INTERLEAVED_NODES
+  return BINARY_FLAG_INTERLEAVED_NODES;
+#else
+  return 0;
+#endif
+}
+
+typedef struct writer {
+  FILE* f;
+  uint64_t pos;
+  header* h;
+} writer;
+
+static bool
+begin_section(writer* w, section_id s, uint64_t count) {
+  while(w->pos % BINARY_ALIGN) {
+    if(fputc(0, w->f) == EOF)
+      return false;
+    ++w->pos;
+  }
+  w->h->sections[s].offset = w->pos;
+  w->h->sections[s].count = count;
+  return true;
+}
+
+static bool
+write_section(writer* w, section_id s, const void* data, uint64_t count) {
+  if(!begin_section(w, s, count))
+    return false;
+  size_t size = element_size(s);
+  if(count && fwrite(data, size, count, w->f) != count)
+    return false;
+  w->pos += size * count;
+  return true;
+}
+
+static bool
+write_names(writer* w,
+            section_id offsets_id,
+            section_id data_id,
+            const miniexact_name* names,
+            size_t names_size) {
+  if(!begin_section(w, offsets_id, names_size))
+    return false;
+  int64_t offset = 0;
+  for(size_t i = 0; i < names_size; ++i) {
+    int64_t o = names[i] ? offset : -1;
+    if(fwrite(&o, sizeof(o), 1, w->f) != 1)
+      return false;
+    if(names[i])
+      offset += strlen(names[i]) + 1;
+  }
+  w->pos += sizeof(int64_t) * names_size;
+
+  if(!begin_section(w, data_id, offset))
+    return false;
+  for(size_t i = 0; i < names_size; ++i) {
+    if(!names[i])
+      continue;
+    size_t len = strlen(names[i]) + 1;
+    if(fwrite(names[i], 1, len, w->f) != len)
+      return false;
+  }
+  w->pos += offset;
+  return true;
+}
+
+const char*
+miniexact_write_problem_binary(miniexact_problem* p, const char* path) {
+  assert(p);
+  assert(path);
+
+  if(p->state != 0)
+    return "cannot write a problem that is being searched";
+
+  header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, MINIEXACT_BINARY_MAGIC, MINIEXACT_BINARY_MAGIC_LEN);
+  h.version = BINARY_VERSION;
+  h.byte_order = BINARY_BYTE_ORDER;
+  h.flags = layout_flags();
+  h.N = p->N;
+  h.N_1 = p->N_1;
+  h.M = p->M;
+  h.Z = p->Z;
+  h.primary_item_count = p->primary_item_count;
+  h.secondary_item_count = p->secondary_item_count;
+  h.option_count = p->option_count;
+  h.longest_option = p->longest_option;
+  h.max_option_cost = p->max_option_cost;
+  h.name_index_count = p->name_index.count;
+  h.color_name_index_count = p->color_name_index.count;
+
+  writer w = { fopen(path, "wb"), 0, &h };
+  if(!w.f)
+    return strerror(errno);
+
+  // Header is written again once all offsets are known.
+  bool ok = fwrite(&h, sizeof(h), 1, w.f) == 1;
+  w.pos = sizeof(h);
+
+  ok = ok && write_section(&w, SEC_LLINK, p->llink, p->llink_size);
+  ok = ok && write_section(&w, SEC_RLINK, p->rlink, p->rlink_size);
+#ifdef MINIEXACT_INTERLEAVED_NODES
+  ok = ok && write_section(&w, SEC_NODE, p->node, p->node_size);
+#else
+  ok = ok && write_section(&w, SEC_ULINK, p->ulink, p->ulink_size);
+  ok = ok && write_section(&w, SEC_DLINK, p->dlink, p->dlink_size);
+  ok = ok && write_section(&w, SEC_TOP, p->top, p->top_size);
+  ok = ok && write_section(&w, SEC_COLOR, p->color, p->color_size);
+#endif
+  ok = ok && write_section(&w, SEC_COST, p->cost, p->cost_size);
+  ok = ok && write_section(&w, SEC_SLACK, p->slack, p->slack_size);
+  ok = ok && write_section(&w, SEC_BOUND, p->bound, p->bound_size);
+  ok = ok && write_names(&w, SEC_NAME_OFFSETS, SEC_NAME_DATA, p->name,
+                         p->name_size);
+  ok = ok && write_section(&w, SEC_NAME_INDEX, p->name_index.slots,
+                           p->name_index.capacity);
+  ok = ok && write_names(&w, SEC_COLOR_NAME_OFFSETS, SEC_COLOR_NAME_DATA,
+                         p->color_name, p->color_name_size);
+  ok = ok && write_section(&w, SEC_COLOR_NAME_INDEX,
+                           p->color_name_index.slots,
+                           p->color_name_index.capacity);
+
+  ok = ok && fseek(w.f, 0, SEEK_SET) == 0;
+  ok = ok && fwrite(&h, sizeof(h), 1, w.f) == 1;
+
+  if(fclose(w.f) != 0)
+    ok = false;
+
+  return ok ? NULL : "could not write binary problem file";
+}
+
+bool
+miniexact_is_problem_binary(const char* buf, size_t len) {
+  return len >= MINIEXACT_BINARY_MAGIC_LEN &&
+         memcmp(buf, MINIEXACT_BINARY_MAGIC, MINIEXACT_BINARY_MAGIC_LEN) == 0;
+}
+
+static const char*
+check_sections(const header* h, size_t size) {
+  for(int s = 0; s < SEC_COUNT; ++s) {
+    const section* sec = &h->sections[s];
+    if(!sec->count)
+      continue;
+    size_t elem = element_size(s);
+    if(!elem)
+      return "section not supported by this build";
+    if(sec->offset % BINARY_ALIGN || sec->offset > size ||
+       sec->count > (size - sec->offset) / elem)
+      return "section out of bounds";
+  }
+  return NULL;
+}
+
+static const char*
+map_names(miniexact_problem* p,
+          const header* h,
+          section_id offsets_id,
+          section_id data_id,
+          miniexact_name** names,
+          size_t* names_size) {
+  const section* offsets_sec = &h->sections[offsets_id];
+  const section* data_sec = &h->sections[data_id];
+  const int64_t* offsets =
+    (const int64_t*)((char*)p->mapped + offsets_sec->offset);
+  char* data = (char*)p->mapped + data_sec->offset;
+
+  if(data_sec->count && data[data_sec->count - 1] != '\0')
+    return "name data not terminated";
+
+  *names_size = offsets_sec->count;
+  *names = miniexact_malloc(sizeof(miniexact_name) * offsets_sec->count);
+  for(size_t i = 0; i < offsets_sec->count; ++i) {
+    if(offsets[i] < 0)
+      (*names)[i] = NULL;
+    else if((uint64_t)offsets[i] >= data_sec->count)
+      return "name offset out of bounds";
+    else
+      (*names)[i] = data + offsets[i];
+  }
+  return NULL;
+}
+
+static void
+map_index(miniexact_problem* p,
+          const header* h,
+          section_id id,
+          miniexact_name_index* index,
+          size_t count) {
+  const section* sec = &h->sections[id];
+  index->slots =
+    sec->count ? (miniexact_link*)((char*)p->mapped + sec->offset) : NULL;
+  index->capacity = sec->count;
+  index->count = count;
+}
+
+#define MAP(ARR, SEC)                                                      \
+  p->ARR = h->sections[SEC].count                                          \
+             ? (void*)((char*)p->mapped + h->sections[SEC].offset)        \
+             : NULL;                                                       \
+  p->ARR##_size = h->sections[SEC].count;                                  \
+  p->ARR##_capacity = h->sections[SEC].count;
+
+miniexact_problem*
+miniexact_load_problem_binary(miniexact_algorithm* a, const char* path) {
+  const char* error = NULL;
+  miniexact_problem* p = NULL;
+
+  int fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    miniexact_err("Could not open file %s, error: %s", path, strerror(errno));
+    return NULL;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header)) {
+    close(fd);
+    miniexact_err("Binary problem file %s too small", path);
+    return NULL;
+  }
+
+  // Private writable mapping: The search modifies the links in place, which
+  // only copies the touched pages and never writes back to the file.
+  void* m =
+    mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(m == MAP_FAILED) {
+    miniexact_err("Could not map file %s, error: %s", path, strerror(errno));
+    return NULL;
+  }
+
+  p = miniexact_problem_allocate();
+  p->mapped = m;
+  p->mapped_size = st.st_size;
+
+  const header* h = m;
+  if(!miniexact_is_problem_binary(m, st.st_size)) {
+    error = "not a binary problem file";
+    goto ERROR;
+  }
+  if(h->version != BINARY_VERSION) {
+    error = "unsupported binary format version";
+    goto ERROR;
+  }
+  if(h->byte_order != BINARY_BYTE_ORDER) {
+    error = "binary problem file was written with a different byte order";
+    goto ERROR;
+  }
+  if(h->flags != layout_flags()) {
+    error = "binary problem file was written with a different node layout";
+    goto ERROR;
+  }
+  if((error = check_sections(h, st.st_size)))
+    goto ERROR;
+
+  MAP(llink, SEC_LLINK)
+  MAP(rlink, SEC_RLINK)
+#ifdef MINIEXACT_INTERLEAVED_NODES
+  MAP(node, SEC_NODE)
+#else
+  MAP(ulink, SEC_ULINK)
+  MAP(dlink, SEC_DLINK)
+  MAP(top, SEC_TOP)
+  MAP(color, SEC_COLOR)
+#endif
+  MAP(cost, SEC_COST)
+  MAP(slack, SEC_SLACK)
+  MAP(bound, SEC_BOUND)
+
+  if((error = map_names(
+        p, h, SEC_NAME_OFFSETS, SEC_NAME_DATA, &p->name, &p->name_size)))
+    goto ERROR;
+  p->name_capacity = p->name_size;
+  if((error = map_names(p,
+                        h,
+                        SEC_COLOR_NAME_OFFSETS,
+                        SEC_COLOR_NAME_DATA,
+                        &p->color_name,
+                        &p->color_name_size)))
+    goto ERROR;
+  p->color_name_capacity = p->color_name_size;
+
+  map_index(p, h, SEC_NAME_INDEX, &p->name_index, h->name_index_count);
+  map_index(p,
+            h,
+            SEC_COLOR_NAME_INDEX,
+            &p->color_name_index,
+            h->color_name_index_count);
+
+  p->N = h->N;
+  p->N_1 = h->N_1;
+  p->M = h->M;
+  p->Z = h->Z;
+  p->i = h->N;
+  p->primary_item_count = h->primary_item_count;
+  p->secondary_item_count = h->secondary_item_count;
+  p->option_count = h->option_count;
+  p->longest_option = h->longest_option;
+  p->max_option_cost = h->max_option_cost;
+  p->state = 0;
+
+  // Search state is never stored, it is allocated freshly.
+  MINIEXACT_ARR_ALLOC(miniexact_link, x)
+  MINIEXACT_ARR_ALLOC(miniexact_link, ft)
+  MINIEXACT_ARR_ALLOC(int32_t, best)
+  MINIEXACT_ARR_ALLOC(int32_t, tho)
+  MINIEXACT_ARR_ALLOC(int32_t, th)
+
+  return p;
+ERROR:
+  miniexact_err("Could not load binary problem file %s: %s", path, error);
+  miniexact_problem_free(p, a);
+  return NULL;
+}
+
+#undef MAP
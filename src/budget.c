@@ -0,0 +1,159 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__unix__)
+#include <unistd.h>
+#endif
+
+#include <miniexact/budget.h>
+#include <miniexact/util.h>
+
+// Reading the clock or the memory usage on every node would be measurable in
+// small subtrees.
+#define NODES_PER_CHECK 1024
+
+bool
+miniexact_budget_configured(const miniexact_config* cfg) {
+  return cfg->time_limit > 0 || cfg->node_limit > 0 ||
+         cfg->solution_limit > 0 || cfg->memory_limit > 0;
+}
+
+void
+miniexact_budget_init(miniexact_budget* b,
+                      miniexact_problem* p,
+                      const miniexact_config* cfg) {
+  assert(b);
+  assert(p);
+  assert(cfg);
+  memset(b, 0, sizeof(*b));
+  b->time_limit = cfg->time_limit;
+  b->node_limit = cfg->node_limit > 0 ? (uint64_t)cfg->node_limit : 0;
+  b->solution_limit = cfg->solution_limit;
+  b->memory_limit = cfg->memory_limit > 0
+                      ? (size_t)cfg->memory_limit * 1024 * 1024
+                      : 0;
+  if(b->memory_limit)
+    b->memory_base = miniexact_current_memory();
+  b->start = miniexact_seconds();
+  p->budget = b;
+}
+
+bool
+miniexact_budget_descend(miniexact_budget* b) {
+  if(b->replayed) {
+    --b->replayed;
+    return true;
+  }
+  if(b->node_limit && b->nodes >= b->node_limit) {
+    b->exhausted = MINIEXACT_BUDGET_NODES;
+    return false;
+  }
+  ++b->nodes;
+  if(b->nodes % NODES_PER_CHECK != 0)
+    return true;
+
+  if(b->time_limit > 0 && miniexact_seconds() - b->start >= b->time_limit) {
+    b->exhausted = MINIEXACT_BUDGET_TIME;
+    return false;
+  }
+  if(b->memory_limit) {
+    size_t memory = miniexact_current_memory();
+    if(memory > b->memory_base && memory - b->memory_base > b->memory_limit) {
+      b->exhausted = MINIEXACT_BUDGET_MEMORY;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+miniexact_budget_solution(miniexact_budget* b) {
+  ++b->solutions;
+  if(b->solution_limit > 0 && b->solutions >= b->solution_limit) {
+    b->exhausted = MINIEXACT_BUDGET_SOLUTIONS;
+    return false;
+  }
+  return true;
+}
+
+void
+miniexact_budget_print(const miniexact_budget* b, FILE* f) {
+  const char* limit = "";
+  switch(b->exhausted) {
+    case MINIEXACT_BUDGET_NONE:
+      return;
+    case MINIEXACT_BUDGET_TIME:
+      limit = "time";
+      break;
+    case MINIEXACT_BUDGET_NODES:
+      limit = "node";
+      break;
+    case MINIEXACT_BUDGET_SOLUTIONS:
+      limit = "solution";
+      break;
+    case MINIEXACT_BUDGET_MEMORY:
+      limit = "memory";
+      break;
+  }
+  fprintf(f,
+          "Stopped by the %s limit after %" PRIu64
+          " nodes, %lld solutions and %.3fs.\n",
+          limit,
+          b->nodes,
+          b->solutions,
+          miniexact_seconds() - b->start);
+}
+
+void
+miniexact_budget_finish(miniexact_budget* b, miniexact_problem* p) {
+  assert(b);
+  p->budget = NULL;
+}
+
+size_t
+miniexact_current_memory(void) {
+#if defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if(task_info(mach_task_self(),
+               MACH_TASK_BASIC_INFO,
+               (task_info_t)&info,
+               &count) != KERN_SUCCESS)
+    return 0;
+  return (size_t)info.resident_size;
+#elif defined(__unix__)
+  // The second field is the number of resident pages.
+  FILE* f = fopen("/proc/self/statm", "r");
+  if(!f)
+    return 0;
+  unsigned long size, resident;
+  int fields = fscanf(f, "%lu %lu", &size, &resident);
+  fclose(f);
+  if(fields != 2)
+    return 0;
+  return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
@@ -0,0 +1,108 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include <miniexact/cancel.h>
+
+struct miniexact_cancel {
+  atomic_bool requested;
+
+  // Set once the engine noticed the request and backtracks to the root.
+  bool stopping;
+
+  uint64_t nodes;
+  unsigned int interval;
+  unsigned int countdown;
+  miniexact_progress_callback progress;
+  void* userdata;
+};
+
+miniexact_cancel*
+miniexact_cancel_new(void) {
+  miniexact_cancel* c = calloc(1, sizeof(miniexact_cancel));
+  atomic_init(&c->requested, false);
+  c->interval = MINIEXACT_CANCEL_DEFAULT_INTERVAL;
+  c->countdown = c->interval;
+  return c;
+}
+
+void
+miniexact_cancel_free(miniexact_cancel* c) {
+  free(c);
+}
+
+void
+miniexact_cancel_request(miniexact_cancel* c) {
+  assert(c);
+  atomic_store(&c->requested, true);
+}
+
+bool
+miniexact_cancel_requested(miniexact_cancel* c) {
+  assert(c);
+  return atomic_load(&c->requested);
+}
+
+bool
+miniexact_cancel_stopped(miniexact_cancel* c) {
+  assert(c);
+  return c->stopping;
+}
+
+void
+miniexact_cancel_reset(miniexact_cancel* c) {
+  assert(c);
+  atomic_store(&c->requested, false);
+  c->stopping = false;
+  c->nodes = 0;
+  c->countdown = c->interval;
+}
+
+void
+miniexact_cancel_set_progress(miniexact_cancel* c,
+                              miniexact_progress_callback progress,
+                              unsigned int interval,
+                              void* userdata) {
+  assert(c);
+  c->progress = progress;
+  c->userdata = userdata;
+  if(interval > 0)
+    c->interval = interval;
+  c->countdown = c->interval;
+}
+
+bool
+miniexact_cancel_descend(miniexact_cancel* c, miniexact_problem* p) {
+  if(c->stopping)
+    return false;
+
+  ++c->nodes;
+  if(--c->countdown > 0)
+    return true;
+  c->countdown = c->interval;
+
+  if(c->progress && !c->progress(p, c->nodes, c->userdata))
+    atomic_store(&c->requested, true);
+  if(atomic_load_explicit(&c->requested, memory_order_relaxed)) {
+    c->stopping = true;
+    return false;
+  }
+  return true;
+}
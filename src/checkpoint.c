@@ -0,0 +1,210 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <miniexact/budget.h>
+#include <miniexact/checkpoint.h>
+#include <miniexact/log.h>
+#include <miniexact/miniexact.h>
+
+#define CHECKPOINT_MAGIC "miniexact-checkpoint"
+#define CHECKPOINT_VERSION 2
+
+// Reading the clock on every descent would be measurable in small subtrees.
+#define DESCENTS_PER_CLOCK_CHECK 1024
+
+static void
+write_checkpoint(miniexact_checkpoint* c,
+                 miniexact_problem* p,
+                 bool skip_solution) {
+  // Everything reported so far has to be on disk before the checkpoint says
+  // so, otherwise these solutions are lost when resuming.
+  fflush(stdout);
+
+  size_t len = strlen(c->path);
+  char tmp[len + 5];
+  memcpy(tmp, c->path, len);
+  memcpy(tmp + len, ".tmp", 5);
+
+  FILE* f = fopen(tmp, "w");
+  if(!f) {
+    miniexact_err(
+      "Could not write checkpoint %s, error: %s", tmp, strerror(errno));
+    return;
+  }
+
+  fprintf(f, "%s %d\n", CHECKPOINT_MAGIC, CHECKPOINT_VERSION);
+  fprintf(f,
+          "%d %d %d %d %d\n",
+          c->algorithm_select,
+          p->N,
+          p->N_1,
+          p->Z,
+          p->option_count);
+  fprintf(f, "%lld %d %d\n", c->solutions, p->l + 1, skip_solution);
+  for(miniexact_link l = 0; l <= p->l; ++l)
+    fprintf(f, "%d\n", p->x[l]);
+
+  bool ok = !ferror(f);
+  if(fclose(f) != 0)
+    ok = false;
+  if(!ok || rename(tmp, c->path) != 0) {
+    miniexact_err(
+      "Could not write checkpoint %s, error: %s", c->path, strerror(errno));
+    remove(tmp);
+  }
+}
+
+static const char*
+read_checkpoint(miniexact_checkpoint* c, miniexact_problem* p, FILE* f) {
+  int version;
+  if(fscanf(f, CHECKPOINT_MAGIC " %d", &version) != 1)
+    return "Not a checkpoint file!";
+  if(version != CHECKPOINT_VERSION)
+    return "Unsupported checkpoint version!";
+
+  int algorithm_select, N, N_1, Z, option_count;
+  if(fscanf(f, "%d %d %d %d %d", &algorithm_select, &N, &N_1, &Z, &option_count)
+     != 5)
+    return "Truncated checkpoint file!";
+  if(algorithm_select != c->algorithm_select)
+    return "Checkpoint was written with different algorithm selectors!";
+  if(N != p->N || N_1 != p->N_1 || Z != p->Z || option_count != p->option_count)
+    return "Checkpoint belongs to a different problem!";
+
+  miniexact_link depth;
+  int skip_solution;
+  if(fscanf(f, "%lld %d %d", &c->solutions, &depth, &skip_solution) != 3 ||
+     depth < 1)
+    return "Truncated checkpoint file!";
+  c->skip_solution = skip_solution;
+
+  c->replay = malloc(depth * sizeof(miniexact_link));
+  for(miniexact_link l = 0; l < depth; ++l) {
+    if(fscanf(f, "%d", &c->replay[l]) != 1)
+      return "Truncated checkpoint file!";
+    if(c->replay[l] <= 0 || c->replay[l] > p->Z)
+      return "Checkpoint belongs to a different problem!";
+  }
+  c->replay_size = depth;
+  return NULL;
+}
+
+const char*
+miniexact_checkpoint_init(miniexact_checkpoint* c,
+                          miniexact_problem* p,
+                          miniexact_config* cfg) {
+  assert(c);
+  assert(p);
+  assert(cfg);
+  assert(cfg->checkpoint);
+
+  memset(c, 0, sizeof(*c));
+  c->path = cfg->checkpoint;
+  c->interval = cfg->checkpoint_interval > 0
+                  ? cfg->checkpoint_interval
+                  : MINIEXACT_CHECKPOINT_DEFAULT_INTERVAL;
+  c->last_write = time(NULL);
+  c->algorithm_select = cfg->algorithm_select;
+
+  if(cfg->resume) {
+    // Nothing to resume on the first run of a job.
+    FILE* f = fopen(c->path, "r");
+    if(f) {
+      const char* error = read_checkpoint(c, p, f);
+      fclose(f);
+      if(error) {
+        free(c->replay);
+        c->replay = NULL;
+        c->replay_size = 0;
+        return error;
+      }
+    }
+  }
+
+  p->checkpoint = c;
+  return NULL;
+}
+
+bool
+miniexact_checkpoint_descend(miniexact_checkpoint* c, miniexact_problem* p) {
+  if(c->replay_size) {
+    assert(p->l < c->replay_size);
+    if(p->x[p->l] != c->replay[p->l])
+      return false;
+    // Replaying must progress even with a node limit below its depth.
+    if(p->budget)
+      ++p->budget->replayed;
+    if(p->l + 1 == c->replay_size) {
+      free(c->replay);
+      c->replay = NULL;
+      c->replay_size = 0;
+    }
+    return true;
+  }
+
+  if(++c->descents % DESCENTS_PER_CLOCK_CHECK == 0) {
+    time_t now = time(NULL);
+    if(now - c->last_write >= c->interval) {
+      write_checkpoint(c, p, false);
+      c->last_write = now;
+    }
+  }
+  return true;
+}
+
+bool
+miniexact_checkpoint_solution(miniexact_checkpoint* c) {
+  if(!c->skip_solution)
+    return true;
+  c->skip_solution = false;
+  return false;
+}
+
+void
+miniexact_checkpoint_finish(miniexact_checkpoint* c, miniexact_problem* p) {
+  assert(c);
+  free(c->replay);
+  c->replay = NULL;
+  c->replay_size = 0;
+  remove(c->path);
+  p->checkpoint = NULL;
+}
+
+void
+miniexact_checkpoint_suspend(miniexact_checkpoint* c, miniexact_problem* p) {
+  assert(c);
+
+  // The stack up to level l - 1 leads back into the current node. A replay
+  // that did not catch up yet still has the older checkpoint on disk.
+  if(p->l > 0 && !c->replay_size) {
+    miniexact_link l = p->l;
+    p->l = l - 1;
+    write_checkpoint(c, p, c->skip_solution);
+    p->l = l;
+  }
+
+  free(c->replay);
+  c->replay = NULL;
+  c->replay_size = 0;
+  p->checkpoint = NULL;
+}
@@ -0,0 +1,280 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <miniexact/algorithm.h>
+#include <miniexact/components.h>
+#include <miniexact/ops.h>
+
+typedef struct components_search {
+  miniexact_problem* p;
+  // Union-find forest over all items, rebuilt at every node.
+  miniexact_link* parent;
+  // Stop at the first solution and keep its options in x.
+  bool first;
+  bool overflow;
+} components_search;
+
+typedef struct component_item {
+  miniexact_link root;
+  miniexact_link item;
+} component_item;
+
+static miniexact_link
+find(miniexact_link* parent, miniexact_link i) {
+  while(parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+static void
+unite(miniexact_link* parent, miniexact_link a, miniexact_link b) {
+  a = find(parent, a);
+  b = find(parent, b);
+  if(a != b)
+    parent[a] = b;
+}
+
+// Unites all items that occur in the same active option. Purified secondary
+// items (COLOR < 0) no longer connect anything, as all their remaining
+// options agree on the color. Returns the number of components.
+static miniexact_link
+connect(miniexact_problem* p, miniexact_link* parent) {
+  for(miniexact_link i = 0; i <= p->N; ++i)
+    parent[i] = i;
+
+  for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i)) {
+    for(miniexact_link q = DLINK(i); q != i; q = DLINK(q)) {
+      miniexact_link r = q + 1;
+      while(r != q) {
+        miniexact_link j = TOP(r);
+        if(j <= 0) {
+          r = ULINK(r);
+        } else {
+          if(COLOR(r) >= 0)
+            unite(parent, i, j);
+          ++r;
+        }
+      }
+    }
+  }
+
+  miniexact_link components = 0;
+  for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i))
+    if(find(parent, i) == i)
+      ++components;
+  return components;
+}
+
+static int
+compare_component_items(const void* a, const void* b) {
+  const component_item* l = a;
+  const component_item* r = b;
+  if(l->root != r->root)
+    return l->root < r->root ? -1 : 1;
+  return l->item < r->item ? -1 : l->item > r->item;
+}
+
+static uint64_t
+add(components_search* s, uint64_t a, uint64_t b) {
+  if(a > UINT64_MAX - b) {
+    s->overflow = true;
+    return UINT64_MAX;
+  }
+  return a + b;
+}
+
+static uint64_t
+mul(components_search* s, uint64_t a, uint64_t b) {
+  if(b && a > UINT64_MAX / b) {
+    s->overflow = true;
+    return UINT64_MAX;
+  }
+  return a * b;
+}
+
+static uint64_t
+search(components_search* s, bool connected);
+
+// Solves every component on its own by linking only its items into the list
+// of active items. The full list is restored afterwards.
+static uint64_t
+search_split(components_search* s) {
+  miniexact_problem* p = s->p;
+
+  size_t n = 0;
+  for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i))
+    ++n;
+
+  component_item* items = malloc(n * sizeof(component_item));
+  miniexact_link* order = malloc(n * sizeof(miniexact_link));
+  n = 0;
+  for(miniexact_link i = RLINK(0); i != 0; i = RLINK(i)) {
+    order[n] = i;
+    items[n].root = find(s->parent, i);
+    items[n].item = i;
+    ++n;
+  }
+  qsort(items, n, sizeof(component_item), &compare_component_items);
+
+  miniexact_link l = p->l;
+  uint64_t total = 1;
+  for(size_t b = 0, e; b < n && total; b = e) {
+    for(e = b + 1; e < n && items[e].root == items[b].root; ++e)
+      ;
+
+    miniexact_link prev = 0;
+    for(size_t k = b; k < e; ++k) {
+      LLINK(items[k].item) = prev;
+      RLINK(prev) = items[k].item;
+      prev = items[k].item;
+    }
+    RLINK(prev) = 0;
+    LLINK(0) = prev;
+
+    total = mul(s, total, search(s, true));
+  }
+
+  miniexact_link prev = 0;
+  for(size_t k = 0; k < n; ++k) {
+    LLINK(order[k]) = prev;
+    RLINK(prev) = order[k];
+    prev = order[k];
+  }
+  RLINK(prev) = 0;
+  LLINK(0) = prev;
+
+  // A component without solutions discards those found for the others.
+  if(s->first && !total)
+    p->l = l;
+
+  free(order);
+  free(items);
+  return total;
+}
+
+static uint64_t
+search(components_search* s, bool connected) {
+  miniexact_problem* p = s->p;
+
+  if(RLINK(0) == 0)
+    return 1;
+
+  if(!connected && connect(p, s->parent) > 1)
+    return search_split(s);
+
+  miniexact_link i = miniexact_choose_i_mrv(NULL, p, 0);
+  if(LEN(i) == 0)
+    return 0;
+
+  uint64_t total = 0;
+  COVER_PRIME(i);
+  for(miniexact_link x = DLINK(i); x != i; x = DLINK(x)) {
+    for(miniexact_link q = x + 1; q != x;) {
+      miniexact_link j = TOP(q);
+      if(j <= 0) {
+        q = ULINK(q);
+      } else {
+        COMMIT(q, j);
+        ++q;
+      }
+    }
+
+    if(s->first)
+      p->x[p->l++] = x;
+
+    uint64_t count = search(s, false);
+
+    for(miniexact_link q = x - 1; q != x;) {
+      miniexact_link j = TOP(q);
+      if(j <= 0) {
+        q = DLINK(q);
+      } else {
+        UNCOMMIT(q, j);
+        --q;
+      }
+    }
+
+    if(s->first) {
+      if(count) {
+        total = 1;
+        break;
+      }
+      --p->l;
+    } else {
+      total = add(s, total, count);
+    }
+  }
+  UNCOVER_PRIME(i);
+
+  return total;
+}
+
+static void
+search_init(components_search* s, miniexact_problem* p, bool first) {
+  s->p = p;
+  s->parent = malloc((p->N + 1) * sizeof(miniexact_link));
+  s->first = first;
+  s->overflow = false;
+}
+
+miniexact_link
+miniexact_components_count(miniexact_problem* p) {
+  assert(p);
+  miniexact_link* parent = malloc((p->N + 1) * sizeof(miniexact_link));
+  miniexact_link components = connect(p, parent);
+  free(parent);
+  return components;
+}
+
+const char*
+miniexact_components_count_solutions(miniexact_problem* p, uint64_t* count) {
+  assert(p);
+  assert(count);
+
+  components_search s;
+  search_init(&s, p, false);
+  *count = search(&s, false);
+  free(s.parent);
+
+  if(s.overflow)
+    return "Number of solutions does not fit into 64 bits!";
+  return NULL;
+}
+
+int
+miniexact_components_solve(miniexact_problem* p) {
+  assert(p);
+
+  if(p->x_capacity < p->option_count + 1) {
+    MINIEXACT_ARR_RESIZE(x, p->option_count + 1)
+  }
+  p->l = 0;
+
+  components_search s;
+  search_init(&s, p, true);
+  bool found = search(&s, false);
+  free(s.parent);
+
+  p->x_size = p->l;
+  return found ? 10 : 20;
+}
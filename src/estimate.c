@@ -0,0 +1,305 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef MINIEXACT_THREADS_AVAILABLE
+#include <pthread.h>
+#endif
+
+#include <miniexact/algorithm.h>
+#include <miniexact/estimate.h>
+#include <miniexact/log.h>
+#include <miniexact/miniexact.h>
+#include <miniexact/util.h>
+
+// xorshift64*, enough for picking branches.
+static uint64_t
+next_random(miniexact_estimate* e) {
+  e->rng ^= e->rng >> 12;
+  e->rng ^= e->rng << 25;
+  e->rng ^= e->rng >> 27;
+  return e->rng * 0x2545F4914F6CDD1DULL;
+}
+
+// Newton's method, so that no libm is required.
+static double
+square_root(double x) {
+  if(x <= 0)
+    return 0;
+  double r = x > 1 ? x : 1;
+  for(int i = 0; i < 128; ++i) {
+    double next = (r + x / r) / 2;
+    if(next >= r)
+      break;
+    r = next;
+  }
+  return r;
+}
+
+static void
+reserve_level(miniexact_estimate* e, miniexact_link l) {
+  assert(l >= 0);
+  if((size_t)l < e->levels_capacity)
+    return;
+  size_t capacity = e->levels_capacity ? e->levels_capacity * 2 : 64;
+  while(capacity <= (size_t)l)
+    capacity *= 2;
+  e->degree = realloc(e->degree, capacity * sizeof(miniexact_link));
+  e->choice = realloc(e->choice, capacity * sizeof(miniexact_link));
+  e->tried = realloc(e->tried, capacity * sizeof(miniexact_link));
+  e->weight = realloc(e->weight, capacity * sizeof(double));
+  e->levels_capacity = capacity;
+}
+
+// Charges the mems and time since the last call to the node on level l.
+static void
+charge(miniexact_estimate* e, miniexact_problem* p, miniexact_link l) {
+  double now = miniexact_seconds();
+  e->walk_mems += e->weight[l] * (double)(p->stats.mems - e->last_mems);
+  e->walk_time += e->weight[l] * (now - e->last_time);
+  e->last_mems = p->stats.mems;
+  e->last_time = now;
+}
+
+static void
+add_sample(miniexact_estimate_sum* s, double x) {
+  s->sum += x;
+  s->sum_sq += x * x;
+}
+
+void
+miniexact_estimate_init(miniexact_estimate* e,
+                        miniexact_problem* p,
+                        uint64_t seed) {
+  assert(e);
+  assert(p);
+  memset(e, 0, sizeof(*e));
+
+  // splitmix64 of the seed, xorshift must not start from 0.
+  uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  e->rng = (z ^ (z >> 31)) | 1;
+
+  p->estimate = e;
+}
+
+void
+miniexact_estimate_choose(miniexact_estimate* e,
+                          miniexact_problem* p,
+                          miniexact_link degree) {
+  reserve_level(e, p->l + 1);
+  e->degree[p->l] = degree;
+  e->choice[p->l] = degree > 0 ? (miniexact_link)(next_random(e) % degree) : 0;
+  e->tried[p->l] = 0;
+}
+
+bool
+miniexact_estimate_descend(miniexact_estimate* e, miniexact_problem* p) {
+  miniexact_link l = p->l;
+  assert((size_t)l < e->levels_capacity);
+  if(e->tried[l]++ != e->choice[l])
+    return false;
+
+  charge(e, p, l);
+  e->weight[l + 1] = e->weight[l] * e->degree[l];
+  e->walk_nodes += e->weight[l + 1];
+  return true;
+}
+
+void
+miniexact_estimate_leave(miniexact_estimate* e, miniexact_problem* p) {
+  charge(e, p, p->l);
+}
+
+void
+miniexact_estimate_walk(miniexact_estimate* e,
+                        miniexact_algorithm* a,
+                        miniexact_problem* p) {
+  assert(p->estimate == e);
+
+  reserve_level(e, 0);
+  e->weight[0] = 1;
+  e->walk_nodes = 1;
+  e->walk_mems = 0;
+  e->walk_time = 0;
+  e->walk_solutions = 0;
+  e->last_mems = p->stats.mems;
+  e->last_time = miniexact_seconds();
+
+  // The walk ends in at most one leaf, after which the engine backtracks to
+  // the root without being allowed to descend again.
+  p->state = 0;
+  while(a->compute_next_result(a, p))
+    e->walk_solutions += e->weight[p->l];
+  charge(e, p, 0);
+
+  add_sample(&e->nodes, e->walk_nodes);
+  add_sample(&e->mems, e->walk_mems);
+  add_sample(&e->time, e->walk_time);
+  add_sample(&e->solutions, e->walk_solutions);
+  ++e->walks;
+}
+
+void
+miniexact_estimate_merge(miniexact_estimate* e, const miniexact_estimate* o) {
+  e->walks += o->walks;
+  e->nodes.sum += o->nodes.sum;
+  e->nodes.sum_sq += o->nodes.sum_sq;
+  e->mems.sum += o->mems.sum;
+  e->mems.sum_sq += o->mems.sum_sq;
+  e->time.sum += o->time.sum;
+  e->time.sum_sq += o->time.sum_sq;
+  e->solutions.sum += o->solutions.sum;
+  e->solutions.sum_sq += o->solutions.sum_sq;
+}
+
+double
+miniexact_estimate_mean(const miniexact_estimate* e,
+                        const miniexact_estimate_sum* s,
+                        double* error) {
+  double n = (double)e->walks;
+  double mean = n > 0 ? s->sum / n : 0;
+  if(error) {
+    *error = 0;
+    if(n > 1) {
+      double variance = (s->sum_sq - n * mean * mean) / (n - 1);
+      *error = 1.96 * square_root(variance / n);
+    }
+  }
+  return mean;
+}
+
+void
+miniexact_estimate_print(const miniexact_estimate* e, FILE* f) {
+  double error;
+  double nodes = miniexact_estimate_mean(e, &e->nodes, &error);
+
+  fprintf(f, "Estimate from %lld random paths (95%% confidence):\n", e->walks);
+  fprintf(f, "  nodes      %.4g +- %.2g\n", nodes, error);
+  double solutions = miniexact_estimate_mean(e, &e->solutions, &error);
+  fprintf(f, "  solutions  %.4g +- %.2g\n", solutions, error);
+#ifdef MINIEXACT_STATS
+  double mems = miniexact_estimate_mean(e, &e->mems, &error);
+  fprintf(f, "  mems       %.4g +- %.2g\n", mems, error);
+#else
+  fprintf(f, "  mems       (build with MINIEXACT_STATS)\n");
+#endif
+  double time = miniexact_estimate_mean(e, &e->time, &error);
+  fprintf(f, "  time       %.4g +- %.2g s\n", time, error);
+}
+
+void
+miniexact_estimate_finish(miniexact_estimate* e, miniexact_problem* p) {
+  assert(e);
+  free(e->degree);
+  free(e->choice);
+  free(e->tried);
+  free(e->weight);
+  e->degree = NULL;
+  e->choice = NULL;
+  e->tried = NULL;
+  e->weight = NULL;
+  e->levels_capacity = 0;
+  p->estimate = NULL;
+}
+
+#ifdef MINIEXACT_THREADS_AVAILABLE
+typedef struct estimate_worker {
+  miniexact_algorithm* a;
+  miniexact_problem* p;
+  miniexact_estimate e;
+  long long walks;
+  pthread_t thread;
+} estimate_worker;
+
+static void*
+worker_main(void* userdata) {
+  estimate_worker* w = userdata;
+  for(long long i = 0; i < w->walks; ++i)
+    miniexact_estimate_walk(&w->e, w->a, w->p);
+  return NULL;
+}
+
+// Splits the walks among clones of p. Returns false if no thread could be
+// started.
+static bool
+walk_parallel(miniexact_estimate* e,
+              miniexact_algorithm* a,
+              miniexact_problem* p,
+              miniexact_config* cfg) {
+  int workers_count = cfg->threads;
+  estimate_worker* workers = calloc(workers_count, sizeof(estimate_worker));
+
+  for(int i = 0; i < workers_count; ++i) {
+    estimate_worker* w = &workers[i];
+    w->a = a;
+    w->walks = cfg->estimate / workers_count +
+               (i < cfg->estimate % workers_count ? 1 : 0);
+    w->p = miniexact_problem_clone(p);
+    w->p->state = 0;
+    memset(&w->p->stats, 0, sizeof(w->p->stats));
+    miniexact_estimate_init(&w->e, w->p, i + 1);
+    if(pthread_create(&w->thread, NULL, &worker_main, w) != 0) {
+      miniexact_err("Could not start worker thread %d!", i);
+      miniexact_estimate_finish(&w->e, w->p);
+      miniexact_problem_free(w->p, a);
+      workers_count = i;
+      break;
+    }
+  }
+
+  for(int i = 0; i < workers_count; ++i) {
+    pthread_join(workers[i].thread, NULL);
+    miniexact_estimate_merge(e, &workers[i].e);
+    miniexact_estimate_finish(&workers[i].e, workers[i].p);
+    miniexact_problem_free(workers[i].p, a);
+  }
+  free(workers);
+
+  return workers_count > 0;
+}
+#endif
+
+int
+miniexact_estimate_and_print(miniexact_algorithm* a,
+                             miniexact_problem* p,
+                             miniexact_config* cfg) {
+  assert(a);
+  assert(p);
+  assert(cfg);
+
+  miniexact_estimate e;
+  miniexact_estimate_init(&e, p, 0);
+  double start = miniexact_seconds();
+
+  bool done = false;
+#ifdef MINIEXACT_THREADS_AVAILABLE
+  if(cfg->threads > 1)
+    done = walk_parallel(&e, a, p, cfg);
+#endif
+  for(long long i = 0; !done && i < cfg->estimate; ++i)
+    miniexact_estimate_walk(&e, a, p);
+
+  p->stats.solve_time += miniexact_seconds() - start;
+  miniexact_estimate_print(&e, stdout);
+  miniexact_estimate_finish(&e, p);
+  return EXIT_SUCCESS;
+}
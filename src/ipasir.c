@@ -0,0 +1,110 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <miniexact/ipasir.h>
+#include <miniexact/log.h>
+
+// Incremental solvers that ship an IPASIR library. Kissat does not support
+// incremental solving and is only available as an external binary.
+static const char* known_ipasir_libraries[] = {
+#ifdef __APPLE__
+  "libcadical.dylib",
+  "libipasircadical.dylib",
+  "libipasircryptominisat5.dylib",
+  "libipasir.dylib",
+#else
+  "libcadical.so",
+  "libipasircadical.so",
+  "libipasircryptominisat5.so",
+  "libipasir.so",
+#endif
+  NULL
+};
+
+bool
+miniexact_ipasir_open(miniexact_ipasir* s, const char* path) {
+  assert(s);
+  assert(path);
+  memset(s, 0, sizeof(*s));
+
+  s->library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if(!s->library) {
+    miniexact_dbg("Could not load IPASIR library %s: %s", path, dlerror());
+    return false;
+  }
+
+  // Function pointers cannot be assigned from void* in ISO C.
+  *(void**)&s->signature = dlsym(s->library, "ipasir_signature");
+  *(void**)&s->init = dlsym(s->library, "ipasir_init");
+  *(void**)&s->release = dlsym(s->library, "ipasir_release");
+  *(void**)&s->add = dlsym(s->library, "ipasir_add");
+  *(void**)&s->solve = dlsym(s->library, "ipasir_solve");
+  *(void**)&s->val = dlsym(s->library, "ipasir_val");
+  if(!s->signature || !s->init || !s->release || !s->add || !s->solve ||
+     !s->val) {
+    miniexact_dbg("Library %s does not implement IPASIR!", path);
+    dlclose(s->library);
+    s->library = NULL;
+    return false;
+  }
+
+  s->solver = s->init();
+  if(!s->solver) {
+    dlclose(s->library);
+    s->library = NULL;
+    return false;
+  }
+  miniexact_dbg("Using IPASIR solver %s from %s", s->signature(), path);
+  return true;
+}
+
+bool
+miniexact_ipasir_find(miniexact_ipasir* s, const char* library) {
+  assert(s);
+  if(library) {
+    if(miniexact_ipasir_open(s, library))
+      return true;
+    miniexact_err("Could not load IPASIR library %s, falling back to an "
+                  "external SAT solver!",
+                  library);
+    return false;
+  }
+
+  const char* env = getenv("MINIEXACT_IPASIR");
+  if(env && *env)
+    return miniexact_ipasir_open(s, env);
+
+  for(size_t i = 0; known_ipasir_libraries[i]; ++i)
+    if(miniexact_ipasir_open(s, known_ipasir_libraries[i]))
+      return true;
+  return false;
+}
+
+void
+miniexact_ipasir_close(miniexact_ipasir* s) {
+  assert(s);
+  if(s->solver)
+    s->release(s->solver);
+  if(s->library)
+    dlclose(s->library);
+  memset(s, 0, sizeof(*s));
+}
@@ -17,16 +17,23 @@
 */
 #include "miniexact/util.h"
 #include <getopt.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <miniexact/algorithm.h>
+#include <miniexact/algorithm_knuth_cnf.h>
+#include <miniexact/algorithm_x_bitset.h>
+#include <miniexact/binary.h>
+#include <miniexact/budget.h>
 #include <miniexact/git.h>
 #include <miniexact/log.h>
 #include <miniexact/miniexact.h>
 #include <miniexact/ops.h>
+#include <miniexact/profile.h>
 #include <miniexact/parse.h>
+#include <miniexact/sat_solver.h>
 
 static void
 print_help(void) {
@@ -38,16 +45,61 @@ print_help(void) {
   printf("  -e\t\tenumerate all solutions\n");
   printf("  -E\t\tprint the problem matrix in libExact format (only -x)\n");
   printf("  -K\t\tgenerate K cheapest solutions (for $ variants)\n");
+  printf("  -j N\t\tenumerate using N threads (with -e, only -x and -c)\n");
+  printf("  -n\t\tonly count all solutions (exact and without enumerating\n    "
+         "    \t    them with -z)\n");
+  printf("  --components\tsolve independent components separately when counting\n"
+         "    \t    or finding one solution (only -x and -c, always MRV)\n");
+  printf("  --preprocess\tremove blocked options and useless secondary items\n"
+         "    \t    before solving (not with multiplicities)\n");
+  printf("  --checkpoint FILE\twrite the search state to FILE every minute,\n"
+         "    \t    so that -e or -n can be resumed (only -x, -c, -m)\n");
+  printf("  --checkpoint-interval N\twrite checkpoints every N seconds\n");
+  printf("  --resume\tcontinue from the checkpoint FILE if it exists\n");
+  printf("  --stats\tprint parse and solve time, and nodes, updates and mems\n"
+         "    \t    if built with MINIEXACT_STATS, to stderr\n");
+  printf("  --profile\tprint nodes, branching and time per search level to "
+         "stderr\n    \t    (only -x, -c, -m, -C, SIGUSR1 prints it while "
+         "running)\n");
+  printf("  --profile-csv FILE\twrite the profile per search level as CSV\n");
+  printf("  --estimate N\testimate nodes, solutions and time from N random\n"
+         "    \t    paths instead of solving (only -x, -c, -m)\n");
+  printf("  --time-limit S\tstop the search of every file after S seconds\n");
+  printf("  --node-limit N\tstop the search of every file after N nodes\n");
+  printf("  --solution-limit N\tstop after N solutions with -e or -n\n");
+  printf("  --memory-limit MB\tstop the search of every file once it adds "
+         "more than MB MiB\n    \t    (stopped searches exit with 30)\n");
+  printf("  --zdd FILE\twrite the ZDD of all solutions to FILE (implies -z)\n");
+  printf("  -b FILE\twrite the parsed problem to a precompiled binary FILE\n    "
+         "    \t    and exit (loaded instead of parsed when given as input)\n");
   printf("ALGORITHM SELECTORS:\n");
   printf("  --naive\tuse naive in-order for i selection\n");
   printf("  --mrv\t\tuse MRV for i selection (default)\n");
   printf("  --smrv\tuse slack-aware MRV for i selection (default for M)\n    "
          "    \t    (see answer to ex. 166, p. 271)\n");
+  printf("  --bmrv\tuse MRV with items bucketed by length, faster for many\n"
+         "    \t    primary items (only -x and -c)\n");
+  printf("  --bitset\tkeep options in bitsets for small problems (only -x,\n"
+         "    \t    falls back to dancing links above %d items or %d options)\n",
+         MINIEXACT_BITSET_MAX_ITEMS,
+         MINIEXACT_BITSET_MAX_OPTIONS);
   printf("  -x\t\tuse Algorithm X\n");
   printf("  -c\t\tuse Algorithm C\n");
   printf("  -m\t\tuse Algorithm M\n");
+  printf("  -d\t\tuse dancing cells (sparse sets) for XCC with colors\n"
+         "    \t    (always chooses items by MRV)\n");
+  printf("  -z\t\tuse Algorithm Z (build a ZDD, no colors)\n");
   printf("  -k\t\tcall external binary to solve with SAT\n    \t\t    (Knuth's "
          "trivial encoding)\n");
+  printf("  --ipasir LIB\tsolve incrementally with the IPASIR library LIB for "
+         "-k\n    \t    (default: $MINIEXACT_IPASIR or libcadical)\n");
+  printf("  --amo ENC\tencode at most one option per item for -k with ENC:\n"
+         "    \t    auto (default), pairwise, sequential, commander or "
+         "product\n");
+  printf("  --one-pass\twrite the CNF for -k without counting it first\n"
+         "    \t    (keeps the whole CNF in memory)\n");
+  printf("  --portfolio[=LIST]\n    \t\trace all SAT solvers found (or the "
+         "comma separated\n    \t\tLIST) for -k and print who won\n");
 }
 
 static void
@@ -60,7 +112,7 @@ parse_cli(miniexact_config* cfg, int argc, char* argv[]) {
   int c;
 
   cfg->solutions = 1;
-  int sel[6];
+  int sel[8];
   memset(sel, 0, sizeof(sel));
 
   struct option long_options[] = {
@@ -71,14 +123,45 @@ parse_cli(miniexact_config* cfg, int argc, char* argv[]) {
     { "print-x", no_argument, 0, MINIEXACT_OPTION_PRINT_X },
     { "enumerate", no_argument, 0, 'e' },
     { "solutions", required_argument, 0, 'K' },
+    { "threads", required_argument, 0, 'j' },
+    { "write-binary", required_argument, 0, 'b' },
+    { "count", no_argument, 0, 'n' },
+    { "components", no_argument, &cfg->components, 1 },
+    { "stats", no_argument, &cfg->stats, 1 },
+    { "profile", no_argument, &cfg->profile, 1 },
+    { "profile-csv", required_argument, 0, MINIEXACT_OPTION_PROFILE_CSV },
+    { "estimate", required_argument, 0, MINIEXACT_OPTION_ESTIMATE },
+    { "time-limit", required_argument, 0, MINIEXACT_OPTION_TIME_LIMIT },
+    { "node-limit", required_argument, 0, MINIEXACT_OPTION_NODE_LIMIT },
+    { "solution-limit",
+      required_argument,
+      0,
+      MINIEXACT_OPTION_SOLUTION_LIMIT },
+    { "memory-limit", required_argument, 0, MINIEXACT_OPTION_MEMORY_LIMIT },
+    { "ipasir", required_argument, 0, MINIEXACT_OPTION_IPASIR },
+    { "amo", required_argument, 0, MINIEXACT_OPTION_AMO },
+    { "one-pass", no_argument, &cfg->one_pass, 1 },
+    { "portfolio", optional_argument, 0, MINIEXACT_OPTION_PORTFOLIO },
+    { "preprocess", no_argument, &sel[7], MINIEXACT_ALGORITHM_PREPROCESS },
+    { "checkpoint", required_argument, 0, MINIEXACT_OPTION_CHECKPOINT },
+    { "checkpoint-interval",
+      required_argument,
+      0,
+      MINIEXACT_OPTION_CHECKPOINT_INTERVAL },
+    { "resume", no_argument, &cfg->resume, 1 },
+    { "zdd", required_argument, 0, MINIEXACT_OPTION_WRITE_ZDD },
     { "naive", no_argument, &sel[0], MINIEXACT_ALGORITHM_NAIVE },
     { "mrv", no_argument, &sel[1], MINIEXACT_ALGORITHM_MRV },
     { "smrv", no_argument, &sel[1], MINIEXACT_ALGORITHM_MRV },
+    { "bmrv", no_argument, &sel[1], MINIEXACT_ALGORITHM_MRV_BUCKET },
     { "x", no_argument, &sel[2], MINIEXACT_ALGORITHM_X },
+    { "bitset", no_argument, &sel[6], MINIEXACT_ALGORITHM_BITSET },
     { "c", no_argument, &sel[3], MINIEXACT_ALGORITHM_C },
     { "m", no_argument, &sel[3], MINIEXACT_ALGORITHM_M },
     { "k", no_argument, &sel[4], MINIEXACT_ALGORITHM_KNUTH_CNF },
     { "C", no_argument, &sel[5], MINIEXACT_ALGORITHM_C_DOLLAR },
+    { "z", no_argument, &sel[3], MINIEXACT_ALGORITHM_Z },
+    { "d", no_argument, &sel[3], MINIEXACT_ALGORITHM_DC },
     { 0, 0, 0, 0 }
   };
 
@@ -86,7 +169,7 @@ parse_cli(miniexact_config* cfg, int argc, char* argv[]) {
 
     int option_index = 0;
 
-    c = getopt_long(argc, argv, "eEK:psxcmkChVv", long_options, &option_index);
+    c = getopt_long(argc, argv, "eEK:j:b:npsxcmkzdChVv", long_options, &option_index);
 
     if(c == -1)
       break;
@@ -116,6 +199,96 @@ parse_cli(miniexact_config* cfg, int argc, char* argv[]) {
                         cfg->solutions);
         }
         break;
+      case 'j':
+        cfg->threads = atoi(optarg);
+        if(cfg->threads <= 0) {
+          miniexact_err("Option -j expects some number >0 to be given! Gave "
+                        "\"%s\" which evaluated to %d",
+                        optarg,
+                        cfg->threads);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'b':
+        cfg->write_binary = optarg;
+        break;
+      case 'n':
+        cfg->count = 1;
+        break;
+      case MINIEXACT_OPTION_PROFILE_CSV:
+        cfg->profile_csv = optarg;
+        break;
+      case MINIEXACT_OPTION_ESTIMATE:
+        cfg->estimate = atoll(optarg);
+        if(cfg->estimate <= 0) {
+          miniexact_err("Option --estimate expects some number >0 of paths, "
+                        "but %lld was given!",
+                        cfg->estimate);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case MINIEXACT_OPTION_TIME_LIMIT:
+        cfg->time_limit = atof(optarg);
+        if(cfg->time_limit <= 0) {
+          miniexact_err("Option --time-limit expects some number >0 of "
+                        "seconds, but %s was given!",
+                        optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case MINIEXACT_OPTION_NODE_LIMIT:
+      case MINIEXACT_OPTION_SOLUTION_LIMIT:
+      case MINIEXACT_OPTION_MEMORY_LIMIT: {
+        long long limit = atoll(optarg);
+        if(limit <= 0) {
+          miniexact_err("Option --%s expects some number >0, but %s was "
+                        "given!",
+                        long_options[option_index].name,
+                        optarg);
+          exit(EXIT_FAILURE);
+        }
+        if(c == MINIEXACT_OPTION_NODE_LIMIT)
+          cfg->node_limit = limit;
+        else if(c == MINIEXACT_OPTION_SOLUTION_LIMIT)
+          cfg->solution_limit = limit;
+        else
+          cfg->memory_limit = limit;
+        break;
+      }
+      case MINIEXACT_OPTION_IPASIR:
+        cfg->ipasir = optarg;
+        break;
+      case MINIEXACT_OPTION_AMO: {
+        miniexact_amo_encoding encoding;
+        if(!miniexact_amo_encoding_from_name(optarg, &encoding)) {
+          miniexact_err("Option --amo expects auto, pairwise, sequential, "
+                        "commander or product, but %s was given!",
+                        optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->amo = encoding;
+        break;
+      }
+      case MINIEXACT_OPTION_PORTFOLIO:
+        cfg->portfolio = optarg ? optarg : "";
+        break;
+      case MINIEXACT_OPTION_CHECKPOINT:
+        cfg->checkpoint = optarg;
+        break;
+      case MINIEXACT_OPTION_CHECKPOINT_INTERVAL:
+        cfg->checkpoint_interval = atoi(optarg);
+        if(cfg->checkpoint_interval <= 0) {
+          miniexact_err("Option --checkpoint-interval expects some number >0 "
+                        "to be given! Gave \"%s\" which evaluated to %d",
+                        optarg,
+                        cfg->checkpoint_interval);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case MINIEXACT_OPTION_WRITE_ZDD:
+        cfg->write_zdd = optarg;
+        cfg->algorithm_select |= MINIEXACT_ALGORITHM_Z;
+        break;
       case 'E':
         cfg->transform_to_libexact = 1;
         break;
@@ -137,6 +310,12 @@ parse_cli(miniexact_config* cfg, int argc, char* argv[]) {
       case 'C':
         cfg->algorithm_select |= MINIEXACT_ALGORITHM_C_DOLLAR;
         break;
+      case 'z':
+        cfg->algorithm_select |= MINIEXACT_ALGORITHM_Z;
+        break;
+      case 'd':
+        cfg->algorithm_select |= MINIEXACT_ALGORITHM_DC;
+        break;
       default:
         break;
     }
@@ -147,9 +326,123 @@ parse_cli(miniexact_config* cfg, int argc, char* argv[]) {
     cfg->input_files_count = argc - optind;
   }
 
+  if(cfg->write_binary && cfg->input_files_count != 1) {
+    miniexact_err("Option -b expects exactly one input file!");
+    exit(EXIT_FAILURE);
+  }
+
   for(size_t i = 0; i < sizeof(sel) / sizeof(sel[0]); ++i)
     cfg->algorithm_select |= sel[i];
+
+  if(cfg->resume && !cfg->checkpoint) {
+    miniexact_err("Option --resume requires --checkpoint FILE!");
+    exit(EXIT_FAILURE);
+  }
+
+  // Replaying a checkpoint relies on choosing the same items again, so only
+  // the dancing links engines with a history-free heuristic support it.
+  if(cfg->checkpoint) {
+    int engines =
+      MINIEXACT_ALGORITHM_X | MINIEXACT_ALGORITHM_C | MINIEXACT_ALGORITHM_M;
+    int unsupported =
+      MINIEXACT_ALGORITHM_KNUTH_CNF | MINIEXACT_ALGORITHM_C_DOLLAR |
+      MINIEXACT_ALGORITHM_MRV_BUCKET | MINIEXACT_ALGORITHM_Z |
+      MINIEXACT_ALGORITHM_DC | MINIEXACT_ALGORITHM_BITSET;
+    if(!(cfg->algorithm_select & engines) ||
+       (cfg->algorithm_select & unsupported) || cfg->threads > 1 ||
+       cfg->components || cfg->input_files_count > 1) {
+      miniexact_err("Option --checkpoint only supports one input file with "
+                    "-x, -c or -m, single-threaded and without --bmrv, "
+                    "--bitset or --components!");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // The profile hooks only exist in the dancing links engines.
+  if(cfg->profile || cfg->profile_csv) {
+    int engines = MINIEXACT_ALGORITHM_X | MINIEXACT_ALGORITHM_C |
+                  MINIEXACT_ALGORITHM_M | MINIEXACT_ALGORITHM_C_DOLLAR;
+    int unsupported = MINIEXACT_ALGORITHM_KNUTH_CNF | MINIEXACT_ALGORITHM_Z |
+                      MINIEXACT_ALGORITHM_DC | MINIEXACT_ALGORITHM_BITSET;
+    if(!(cfg->algorithm_select & engines) ||
+       (cfg->algorithm_select & unsupported) || cfg->threads > 1 ||
+       cfg->components) {
+      miniexact_err("Option --profile only supports -x, -c, -m or -C, "
+                    "single-threaded and without --bitset or --components!");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // Random paths need the number of branches at every node, which only the
+  // dancing links engines of X, C and M report.
+  if(cfg->estimate) {
+    int engines =
+      MINIEXACT_ALGORITHM_X | MINIEXACT_ALGORITHM_C | MINIEXACT_ALGORITHM_M;
+    int unsupported =
+      MINIEXACT_ALGORITHM_KNUTH_CNF | MINIEXACT_ALGORITHM_C_DOLLAR |
+      MINIEXACT_ALGORITHM_Z | MINIEXACT_ALGORITHM_DC |
+      MINIEXACT_ALGORITHM_BITSET;
+    if(!(cfg->algorithm_select & engines) ||
+       (cfg->algorithm_select & unsupported) || cfg->components ||
+       cfg->checkpoint) {
+      miniexact_err("Option --estimate only supports -x, -c or -m, without "
+                    "--bitset, --components or --checkpoint!");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // Dancing cells picks the item with the fewest options on its sparse sets.
+  if((cfg->algorithm_select & MINIEXACT_ALGORITHM_DC) &&
+     (cfg->algorithm_select &
+      (MINIEXACT_ALGORITHM_NAIVE | MINIEXACT_ALGORITHM_MRV_BUCKET))) {
+    miniexact_err("Option -d always uses MRV, not --naive or --bmrv!");
+    exit(EXIT_FAILURE);
+  }
+
+  // The decomposition searches each component with MRV on its own links.
+  if(cfg->components &&
+     (cfg->algorithm_select &
+      (MINIEXACT_ALGORITHM_NAIVE | MINIEXACT_ALGORITHM_MRV_BUCKET))) {
+    miniexact_err("Option --components always uses MRV, not --naive or "
+                  "--bmrv!");
+    exit(EXIT_FAILURE);
+  }
+
+  // Budgets are counted by the sequential search engines.
+  if(miniexact_budget_configured(cfg)) {
+    int unsupported = MINIEXACT_ALGORITHM_KNUTH_CNF | MINIEXACT_ALGORITHM_Z;
+    if((cfg->algorithm_select & unsupported) || cfg->threads > 1 ||
+       cfg->components || cfg->estimate) {
+      miniexact_err("Limits are not supported with -z, -k, -j, "
+                    "--components or --estimate!");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if((cfg->ipasir || cfg->amo || cfg->one_pass || cfg->portfolio) &&
+     !(cfg->algorithm_select & MINIEXACT_ALGORITHM_KNUTH_CNF)) {
+    miniexact_err(
+      "Options --ipasir, --amo, --one-pass and --portfolio require -k!");
+    exit(EXIT_FAILURE);
+  }
+  miniexact_knuth_cnf_set_one_pass(cfg->one_pass);
+  miniexact_sat_solver_set_portfolio(cfg->portfolio);
+
+  // The matrix does not depend on the algorithm, any is fine for writing it.
+  if(cfg->write_binary && !cfg->algorithm_select)
+    cfg->algorithm_select = MINIEXACT_ALGORITHM_X;
+}
+
+#ifdef SIGUSR1
+static miniexact_problem* profiled_problem = NULL;
+
+static void
+profile_dump_handler(int sig) {
+  (void)sig;
+  if(profiled_problem && profiled_problem->profile)
+    profiled_problem->profile->dump_requested = 1;
 }
+#endif
 
 static int
 process_file(miniexact_config* cfg) {
@@ -161,14 +454,24 @@ process_file(miniexact_config* cfg) {
     return EXIT_FAILURE;
   }
 
+  double start = miniexact_seconds();
   miniexact_problem* p =
     miniexact_parse_problem_file(&a, cfg->input_files[cfg->current_input_file]);
   if(!p)
     return EXIT_FAILURE;
+  p->stats.parse_time = miniexact_seconds() - start;
 
   p->cfg = cfg;
   p->K = cfg->solutions;
 
+  if(cfg->algorithm_select & MINIEXACT_ALGORITHM_PREPROCESS)
+    fprintf(stderr,
+            "Preprocessing removed %d options and %d secondary items in %d "
+            "rounds.\n",
+            p->preprocess.removed_options,
+            p->preprocess.removed_secondary_items,
+            p->preprocess.rounds);
+
   if(cfg->verbose)
     miniexact_print_problem_matrix(p);
 
@@ -181,8 +484,34 @@ process_file(miniexact_config* cfg) {
       return EXIT_SUCCESS;
   }
 
+  if(cfg->write_binary) {
+    const char* error = miniexact_write_problem_binary(p, cfg->write_binary);
+    miniexact_problem_free(p, &a);
+    if(error) {
+      miniexact_err("Could not write %s: %s", cfg->write_binary, error);
+      return EXIT_FAILURE;
+    } else
+      return EXIT_SUCCESS;
+  }
+
+#ifdef SIGUSR1
+  if(cfg->profile) {
+    profiled_problem = p;
+    signal(SIGUSR1, profile_dump_handler);
+  }
+#endif
+
   int return_code = miniexact_solve_problem_and_print_solutions(&a, p, cfg);
 
+#ifdef SIGUSR1
+  profiled_problem = NULL;
+#endif
+
+  if(cfg->stats) {
+    fflush(stdout);
+    miniexact_print_stats(p, stderr);
+  }
+
   miniexact_problem_free(p, &a);
   return return_code;
 }
@@ -208,5 +537,10 @@ main(int argc, char* argv[]) {
     }
   }
 
+  if(cfg.portfolio) {
+    fflush(stdout);
+    miniexact_sat_solver_print_portfolio_stats(stderr);
+  }
+
   return status;
 }
@@ -19,19 +19,200 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include <miniexact/algorithm.h>
 #include <miniexact/log.h>
 #include <miniexact/miniexact.h>
 #include <miniexact/ops.h>
 
+static void*
+default_malloc(size_t size, void* userdata) {
+  (void)userdata;
+  return malloc(size);
+}
+
+static void*
+default_realloc(void* ptr, size_t size, void* userdata) {
+  (void)userdata;
+  return realloc(ptr, size);
+}
+
+static void
+default_free(void* ptr, void* userdata) {
+  (void)userdata;
+  free(ptr);
+}
+
+static const miniexact_allocator default_allocator = {
+  &default_malloc, &default_realloc, &default_free, NULL
+};
+
+static miniexact_allocator allocator = {
+  &default_malloc, &default_realloc, &default_free, NULL
+};
+
+void
+miniexact_set_allocator(const miniexact_allocator* a) {
+  allocator = a ? *a : default_allocator;
+}
+
+void*
+miniexact_malloc(size_t size) {
+  return allocator.malloc(size, allocator.userdata);
+}
+
+void*
+miniexact_realloc(void* ptr, size_t size) {
+  return allocator.realloc(ptr, size, allocator.userdata);
+}
+
+void
+miniexact_free(void* ptr) {
+  allocator.free(ptr, allocator.userdata);
+}
+
+char*
+miniexact_strdup(const char* str) {
+  size_t len = strlen(str) + 1;
+  char* dup = miniexact_malloc(len);
+  memcpy(dup, str, len);
+  return dup;
+}
+
+// Problems loaded from a binary file or compacted into an arena point into a
+// larger block for most of their arrays. These are released with the block.
+static inline bool
+is_borrowed(const miniexact_problem* p, const void* ptr) {
+  const char* c = ptr;
+  return (p->mapped && c >= (char*)p->mapped &&
+          c < (char*)p->mapped + p->mapped_size) ||
+         (p->arena && c >= (char*)p->arena &&
+          c < (char*)p->arena + p->arena_size);
+}
+
+static inline void
+release(const miniexact_problem* p, void* ptr) {
+  if(ptr && !is_borrowed(p, ptr))
+    miniexact_free(ptr);
+}
+
+void*
+miniexact_problem_realloc(miniexact_problem* p,
+                          void* ptr,
+                          size_t old_size,
+                          size_t new_size) {
+  if(!ptr || !is_borrowed(p, ptr))
+    return miniexact_realloc(ptr, new_size);
+  void* fresh = miniexact_malloc(new_size);
+  memcpy(fresh, ptr, old_size < new_size ? old_size : new_size);
+  return fresh;
+}
+
 miniexact_problem*
 miniexact_problem_allocate() {
-  miniexact_problem* p = calloc(1, sizeof(miniexact_problem));
+  miniexact_problem* p = miniexact_malloc(sizeof(miniexact_problem));
+  memset(p, 0, sizeof(miniexact_problem));
   p->K = 1;// Generate one solution by default.
   return p;
 }
 
+#define NAME_INDEX_INITIAL_CAPACITY 64
+
+static inline uint32_t
+hash_name(const char* name) {
+  // FNV-1a
+  uint32_t h = 2166136261u;
+  for(; *name; ++name) {
+    h ^= (unsigned char)*name;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static void
+name_index_put(miniexact_name_index* idx,
+               const miniexact_name* names,
+               miniexact_link l) {
+  size_t mask = idx->capacity - 1;
+  size_t s = hash_name(names[l]) & mask;
+  while(idx->slots[s] != -1)
+    s = (s + 1) & mask;
+  idx->slots[s] = l;
+  ++idx->count;
+}
+
+static void
+name_index_rehash(const miniexact_problem* p,
+                  miniexact_name_index* idx,
+                  const miniexact_name* names,
+                  size_t names_size,
+                  size_t capacity) {
+  release(p, idx->slots);
+  idx->slots = miniexact_malloc(capacity * sizeof(miniexact_link));
+  memset(idx->slots, -1, capacity * sizeof(miniexact_link));
+  idx->capacity = capacity;
+  idx->count = 0;
+  for(size_t i = 0; i < names_size; ++i)
+    if(names[i])
+      name_index_put(idx, names, i);
+}
+
+static void
+name_index_insert(const miniexact_problem* p,
+                  miniexact_name_index* idx,
+                  const miniexact_name* names,
+                  miniexact_link l) {
+  // Keep the load factor at most 1/2 so that probe sequences stay short.
+  if((idx->count + 1) * 2 > idx->capacity) {
+    size_t capacity = idx->capacity ? idx->capacity * 2
+                                    : NAME_INDEX_INITIAL_CAPACITY;
+    // Names up to l are indexed by the rehash, only l itself is new.
+    name_index_rehash(p, idx, names, l, capacity);
+  }
+  name_index_put(idx, names, l);
+}
+
+static void
+name_index_reserve(const miniexact_problem* p,
+                   miniexact_name_index* idx,
+                   const miniexact_name* names,
+                   size_t names_size,
+                   size_t count) {
+  size_t capacity = idx->capacity ? idx->capacity : NAME_INDEX_INITIAL_CAPACITY;
+  while(count * 2 > capacity)
+    capacity *= 2;
+  if(capacity > idx->capacity)
+    name_index_rehash(p, idx, names, names_size, capacity);
+}
+
+static miniexact_link
+name_index_find(const miniexact_name_index* idx,
+                const miniexact_name* names,
+                const char* needle) {
+  if(!idx->capacity)
+    return -1;
+  size_t mask = idx->capacity - 1;
+  size_t s = hash_name(needle) & mask;
+  miniexact_link l;
+  while((l = idx->slots[s]) != -1) {
+    if(strcmp(names[l], needle) == 0)
+      return l;
+    s = (s + 1) & mask;
+  }
+  return -1;
+}
+
+static void
+name_index_clone(miniexact_name_index* idx) {
+  if(!idx->slots)
+    return;
+  miniexact_link* slots =
+    miniexact_malloc(idx->capacity * sizeof(miniexact_link));
+  memcpy(slots, idx->slots, idx->capacity * sizeof(miniexact_link));
+  idx->slots = slots;
+}
+
 int
 miniexact_search_for_name(const char* needle,
                           const miniexact_name* names,
@@ -44,6 +225,52 @@ miniexact_search_for_name(const char* needle,
   return -1;
 }
 
+miniexact_problem*
+miniexact_problem_clone(const miniexact_problem* o) {
+  assert(o);
+  miniexact_problem* p = miniexact_malloc(sizeof(miniexact_problem));
+  *p = *o;
+
+  MINIEXACT_ARR_CLONE(llink)
+  MINIEXACT_ARR_CLONE(rlink)
+  MINIEXACT_NODES_CLONE()
+  MINIEXACT_ARR_CLONE(name)
+  MINIEXACT_ARR_CLONE(color_name)
+  MINIEXACT_ARR_CLONE(ft)
+  MINIEXACT_ARR_CLONE(slack)
+  MINIEXACT_ARR_CLONE(bound)
+  MINIEXACT_ARR_CLONE(cost)
+  MINIEXACT_ARR_CLONE(best)
+  MINIEXACT_ARR_CLONE(tho)
+  MINIEXACT_ARR_CLONE(th)
+  MINIEXACT_ARR_CLONE(x)
+  MINIEXACT_ARR_CLONE(bucket_next)
+  MINIEXACT_ARR_CLONE(bucket_prev)
+
+  for(size_t i = 0; i < p->name_size; ++i)
+    if(p->name[i])
+      p->name[i] = miniexact_strdup(p->name[i]);
+  for(size_t i = 0; i < p->color_name_size; ++i)
+    if(p->color_name[i])
+      p->color_name[i] = miniexact_strdup(p->color_name[i]);
+
+  name_index_clone(&p->name_index);
+  name_index_clone(&p->color_name_index);
+
+  p->algorithm_userdata = NULL;
+  p->worker = NULL;
+  p->checkpoint = NULL;
+  p->profile = NULL;
+  p->estimate = NULL;
+  p->budget = NULL;
+  p->cancel = NULL;
+  p->mapped = NULL;
+  p->mapped_size = 0;
+  p->arena = NULL;
+  p->arena_size = 0;
+  return p;
+}
+
 bool
 miniexact_has_item(miniexact_link needle, miniexact_link* list, size_t len) {
   for(size_t i = 0; i < len; ++i) {
@@ -53,71 +280,193 @@ miniexact_has_item(miniexact_link needle, miniexact_link* list, size_t len) {
   return false;
 }
 
+#define RELEASE(PTR) release(p, (PTR));
+
 void
 miniexact_problem_free_inner(miniexact_problem* p, miniexact_algorithm* a) {
   if(p->algorithm_userdata && a && a->free_userdata)
     a->free_userdata(a, p);
 
-  if(p->llink)
-    free(p->llink);
-  if(p->rlink)
-    free(p->rlink);
-  if(p->ulink)
-    free(p->ulink);
-  if(p->dlink)
-    free(p->dlink);
-  if(p->top)
-    free(p->top);
-  if(p->color)
-    free(p->color);
+  RELEASE(p->llink)
+  RELEASE(p->rlink)
+#ifdef MINIEXACT_INTERLEAVED_NODES
+  RELEASE(p->node)
+#else
+  RELEASE(p->ulink)
+  RELEASE(p->dlink)
+  RELEASE(p->top)
+  RELEASE(p->color)
+#endif
   if(p->color_name) {
     for(size_t i = 0; i < p->color_name_size; ++i)
-      if(p->color_name[i])
-        free(p->color_name[i]);
-    free(p->color_name);
+      RELEASE(p->color_name[i])
+    RELEASE(p->color_name)
   }
   if(p->name) {
     for(size_t i = 0; i < p->name_size; ++i)
-      if(p->name[i])
-        free(p->name[i]);
-    free(p->name);
-  }
-  if(p->x)
-    free(p->x);
-  if(p->ft)
-    free(p->ft);
-  if(p->slack)
-    free(p->slack);
-  if(p->bound)
-    free(p->bound);
-  if(p->cost)
-    free(p->cost);
-  if(p->best)
-    free(p->best);
-  if(p->tho)
-    free(p->tho);
-  if(p->th)
-    free(p->th);
+      RELEASE(p->name[i])
+    RELEASE(p->name)
+  }
+  RELEASE(p->name_index.slots)
+  RELEASE(p->color_name_index.slots)
+  RELEASE(p->x)
+  RELEASE(p->ft)
+  RELEASE(p->slack)
+  RELEASE(p->bound)
+  RELEASE(p->cost)
+  RELEASE(p->best)
+  RELEASE(p->tho)
+  RELEASE(p->th)
+  RELEASE(p->bucket_next)
+  RELEASE(p->bucket_prev)
+
+  if(p->mapped)
+    munmap(p->mapped, p->mapped_size);
+  if(p->arena)
+    miniexact_free(p->arena);
 
   memset(p, 0, sizeof(miniexact_problem));
 }
 
+#undef RELEASE
+
 void
 miniexact_problem_free(miniexact_problem* p, miniexact_algorithm* a) {
   miniexact_problem_free_inner(p, a);
-  free(p);
+  miniexact_free(p);
+}
+
+void
+miniexact_problem_reserve(miniexact_problem* p,
+                          size_t items,
+                          size_t nodes,
+                          size_t colors) {
+  // Item 0 is the list head and N + 1 the secondary list head. Arrays keep
+  // one spare element, as PLUSN grows before the capacity is reached.
+  MINIEXACT_ARR_RESERVE(llink, items + 3)
+  MINIEXACT_ARR_RESERVE(rlink, items + 3)
+  MINIEXACT_ARR_RESERVE(slack, items + 3)
+  MINIEXACT_ARR_RESERVE(bound, items + 3)
+  MINIEXACT_ARR_RESERVE(name, items + 3)
+  MINIEXACT_NODES_RESERVE(items + nodes + 3)
+  MINIEXACT_ARR_RESERVE(cost, items + nodes + 3)
+  MINIEXACT_ARR_RESERVE(color_name, colors + 2)
+  name_index_reserve(p, &p->name_index, p->name, p->name_size, items);
+  name_index_reserve(
+    p, &p->color_name_index, p->color_name, p->color_name_size, colors);
+}
+
+#define ARENA_ALIGN 64
+#define ARENA_ROUND(BYTES) (((BYTES) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// Moves PTR (with BYTES content) to the arena at pos. Only measures the arena
+// if it is NULL.
+static void*
+pack(miniexact_problem* p, char* arena, size_t* pos, void* ptr, size_t bytes) {
+  if(!bytes) {
+    if(!arena)
+      return ptr;
+    release(p, ptr);
+    return NULL;
+  }
+  void* packed = ptr;
+  if(arena) {
+    packed = arena + *pos;
+    memcpy(packed, ptr, bytes);
+    release(p, ptr);
+  }
+  *pos += ARENA_ROUND(bytes);
+  return packed;
+}
+
+static void
+pack_names(miniexact_problem* p,
+           char* arena,
+           size_t* pos,
+           miniexact_name* names,
+           size_t names_size) {
+  for(size_t i = 0; i < names_size; ++i) {
+    if(!names[i])
+      continue;
+    size_t len = strlen(names[i]) + 1;
+    if(arena) {
+      char* packed = arena + *pos;
+      memcpy(packed, names[i], len);
+      release(p, names[i]);
+      names[i] = packed;
+    }
+    *pos += len;
+  }
+  *pos = ARENA_ROUND(*pos);
+}
+
+#define PACK(ARR)                                                         \
+  p->ARR = pack(p, arena, &pos, p->ARR, p->ARR##_size * sizeof(p->ARR[0])); \
+  if(arena)                                                               \
+    p->ARR##_capacity = p->ARR##_size;
+
+#define PACK_INDEX(IDX)  \
+  p->IDX.slots = pack(   \
+    p, arena, &pos, p->IDX.slots, p->IDX.capacity * sizeof(miniexact_link));
+
+static size_t
+compact(miniexact_problem* p, char* arena) {
+  size_t pos = 0;
+  PACK(llink)
+  PACK(rlink)
+#ifdef MINIEXACT_INTERLEAVED_NODES
+  PACK(node)
+#else
+  PACK(ulink)
+  PACK(dlink)
+  PACK(top)
+  PACK(color)
+#endif
+  PACK(cost)
+  PACK(slack)
+  PACK(bound)
+  // Names go before their arrays, which are released while packing.
+  pack_names(p, arena, &pos, p->name, p->name_size);
+  pack_names(p, arena, &pos, p->color_name, p->color_name_size);
+  PACK(name)
+  PACK(color_name)
+  PACK_INDEX(name_index)
+  PACK_INDEX(color_name_index)
+  return pos;
+}
+
+#undef PACK
+#undef PACK_INDEX
+
+void
+miniexact_problem_compact(miniexact_problem* p) {
+  assert(p);
+  // Binary problems already live in one block.
+  if(p->mapped)
+    return;
+
+  size_t size = compact(p, NULL);
+  void* old_arena = p->arena;
+  char* arena = miniexact_malloc(size ? size : 1);
+  compact(p, arena);
+
+  p->arena = arena;
+  p->arena_size = size;
+  if(old_arena)
+    miniexact_free(old_arena);
 }
 
 miniexact_link
 miniexact_item_from_ident(miniexact_problem* p, const char* ident) {
-  return miniexact_search_for_name(ident, p->name, p->name_size);
+  return name_index_find(&p->name_index, p->name, ident);
 }
 
 miniexact_link
 miniexact_insert_ident_as_name(miniexact_problem* p, const char* ident) {
   miniexact_link l = p->name_size;
   MINIEXACT_ARR_PLUS1(name)
-  p->name[l] = strdup(ident);
+  p->name[l] = miniexact_strdup(ident);
+  name_index_insert(p, &p->name_index, p->name, l);
   return l;
 }
 
@@ -130,7 +479,7 @@ miniexact_append_NULL_to_name(miniexact_problem* p) {
 
 miniexact_link
 miniexact_color_from_ident(miniexact_problem* p, const char* ident) {
-  return miniexact_search_for_name(ident, p->color_name, p->color_name_size);
+  return name_index_find(&p->color_name_index, p->color_name, ident);
 }
 
 miniexact_link
@@ -139,7 +488,8 @@ miniexact_color_from_ident_or_insert(miniexact_problem* p, const char* ident) {
   if(l == -1) {
     l = p->color_name_size;
     MINIEXACT_ARR_PLUS1(color_name)
-    p->color_name[l] = strdup(ident);
+    p->color_name[l] = miniexact_strdup(ident);
+    name_index_insert(p, &p->color_name_index, p->color_name, l);
   }
   return l;
 }
@@ -165,22 +515,23 @@ miniexact_print_problem_matrix(miniexact_problem* p) {
     }
   }
   printf("\n");
-  for(size_t x = 0; x < p->ulink_size; ++x) {
+  for(size_t x = 0; x < MINIEXACT_NODES_SIZE(p); ++x) {
     printf("x:%zu\tTOP/LEN:%d\tULINK:%d\tDLINK:%d\tCOLOR:%d\n",
            x,
-           p->top[x],
-           p->ulink[x],
-           p->dlink[x],
-           p->color[x]);
+           TOP(x),
+           ULINK(x),
+           DLINK(x),
+           COLOR(x));
   }
 }
 
 const char*
 miniexact_print_problem_matrix_in_libexact_format(miniexact_problem* p) {
-  if(p->color_size)
-    return "Colors not supported in libexact format!";
   if(p->secondary_item_count)
     return "Secondary items not supported in libexact format!";
+  for(size_t x = 0; x < MINIEXACT_NODES_SIZE(p); ++x)
+    if(COLOR(x) > 0)
+      return "Colors not supported in libexact format!";
 
   for(miniexact_link i = 1; i <= p->primary_item_count; ++i) {
     printf("# %s %d\n", NAME(i), i);
@@ -194,7 +545,7 @@ miniexact_print_problem_matrix_in_libexact_format(miniexact_problem* p) {
   }
 
   for(miniexact_link i = p->N_1 + 1, option = 0;
-      option < p->option_count && i < p->ulink_size;
+      option < p->option_count && i < MINIEXACT_NODES_SIZE(p);
       ++i) {
     if(TOP(i) <= 0)
       ++option;
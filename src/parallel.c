@@ -0,0 +1,236 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef MINIEXACT_THREADS_AVAILABLE
+#include <pthread.h>
+#endif
+
+#include <miniexact/algorithm.h>
+#include <miniexact/log.h>
+#include <miniexact/miniexact.h>
+#include <miniexact/parallel.h>
+#include <miniexact/util.h>
+
+// Subtrees per worker that the split level should provide at least. More
+// subtrees give better balancing, but each worker walks the shallow tree.
+#define SUBTREES_PER_WORKER 64
+#define MAX_SPLIT_LEVEL 32
+
+typedef struct miniexact_parallel {
+  miniexact_algorithm* a;
+  miniexact_config* cfg;
+  miniexact_link split_level;
+  atomic_llong next_ticket;
+  int solutions;
+#ifdef MINIEXACT_THREADS_AVAILABLE
+  pthread_mutex_t output_lock;
+#endif
+} miniexact_parallel;
+
+struct miniexact_parallel_worker {
+  miniexact_parallel* shared;
+  miniexact_problem* p;
+  int id;
+  bool counting;
+
+  // Number of subtrees seen at the split level and the one to explore next.
+  long long encountered;
+  long long ticket;
+#ifdef MINIEXACT_THREADS_AVAILABLE
+  pthread_t thread;
+#endif
+};
+
+bool
+miniexact_parallel_claim(miniexact_parallel_worker* w, miniexact_link l) {
+  if(l + 1 != w->shared->split_level)
+    return true;
+
+  long long k = w->encountered++;
+  if(w->counting)
+    return false;
+
+  // The last claimed subtree has been explored (or this is the first one), so
+  // draw the next ticket. Tickets are handed out in increasing order, so the
+  // new one is never behind k.
+  if(k > w->ticket)
+    w->ticket = atomic_fetch_add(&w->shared->next_ticket, 1);
+  return k == w->ticket;
+}
+
+#ifdef MINIEXACT_THREADS_AVAILABLE
+
+static bool
+is_supported(miniexact_config* cfg) {
+  int s = cfg->algorithm_select;
+  return (s & (MINIEXACT_ALGORITHM_X | MINIEXACT_ALGORITHM_C)) &&
+         !(s & (MINIEXACT_ALGORITHM_DOLLARS | MINIEXACT_ALGORITHM_BITSET));
+}
+
+// Walk the search tree down to level l and count the subtrees starting there.
+// Leaves p in its initial state.
+static long long
+count_subtrees(miniexact_parallel* s, miniexact_problem* p, miniexact_link l) {
+  miniexact_parallel_worker counter;
+  memset(&counter, 0, sizeof(counter));
+  counter.shared = s;
+  counter.counting = true;
+
+  s->split_level = l;
+  p->worker = &counter;
+  p->state = 0;
+  while(s->a->compute_next_result(s->a, p)) {
+  }
+  p->worker = NULL;
+  p->state = 0;
+
+  return counter.encountered;
+}
+
+static miniexact_link
+choose_split_level(miniexact_parallel* s, miniexact_problem* p) {
+  const long long target = (long long)s->cfg->threads * SUBTREES_PER_WORKER;
+  long long best = 0;
+  miniexact_link best_l = 1;
+  for(miniexact_link l = 1; l <= MAX_SPLIT_LEVEL; ++l) {
+    long long count = count_subtrees(s, p, l);
+    if(count <= best)
+      break;// The tree does not get any wider.
+    best = count;
+    best_l = l;
+    if(count >= target)
+      break;
+  }
+  return best_l;
+}
+
+static void*
+worker_main(void* userdata) {
+  miniexact_parallel_worker* w = userdata;
+  miniexact_parallel* s = w->shared;
+  miniexact_problem* p = w->p;
+
+  while(s->a->compute_next_result(s->a, p)) {
+    // Solutions above the split level are found by every worker.
+    if(p->l < s->split_level && w->id != 0)
+      continue;
+
+    pthread_mutex_lock(&s->output_lock);
+    if(miniexact_print_solution(p, s->cfg))
+      ++s->solutions;
+    printf("\n");
+    pthread_mutex_unlock(&s->output_lock);
+  }
+  return NULL;
+}
+
+// Search counters of the workers add up, the times overlap.
+static void
+add_stats(miniexact_stats* to, const miniexact_stats* from) {
+  to->nodes += from->nodes;
+  to->updates += from->updates;
+  to->mems += from->mems;
+  to->choose_scans += from->choose_scans;
+}
+
+int
+miniexact_parallel_solve_and_print_solutions(miniexact_algorithm* a,
+                                             miniexact_problem* p,
+                                             miniexact_config* cfg) {
+  assert(a);
+  assert(p);
+  assert(cfg);
+
+  miniexact_config sequential = *cfg;
+  sequential.threads = 1;
+
+  if(!is_supported(cfg)) {
+    miniexact_err("Parallel enumeration is only supported for Algorithms X "
+                  "and C! Falling back to one thread.");
+    return miniexact_solve_problem_and_print_solutions(a, p, &sequential);
+  }
+
+  miniexact_parallel s;
+  memset(&s, 0, sizeof(s));
+  s.a = a;
+  s.cfg = cfg;
+  atomic_init(&s.next_ticket, 0);
+
+  double start = miniexact_seconds();
+  if(count_subtrees(&s, p, 1) == 0)
+    // Nothing to split, either trivial or some item is missing.
+    return miniexact_solve_problem_and_print_solutions(a, p, &sequential);
+
+  s.split_level = choose_split_level(&s, p);
+  miniexact_dbg("Splitting search at level %d for %d workers",
+                s.split_level,
+                cfg->threads);
+
+  pthread_mutex_init(&s.output_lock, NULL);
+
+  int workers_count = cfg->threads;
+  miniexact_parallel_worker* workers =
+    calloc(workers_count, sizeof(miniexact_parallel_worker));
+
+  for(int i = 0; i < workers_count; ++i) {
+    miniexact_parallel_worker* w = &workers[i];
+    w->shared = &s;
+    w->id = i;
+    w->ticket = -1;
+    w->p = miniexact_problem_clone(p);
+    w->p->worker = w;
+    w->p->state = 0;
+    memset(&w->p->stats, 0, sizeof(w->p->stats));
+    if(pthread_create(&w->thread, NULL, &worker_main, w) != 0) {
+      miniexact_err("Could not start worker thread %d!", i);
+      miniexact_problem_free(w->p, a);
+      w->p = NULL;
+      workers_count = i;
+      break;
+    }
+  }
+
+  if(workers_count == 0) {
+    free(workers);
+    pthread_mutex_destroy(&s.output_lock);
+    return miniexact_solve_problem_and_print_solutions(a, p, &sequential);
+  }
+
+  for(int i = 0; i < workers_count; ++i) {
+    pthread_join(workers[i].thread, NULL);
+    add_stats(&p->stats, &workers[i].p->stats);
+    miniexact_problem_free(workers[i].p, a);
+  }
+
+  free(workers);
+  pthread_mutex_destroy(&s.output_lock);
+  p->stats.solve_time += miniexact_seconds() - start;
+
+  printf("Found %d solutions!\n", s.solutions);
+
+  // Same as the sequential enumeration, which ends on an exhausted search.
+  return 20;
+}
+
+#endif
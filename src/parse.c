@@ -18,13 +18,18 @@
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <miniexact/algorithm.h>
+#include <miniexact/binary.h>
 #include <miniexact/log.h>
 #include <miniexact/miniexact.h>
 #include <miniexact/parse.h>
@@ -33,9 +38,6 @@ extern FILE* yyin;
 
 struct miniexact_parser;
 
-typedef int (*miniexact_getc)(struct miniexact_parser* p);
-typedef int (*miniexact_peekc)(struct miniexact_parser* p);
-
 typedef const char* (*miniexact_add)(struct miniexact_parser* p,
                                      int lit,
                                      uint32_t cost);
@@ -55,18 +57,22 @@ typedef enum miniexact_dimacs_problem {
 typedef struct miniexact_parser {
   miniexact_problem* p;
   miniexact_algorithm* a;
-  miniexact_getc mgetc;
-  miniexact_peekc mpeekc;
 
-  // Source for characters.
-  FILE* file;
-  const char* str;
-  size_t str_pos;
+  // Source for characters. Either a given string, a memory mapped file or a
+  // file that was read into an owned buffer. pos is the position of the next
+  // character.
+  const char* buf;
+  size_t len;
+  void* mapped;
+  char* owned;
 
   // Ident
   char ident[4096];
   size_t ident_len;
 
+  // Errors of the tokenizer, which then ends the token stream.
+  const char* error;
+
   size_t line;
   size_t col;
   size_t pos;
@@ -88,8 +94,22 @@ typedef enum miniexact_token {
   DOLLAR,
 } miniexact_token;
 
-#define GETC(P) P->mgetc(P)
-#define PEEKC(P) P->mpeekc(P)
+static inline int
+scan_getc(miniexact_parser* p) {
+  if(p->pos >= p->len)
+    return EOF;
+  return (unsigned char)p->buf[p->pos++];
+}
+
+static inline int
+scan_peekc(miniexact_parser* p) {
+  if(p->pos >= p->len)
+    return EOF;
+  return (unsigned char)p->buf[p->pos];
+}
+
+#define GETC(P) scan_getc(P)
+#define PEEKC(P) scan_peekc(P)
 
 inline static bool
 isidentchar(char c) {
@@ -149,10 +169,14 @@ next(miniexact_parser* p) {
   if(isidentchar(c)) {
     p->ident[0] = c;
     p->ident_len = 1;
-    while(PEEKC(p) != EOF && isidentchar(PEEKC(p))) {
-      char c = GETC(p);
+    while(p->pos < p->len && isidentchar(p->buf[p->pos]) &&
+          p->ident_len < sizeof(p->ident) - 1) {
+      p->ident[p->ident_len++] = p->buf[p->pos++];
       ++p->col;
-      p->ident[p->ident_len++] = c;
+    }
+    if(p->pos < p->len && isidentchar(p->buf[p->pos])) {
+      p->error = "identifier too long";
+      return END;
     }
     p->ident[p->ident_len] = '\0';
     return IDENT;
@@ -161,30 +185,6 @@ next(miniexact_parser* p) {
   return END;
 }
 
-static inline int
-miniexact_getc_str(miniexact_parser* p) {
-  if(p->str[p->str_pos] == '\0')
-    return EOF;
-  ++p->pos;
-  return p->str[p->str_pos++];
-}
-static inline int
-miniexact_peekc_str(miniexact_parser* p) {
-  return p->str[p->str_pos];
-}
-
-static inline int
-miniexact_getc_file(miniexact_parser* p) {
-  ++p->pos;
-  return getc(p->file);
-}
-static inline int
-miniexact_peekc_file(miniexact_parser* p) {
-  // Thanks to https://stackoverflow.com/a/7623338
-  const int c = getc(p->file);
-  return c == EOF ? EOF : ungetc(c, p->file);
-}
-
 static inline bool
 faster_is_digit(int ch) {
   return '0' <= ch && ch <= '9';
@@ -385,6 +385,9 @@ parse_dimacs_init_xc(miniexact_parser* p, int primaries, int secondaries) {
   if(primaries + secondaries > INT_MAX)
     return "primaries + secondaries must be smaller than INT_MAX";
 
+  // The header gives the exact number of items.
+  miniexact_problem_reserve(p->p, primaries + secondaries, 0, 0);
+
   const char* e = NULL;
   for(int item = 1; item <= primaries; ++item) {
     if((e = p->a->define_primary_item(p->a, p->p, item)))
@@ -451,6 +454,7 @@ parse_dimacs_add(miniexact_parser* pp, int lit, uint32_t cost) {
     }
     if((e = pp->a->end_option(pp->a, pp->p, cost)))
       return e;
+    ++pp->p->option_count;
   } else {
     return "invalid lit";
   }
@@ -476,7 +480,7 @@ parse_dimacs(miniexact_parser* p) {
 }
 
 static const char*
-parse(miniexact_parser* p) {
+parse_tokens(miniexact_parser* p) {
   // Read problem header (primary items, secondary items), then read all
   // options.
   const char* e = NULL;
@@ -537,7 +541,9 @@ parse(miniexact_parser* p) {
   } else if(t == IDENT && p->ident_len == 1 && p->ident[0] == 'p') {
     // Use the dimacs format to parse this problem! There, no tokenizer is used,
     // so we exit from the general parsing function.
-    return parse_dimacs(p);
+    if((e = parse_dimacs(p)))
+      return e;
+    return p->a->end_options(p->a, p->p);
   } else {
     return "no primary item definitions given";
   }
@@ -617,27 +623,113 @@ parse(miniexact_parser* p) {
   return p->a->end_options(p->a, p->p);
 }
 
+static const char*
+parse(miniexact_parser* p) {
+  const char* e = parse_tokens(p);
+  // The parser only saw the token stream end early.
+  if(p->error)
+    return p->error;
+  return e;
+}
+
+// Counts whitespace separated words in the input. Every node of the matrix is
+// at least one word, so this bounds the number of nodes from above without
+// being far off. The arrays are compacted after parsing anyway.
+static size_t
+count_words(const char* buf, size_t len) {
+  size_t words = 0;
+  bool in_word = false;
+  for(size_t i = 0; i < len; ++i) {
+    bool space = buf[i] == ' ' || buf[i] == '\n' || buf[i] == '\t' ||
+                 buf[i] == '\r';
+    words += !space && !in_word;
+    in_word = !space;
+  }
+  return words;
+}
+
+static void
+unmap_file(miniexact_parser* p) {
+  if(p->mapped)
+    munmap(p->mapped, p->len);
+  if(p->owned)
+    free(p->owned);
+  p->mapped = NULL;
+  p->owned = NULL;
+}
+
+// Makes the whole file available as one buffer. Regular files are mapped into
+// memory, everything else (e.g. pipes) is read in large blocks.
+static bool
+map_file(miniexact_parser* p, const char* file_path) {
+  int fd = open(file_path, O_RDONLY);
+  if(fd < 0)
+    return false;
+
+  struct stat st;
+  if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(m != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+      madvise(m, st.st_size, MADV_SEQUENTIAL);
+#endif
+      close(fd);
+      p->mapped = m;
+      p->buf = m;
+      p->len = st.st_size;
+      return true;
+    }
+  }
+
+  size_t capacity = 1 << 20;
+  size_t len = 0;
+  char* buf = malloc(capacity);
+  ssize_t r;
+  while(buf && (r = read(fd, buf + len, capacity - len)) != 0) {
+    if(r < 0) {
+      if(errno == EINTR)
+        continue;
+      free(buf);
+      close(fd);
+      return false;
+    }
+    len += r;
+    if(len == capacity) {
+      capacity *= 2;
+      char* grown = realloc(buf, capacity);
+      if(!grown)
+        free(buf);
+      buf = grown;
+    }
+  }
+  close(fd);
+  if(!buf)
+    return false;
+
+  p->owned = buf;
+  p->buf = buf;
+  p->len = len;
+  return true;
+}
+
 miniexact_problem*
 miniexact_parse_problem(miniexact_algorithm* a, const char* str) {
-  int i;
-
   miniexact_parser p;
   memset(&p, 0, sizeof(p));
   const char* error = NULL;
 
   miniexact_problem* problem = miniexact_problem_allocate();
+  p.p = problem;
   if((error = miniexact_default_init_problem(a, problem)))
     goto ERROR;
 
   p.a = a;
-  p.str = str;
-  p.str_pos = 0;
-  p.p = problem;
-  p.file = NULL;
+  p.buf = str;
+  p.len = strlen(str);
+  p.pos = 0;
   p.ident_len = 0;
 
-  p.mgetc = &miniexact_getc_str;
-  p.mpeekc = &miniexact_peekc_str;
+  miniexact_problem_reserve(problem, 0, count_words(p.buf, p.len), 0);
 
   if((error = parse(&p)))
     goto ERROR;
@@ -652,30 +744,33 @@ ERROR:
 
 miniexact_problem*
 miniexact_parse_problem_file(miniexact_algorithm* a, const char* file_path) {
-  FILE* f = fopen(file_path, "r");
-  if(!f) {
+  miniexact_parser p;
+  memset(&p, 0, sizeof(p));
+
+  if(!map_file(&p, file_path)) {
     miniexact_err(
       "Could not open file %s, error: %s", file_path, strerror(errno));
     return NULL;
   }
 
+  // Precompiled problems are mapped directly instead of being parsed.
+  if(miniexact_is_problem_binary(p.buf, p.len)) {
+    unmap_file(&p);
+    return miniexact_load_problem_binary(a, file_path);
+  }
+
   const char* error = NULL;
 
   miniexact_problem* problem = miniexact_problem_allocate();
-  if((error = miniexact_default_init_problem(a, problem)))
-    goto ERROR;
-
-  miniexact_parser p;
-  memset(&p, 0, sizeof(p));
   p.a = a;
-  p.file = f;
   p.p = problem;
-  p.str = NULL;
-  p.str_pos = 0;
+  p.pos = 0;
   p.ident_len = 0;
 
-  p.mgetc = &miniexact_getc_file;
-  p.mpeekc = &miniexact_peekc_file;
+  if((error = miniexact_default_init_problem(a, problem)))
+    goto ERROR;
+
+  miniexact_problem_reserve(problem, 0, count_words(p.buf, p.len), 0);
 
   if((error = parse(&p)))
     goto ERROR;
@@ -685,10 +780,11 @@ miniexact_parse_problem_file(miniexact_algorithm* a, const char* file_path) {
     goto ERROR;
   }
 
-  fclose(f);
+  unmap_file(&p);
   return problem;
 ERROR:
   assert(problem);
+  unmap_file(&p);
   miniexact_problem_free(problem, a);
   miniexact_err(
     "Parse error at %u:%u (pos %u) %s", p.line, p.col, p.pos, error);
@@ -0,0 +1,322 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <miniexact/ops.h>
+#include <miniexact/preprocess.h>
+
+typedef struct preprocess {
+  miniexact_problem* p;
+  bool colors;
+  // Items are marked with the current stamp once they were seen for the
+  // option that is checked.
+  size_t* mark;
+  size_t stamp;
+  // Primary items outside of the checked option that share some option with
+  // it. Only these can lose all their options when it is committed.
+  miniexact_link* touched;
+  size_t touched_size;
+  // Set for the spacer after every removed option.
+  bool* removed;
+} preprocess;
+
+static bool
+has_multiplicities(miniexact_problem* p) {
+  // Plain primary items are either [1;1] or the default of
+  // define_primary_item (SLACK 1, BOUND 0).
+  for(miniexact_link i = 1; i <= p->N_1; ++i)
+    if(BOUND(i) > 1 || (BOUND(i) == 1 && SLACK(i) > 0))
+      return true;
+  return false;
+}
+
+// Like in step C5 of Algorithm C, the option is first hidden through one of
+// its primary items, so that purifying does not mark its own nodes.
+static void
+commit(preprocess* pp, miniexact_link x, miniexact_link e, miniexact_link f) {
+  miniexact_problem* p = pp->p;
+  COVER_PRIME(TOP(f));
+  for(miniexact_link q = x; q < e; ++q) {
+    if(q == f)
+      continue;
+    if(pp->colors)
+      COMMIT(q, TOP(q));
+    else
+      COVER_PRIME(TOP(q));
+  }
+}
+
+static void
+uncommit(preprocess* pp, miniexact_link x, miniexact_link e, miniexact_link f) {
+  miniexact_problem* p = pp->p;
+  for(miniexact_link q = e - 1; q >= x; --q) {
+    if(q == f)
+      continue;
+    if(pp->colors)
+      UNCOMMIT(q, TOP(q));
+    else
+      UNCOVER_PRIME(TOP(q));
+  }
+  UNCOVER_PRIME(TOP(f));
+}
+
+// Checks whether the option with nodes x..e-1 leaves some primary item
+// without options once it is committed. Options without primary items are
+// never chosen by the search, so they count as blocked too.
+static bool
+blocked(preprocess* pp, miniexact_link x, miniexact_link e) {
+  miniexact_problem* p = pp->p;
+
+  miniexact_link f = x;
+  while(f < e && TOP(f) > p->N_1)
+    ++f;
+  if(f == e)
+    return true;
+
+  ++pp->stamp;
+  for(miniexact_link q = x; q < e; ++q)
+    pp->mark[TOP(q)] = pp->stamp;
+
+  pp->touched_size = 0;
+  for(miniexact_link q = x; q < e; ++q) {
+    miniexact_link j = TOP(q);
+    for(miniexact_link r = DLINK(j); r != j; r = DLINK(r)) {
+      if(r == q)
+        continue;
+      miniexact_link s = r + 1;
+      while(s != r) {
+        miniexact_link k = TOP(s);
+        if(k <= 0) {
+          s = ULINK(s);
+          continue;
+        }
+        if(k <= p->N_1 && pp->mark[k] != pp->stamp) {
+          pp->mark[k] = pp->stamp;
+          pp->touched[pp->touched_size++] = k;
+        }
+        ++s;
+      }
+    }
+  }
+
+  commit(pp, x, e, f);
+  bool b = false;
+  for(size_t t = 0; t < pp->touched_size && !b; ++t)
+    b = LEN(pp->touched[t]) == 0;
+  uncommit(pp, x, e, f);
+  return b;
+}
+
+// Unlinks the option from all its items. Returns true if some primary item
+// has no options left, i.e. the problem has no solution.
+static bool
+remove_option(preprocess* pp, miniexact_link x, miniexact_link e) {
+  miniexact_problem* p = pp->p;
+  bool unsat = false;
+  for(miniexact_link q = x; q < e; ++q) {
+    // Nodes of detached secondary items are already linked to themselves.
+    if(ULINK(q) == q)
+      continue;
+    miniexact_link j = TOP(q);
+    DLINK(ULINK(q)) = DLINK(q);
+    ULINK(DLINK(q)) = ULINK(q);
+    LEN(j) = LEN(j) - 1;
+    if(j <= p->N_1 && LEN(j) == 0)
+      unsat = true;
+  }
+  pp->removed[e] = true;
+  ++p->preprocess.removed_options;
+  return unsat;
+}
+
+static bool
+remove_blocked_options(preprocess* pp, bool* unsat) {
+  miniexact_problem* p = pp->p;
+  bool changed = false;
+  miniexact_link x = p->N + 2;
+  while(x < p->Z) {
+    // Empty options consist only of their spacer.
+    if(TOP(x) <= 0) {
+      ++x;
+      continue;
+    }
+    miniexact_link e = x;
+    while(TOP(e) > 0)
+      ++e;
+    if(!pp->removed[e] && blocked(pp, x, e)) {
+      changed = true;
+      if(remove_option(pp, x, e)) {
+        *unsat = true;
+        return true;
+      }
+    }
+    x = e + 1;
+  }
+  return changed;
+}
+
+static bool
+useless(preprocess* pp, miniexact_link j) {
+  miniexact_problem* p = pp->p;
+  if(LEN(j) <= 1)
+    return true;
+  if(!pp->colors)
+    return false;
+  miniexact_color c = COLOR(DLINK(j));
+  if(c <= 0)
+    return false;
+  for(miniexact_link q = DLINK(j); q != j; q = DLINK(q))
+    if(COLOR(q) != c)
+      return false;
+  return true;
+}
+
+// Unlinks secondary items that cannot cause any conflict. Their nodes are
+// linked to themselves, so covering and hiding leave them alone.
+static void
+detach_useless_secondary_items(preprocess* pp) {
+  miniexact_problem* p = pp->p;
+  for(miniexact_link j = p->N_1 + 1; j <= p->N; ++j) {
+    if(LLINK(j) == j || !useless(pp, j))
+      continue;
+
+    miniexact_link q = DLINK(j);
+    while(q != j) {
+      miniexact_link next = DLINK(q);
+      ULINK(q) = q;
+      DLINK(q) = q;
+      q = next;
+    }
+    ULINK(j) = j;
+    DLINK(j) = j;
+    LEN(j) = 0;
+
+    RLINK(LLINK(j)) = RLINK(j);
+    LLINK(RLINK(j)) = LLINK(j);
+    LLINK(j) = j;
+    RLINK(j) = j;
+    ++p->preprocess.removed_secondary_items;
+  }
+}
+
+// Moves the nodes of all remaining options together. Spacers keep their TOP,
+// i.e. the original index of the option before them.
+static void
+compact_nodes(preprocess* pp) {
+  miniexact_problem* p = pp->p;
+  size_t nodes = MINIEXACT_NODES_SIZE(p);
+  assert((size_t)p->Z == nodes - 1);
+  assert(p->cost_size >= nodes);
+
+  miniexact_link* map = malloc(nodes * sizeof(miniexact_link));
+  for(miniexact_link i = 0; i <= p->N + 1; ++i)
+    map[i] = i;
+
+  miniexact_link n = p->N + 2;
+  for(miniexact_link x = p->N + 2; (size_t)x < nodes;) {
+    miniexact_link e = x;
+    while(TOP(e) > 0)
+      ++e;
+    bool keep = !pp->removed[e];
+    for(; x <= e; ++x)
+      map[x] = keep ? n++ : -1;
+  }
+
+  // Nodes only move to lower indices, so nothing is overwritten before it
+  // was read.
+  for(miniexact_link x = p->N + 2; (size_t)x < nodes; ++x) {
+    miniexact_link y = map[x];
+    if(y < 0)
+      continue;
+    miniexact_link t = TOP(x);
+    if(t > 0) {
+      ULINK(y) = map[ULINK(x)];
+      DLINK(y) = map[DLINK(x)];
+    }
+    TOP(y) = t;
+    COLOR(y) = COLOR(x);
+    COST(y) = COST(x);
+  }
+
+  for(miniexact_link i = 1; i <= p->N; ++i) {
+    ULINK(i) = map[ULINK(i)];
+    DLINK(i) = map[DLINK(i)];
+  }
+
+  // Spacers point to the first node of the option before them and the last
+  // node of the option after them.
+  miniexact_link prev = p->N + 1;
+  for(miniexact_link y = p->N + 2; y < n; ++y) {
+    if(TOP(y) > 0)
+      continue;
+    ULINK(y) = prev + 1;
+    DLINK(prev) = y - 1;
+    prev = y;
+  }
+  DLINK(prev) = 0;
+
+#ifdef MINIEXACT_INTERLEAVED_NODES
+  p->node_size = n;
+#else
+  p->ulink_size = n;
+  p->dlink_size = n;
+  p->top_size = n;
+  p->color_size = n;
+#endif
+  p->cost_size = n;
+  p->Z = n - 1;
+
+  free(map);
+}
+
+void
+miniexact_preprocess(miniexact_problem* p, bool colors) {
+  assert(p);
+  memset(&p->preprocess, 0, sizeof(p->preprocess));
+
+  if(p->N_1 < 1 || has_multiplicities(p))
+    return;
+  // Nothing to gain, the search fails right away.
+  for(miniexact_link i = 1; i <= p->N_1; ++i)
+    if(LEN(i) == 0)
+      return;
+
+  size_t nodes = MINIEXACT_NODES_SIZE(p);
+  preprocess pp = { .p = p, .colors = colors };
+  pp.mark = calloc(p->N + 1, sizeof(size_t));
+  pp.touched = malloc(p->N_1 * sizeof(miniexact_link));
+  pp.removed = calloc(nodes, sizeof(bool));
+
+  // Removing an option may block others, detaching secondary items cannot.
+  bool unsat = false, changed;
+  do {
+    ++p->preprocess.rounds;
+    changed = remove_blocked_options(&pp, &unsat);
+    detach_useless_secondary_items(&pp);
+  } while(changed && !unsat);
+
+  if(p->preprocess.removed_options)
+    compact_nodes(&pp);
+
+  free(pp.mark);
+  free(pp.touched);
+  free(pp.removed);
+}
@@ -0,0 +1,144 @@
+/*
+    miniexact - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <miniexact/ops.h>
+#include <miniexact/profile.h>
+#include <miniexact/util.h>
+
+static miniexact_profile_level*
+level(miniexact_profile* pr, miniexact_link l) {
+  assert(l >= 0);
+  if((size_t)l >= pr->levels_capacity) {
+    size_t capacity = pr->levels_capacity ? pr->levels_capacity * 2 : 64;
+    while(capacity <= (size_t)l)
+      capacity *= 2;
+    pr->levels =
+      realloc(pr->levels, capacity * sizeof(miniexact_profile_level));
+    memset(pr->levels + pr->levels_capacity,
+           0,
+           (capacity - pr->levels_capacity) * sizeof(miniexact_profile_level));
+    pr->levels_capacity = capacity;
+  }
+  if((size_t)l >= pr->levels_size)
+    pr->levels_size = l + 1;
+  return &pr->levels[l];
+}
+
+// Charges the time since the last change of the level to the old level.
+static void
+tick(miniexact_profile* pr, miniexact_link l) {
+  double now = miniexact_seconds();
+  level(pr, pr->level)->time += now - pr->last;
+  pr->last = now;
+  pr->level = l;
+
+  if(pr->dump_requested) {
+    pr->dump_requested = 0;
+    miniexact_profile_print(pr, stderr);
+  }
+}
+
+void
+miniexact_profile_init(miniexact_profile* pr, miniexact_problem* p) {
+  assert(pr);
+  assert(p);
+  memset(pr, 0, sizeof(*pr));
+  level(pr, 0)->nodes = 1;
+  pr->last = miniexact_seconds();
+  p->profile = pr;
+}
+
+void
+miniexact_profile_choose(miniexact_profile* pr, miniexact_problem* p) {
+  miniexact_profile_level* lv = level(pr, p->l);
+  ++lv->choices;
+  lv->len_sum += LEN(p->i);
+}
+
+void
+miniexact_profile_enter(miniexact_profile* pr, miniexact_problem* p) {
+  ++level(pr, p->l)->nodes;
+  tick(pr, p->l);
+}
+
+void
+miniexact_profile_leave(miniexact_profile* pr, miniexact_problem* p) {
+  ++level(pr, p->l)->backtracks;
+  tick(pr, p->l - 1);
+}
+
+void
+miniexact_profile_print(miniexact_profile* pr, FILE* f) {
+  fprintf(f,
+          "%6s %14s %10s %10s %14s %12s\n",
+          "level",
+          "nodes",
+          "branching",
+          "avg len",
+          "backtracks",
+          "time [s]");
+  for(size_t l = 0; l < pr->levels_size; ++l) {
+    miniexact_profile_level* lv = &pr->levels[l];
+    double branching = l + 1 < pr->levels_size && lv->nodes
+                         ? (double)pr->levels[l + 1].nodes / lv->nodes
+                         : 0;
+    double len = lv->choices ? (double)lv->len_sum / lv->choices : 0;
+    fprintf(f,
+            "%6zu %14" PRIu64 " %10.3f %10.3f %14" PRIu64 " %12.6f\n",
+            l,
+            lv->nodes,
+            branching,
+            len,
+            lv->backtracks,
+            lv->time);
+  }
+}
+
+void
+miniexact_profile_print_csv(miniexact_profile* pr, FILE* f) {
+  fprintf(f, "level,nodes,branching,avg_len,backtracks,time\n");
+  for(size_t l = 0; l < pr->levels_size; ++l) {
+    miniexact_profile_level* lv = &pr->levels[l];
+    double branching = l + 1 < pr->levels_size && lv->nodes
+                         ? (double)pr->levels[l + 1].nodes / lv->nodes
+                         : 0;
+    double len = lv->choices ? (double)lv->len_sum / lv->choices : 0;
+    fprintf(f,
+            "%zu,%" PRIu64 ",%g,%g,%" PRIu64 ",%g\n",
+            l,
+            lv->nodes,
+            branching,
+            len,
+            lv->backtracks,
+            lv->time);
+  }
+}
+
+void
+miniexact_profile_finish(miniexact_profile* pr, miniexact_problem* p) {
+  assert(pr);
+  free(pr->levels);
+  pr->levels = NULL;
+  pr->levels_size = 0;
+  pr->levels_capacity = 0;
+  p->profile = NULL;
+}
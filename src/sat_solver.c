@@ -17,7 +17,10 @@
 */
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <math.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -97,7 +100,7 @@ find_executable(const char* name, char** overwrite) {
     assert(strlen(path) == path_len);
     res = file_readable(path);
     miniexact_trc("Trying %s", path);
-    if(overwrite)
+    if(res && overwrite)
       *overwrite = strdup(path);
     free(path);
   }
@@ -113,23 +116,85 @@ static char* known_sat_solver_args[][2] = { { "-q", NULL },
 					    { NULL },
                                             NULL };
 
-static size_t
-find_solver_id() {
-  static bool id_found = false;
-  static ssize_t id = 0;
+static char* no_sat_solver_args[] = { NULL };
 
-  if(id_found)
-    return id;
+// Solvers that are started for every CNF. Without a portfolio, this is only
+// the first known solver found in $PATH.
+typedef struct portfolio_solver {
+  char* name;
+  char* path;
+  char* const* args;
+  size_t races;
+  size_t wins;
+  double win_time;
+} portfolio_solver;
 
-  for(size_t i = 0; known_sat_solvers[i]; ++i) {
-    const char* solver = known_sat_solvers[i];
-    char* path;
-    if(find_executable(solver, &known_sat_solvers[i])) {
-      id_found = true;
-      id = i;
-      return i;
-    }
+static const char* portfolio_list = NULL;
+static portfolio_solver* portfolio = NULL;
+static size_t portfolio_size = 0;
+
+void
+miniexact_sat_solver_set_portfolio(const char* list) {
+  for(size_t i = 0; i < portfolio_size; ++i) {
+    free(portfolio[i].name);
+    free(portfolio[i].path);
   }
+  free(portfolio);
+  portfolio = NULL;
+  portfolio_size = 0;
+  portfolio_list = list;
+}
+
+bool
+miniexact_sat_solver_portfolio_configured(void) {
+  return portfolio_list != NULL;
+}
+
+static bool
+add_solver(const char* name) {
+  char* path = NULL;
+  if(strchr(name, '/')) {
+    if(!file_readable(name))
+      return false;
+    path = strdup(name);
+  } else if(!find_executable(name, &path)) {
+    return false;
+  }
+
+  const char* base = strrchr(name, '/');
+  base = base ? base + 1 : name;
+
+  char* const* args = no_sat_solver_args;
+  for(size_t i = 0; known_sat_solvers[i]; ++i)
+    if(strcmp(base, known_sat_solvers[i]) == 0)
+      args = known_sat_solver_args[i];
+
+  portfolio =
+    realloc(portfolio, (portfolio_size + 1) * sizeof(portfolio_solver));
+  portfolio[portfolio_size++] =
+    (portfolio_solver){ strdup(base), path, args, 0, 0, 0 };
+  return true;
+}
+
+static void
+find_solvers() {
+  if(portfolio_size)
+    return;
+
+  if(portfolio_list && *portfolio_list) {
+    char* list = strdup(portfolio_list);
+    for(char* name = strtok(list, ","); name; name = strtok(NULL, ","))
+      if(!add_solver(name))
+        miniexact_err("SAT solver %s of the portfolio not found!", name);
+    free(list);
+  } else {
+    for(size_t i = 0; known_sat_solvers[i]; ++i)
+      if(add_solver(known_sat_solvers[i]) && !portfolio_list)
+        break;
+  }
+
+  if(portfolio_size)
+    return;
 
   miniexact_err(
     "No SAT solver found! Please install one of the supported solvers.\n"
@@ -141,64 +206,158 @@ find_solver_id() {
 }
 
 void
-miniexact_sat_solver_find_and_init(miniexact_sat_solver* solver,
-                                   unsigned int variables,
-                                   unsigned int clauses) {
-  assert(solver);
+miniexact_sat_solver_print_portfolio_stats(FILE* f) {
+  fprintf(f, "%-16s %8s %8s %12s\n", "Solver", "Races", "Wins", "Win time");
+  for(size_t i = 0; i < portfolio_size; ++i)
+    fprintf(f,
+            "%-16s %8zu %8zu %11.3fs\n",
+            portfolio[i].name,
+            portfolio[i].races,
+            portfolio[i].wins,
+            portfolio[i].win_time);
+}
+
+// A solver that exits before reading everything must not kill the program, so
+// SIGPIPE is ignored while writing and the previous handler restored after.
+static void
+write_all(miniexact_sat_solver_process* process,
+          const char* data,
+          size_t len) {
+  void (*previous)(int) = signal(SIGPIPE, SIG_IGN);
+  while(len > 0 && process->in >= 0) {
+    ssize_t written = write(process->in, data, len);
+    if(written < 0) {
+      if(errno == EINTR)
+        continue;
+      // The solver exited early, its exit code tells what happened.
+      close(process->in);
+      process->in = -1;
+      break;
+    }
+    data += written;
+    len -= written;
+  }
+  signal(SIGPIPE, previous);
+}
 
-  size_t solver_id = find_solver_id();
-  miniexact_sat_solver_init(solver,
-                            variables,
-                            clauses,
-                            known_sat_solvers[solver_id],
-                            known_sat_solver_args[solver_id],
-                            environ);
+static void
+flush(miniexact_sat_solver* solver) {
+  for(size_t i = 0; i < solver->processes_count; ++i)
+    write_all(&solver->processes[i], solver->buffer, solver->buffer_len);
+  solver->buffer_len = 0;
 }
 
-void
-miniexact_sat_solver_init(miniexact_sat_solver* solver,
-                          unsigned int variables,
-                          unsigned int clauses,
-                          char* binary,
-                          char* const argv[],
-                          char* envp[]) {
+// Makes room for len more bytes. The streaming mode writes the buffer out, the
+// one-pass mode has to keep it.
+static inline void
+reserve(miniexact_sat_solver* solver, size_t len) {
+  if(solver->buffer_len + len <= solver->buffer_size)
+    return;
+  if(!solver->one_pass) {
+    flush(solver);
+    return;
+  }
+  while(solver->buffer_len + len > solver->buffer_size)
+    solver->buffer_size *= 2;
+  solver->buffer = realloc(solver->buffer, solver->buffer_size);
+}
+
+// Longest literal including sign and the following space or newline.
+#define LIT_MAX_LEN 12
+
+static inline void
+put_lit(miniexact_sat_solver* solver, int l, char after) {
+  char digits[LIT_MAX_LEN];
+  char* end = digits + LIT_MAX_LEN;
+  char* d = end;
+  unsigned int v = l < 0 ? -(unsigned int)l : (unsigned int)l;
+  *--d = after;
+  do {
+    *--d = '0' + v % 10;
+    v /= 10;
+  } while(v);
+  if(l < 0)
+    *--d = '-';
+
+  reserve(solver, end - d);
+  memcpy(solver->buffer + solver->buffer_len, d, end - d);
+  solver->buffer_len += end - d;
+
+  if(l < 0)
+    l = -l;
+  if(solver->one_pass && (unsigned int)l > solver->variables)
+    solver->variables = l;
+}
+
+static void
+start(miniexact_sat_solver* solver,
+      unsigned int variables,
+      unsigned int clauses,
+      bool one_pass) {
   assert(solver);
 
-  pipe(solver->infd);
-  pipe(solver->outfd);
   solver->variables = variables;
   solver->clauses = clauses;
+  solver->one_pass = one_pass;
+  solver->processes_count = 0;
 
-  solver->pid = fork();
-  if(solver->pid) {
-    // Parent
-    solver->infd_handle = fdopen(solver->infd[1], "w");
-    assert(solver->infd_handle);
-    solver->outfd_handle = fdopen(solver->outfd[0], "r");
-    assert(solver->outfd_handle);
+  if(!solver->buffer) {
+    solver->buffer_size = BUF_SIZE * 256;
+    solver->buffer = malloc(solver->buffer_size);
+  }
+  solver->buffer_len = 0;
 
-    solver->assignments =
-      realloc(solver->assignments, sizeof(char) * (variables + 1));
+  if(!one_pass) {
+    solver->buffer_len = snprintf(
+      solver->buffer, solver->buffer_size, "p cnf %u %u\n", variables, clauses);
+  } else {
+    solver->clauses = 0;
+  }
+}
 
-    fprintf(solver->infd_handle, "p cnf %u %u\n", variables, clauses);
+static void
+spawn(miniexact_sat_solver* solver,
+      char* binary,
+      char* const argv[],
+      char* envp[],
+      size_t portfolio_id) {
+  int infd[2];
+  int outfd[2];
+  pipe(infd);
+  pipe(outfd);
+
+  // Solvers started later must not inherit the ends of the parent, otherwise
+  // the earlier ones never see the end of their input.
+  fcntl(infd[1], F_SETFD, FD_CLOEXEC);
+  fcntl(outfd[0], F_SETFD, FD_CLOEXEC);
+
+  pid_t pid = fork();
+  if(pid) {
+    // Parent
+    close(infd[0]);
+    close(outfd[1]);
+
+    solver->processes =
+      realloc(solver->processes,
+              (solver->processes_count + 1) * sizeof(*solver->processes));
+    solver->processes[solver->processes_count++] =
+      (miniexact_sat_solver_process){
+        infd[1], outfd[0], pid, portfolio_id, NULL, 0, 0
+      };
   } else {
     // Child
-    dup2(solver->infd[0], STDIN_FILENO);
-    close(solver->infd[0]);
-    close(solver->infd[1]);
+    dup2(infd[0], STDIN_FILENO);
+    close(infd[0]);
+    close(infd[1]);
 
-    dup2(solver->outfd[1], STDOUT_FILENO);
-    close(solver->outfd[0]);
-    close(solver->outfd[1]);
+    dup2(outfd[1], STDOUT_FILENO);
+    close(outfd[0]);
+    close(outfd[1]);
 
     char* argv_null[1] = { NULL };
     if(argv == NULL)
       argv = argv_null;
 
-    char* envp_null[1] = { NULL };
-    if(argv == NULL)
-      argv = argv_null;
-
     if(envp == NULL) {
       envp = environ;
     }
@@ -222,6 +381,56 @@ miniexact_sat_solver_init(miniexact_sat_solver* solver,
   }
 }
 
+#define NO_PORTFOLIO ((size_t)-1)
+
+static void
+spawn_portfolio(miniexact_sat_solver* solver) {
+  find_solvers();
+
+  for(size_t i = 0; i < portfolio_size; ++i) {
+    spawn(solver, portfolio[i].path, portfolio[i].args, environ, i);
+    ++portfolio[i].races;
+  }
+}
+
+void
+miniexact_sat_solver_find_and_init(miniexact_sat_solver* solver,
+                                   unsigned int variables,
+                                   unsigned int clauses) {
+  assert(solver);
+  start(solver, variables, clauses, false);
+  spawn_portfolio(solver);
+}
+
+void
+miniexact_sat_solver_find_and_init_one_pass(miniexact_sat_solver* solver,
+                                            unsigned int variables) {
+  assert(solver);
+  start(solver, variables, 0, true);
+  spawn_portfolio(solver);
+}
+
+void
+miniexact_sat_solver_init(miniexact_sat_solver* solver,
+                          unsigned int variables,
+                          unsigned int clauses,
+                          char* binary,
+                          char* const argv[],
+                          char* envp[]) {
+  start(solver, variables, clauses, false);
+  spawn(solver, binary, argv, envp, NO_PORTFOLIO);
+}
+
+void
+miniexact_sat_solver_init_one_pass(miniexact_sat_solver* solver,
+                                   unsigned int variables,
+                                   char* binary,
+                                   char* const argv[],
+                                   char* envp[]) {
+  start(solver, variables, 0, true);
+  spawn(solver, binary, argv, envp, NO_PORTFOLIO);
+}
+
 void
 miniexact_sat_solver_destroy(miniexact_sat_solver* solver) {
   assert(solver);
@@ -229,109 +438,209 @@ miniexact_sat_solver_destroy(miniexact_sat_solver* solver) {
     free(solver->assignments);
     solver->assignments = NULL;
   }
+  if(solver->buffer) {
+    free(solver->buffer);
+    solver->buffer = NULL;
+  }
+  if(solver->processes) {
+    free(solver->processes);
+    solver->processes = NULL;
+  }
 }
 
 void
 miniexact_sat_solver_add(miniexact_sat_solver* solver, int l) {
   assert(solver);
-  assert(solver->infd_handle);
-  miniexact_trc("[SAT] Lit: %d", l);
+  assert(solver->buffer);
   if(l == 0) {
-    fprintf(solver->infd_handle, "0\n");
+    reserve(solver, 2);
+    solver->buffer[solver->buffer_len++] = '0';
+    solver->buffer[solver->buffer_len++] = '\n';
+    if(solver->one_pass)
+      ++solver->clauses;
   } else {
-    fprintf(solver->infd_handle, "%d ", l);
+    put_lit(solver, l, ' ');
   }
 }
 
 void
 miniexact_sat_solver_unit(miniexact_sat_solver* solver, int l) {
-  assert(solver);
-  assert(solver->infd_handle);
-  miniexact_trc("[SAT] %d 0", l);
-  fprintf(solver->infd_handle, "%d 0\n", l);
+  miniexact_sat_solver_add(solver, l);
+  miniexact_sat_solver_add(solver, 0);
 }
 void
 miniexact_sat_solver_binary(miniexact_sat_solver* solver, int a, int b) {
-  assert(solver);
-  assert(solver->infd_handle);
-  miniexact_trc("[SAT] %d %d 0", a, b);
-  fprintf(solver->infd_handle, "%d %d 0\n", a, b);
+  miniexact_sat_solver_add(solver, a);
+  miniexact_sat_solver_add(solver, b);
+  miniexact_sat_solver_add(solver, 0);
 }
 void
 miniexact_sat_solver_ternary(miniexact_sat_solver* solver,
                              int a,
                              int b,
                              int c) {
-  assert(solver);
-  assert(solver->infd_handle);
-  miniexact_trc("[SAT] %d %d %d 0", a, b, c);
-  fprintf(solver->infd_handle, "%d %d %d 0\n", a, b, c);
+  miniexact_sat_solver_add(solver, a);
+  miniexact_sat_solver_add(solver, b);
+  miniexact_sat_solver_add(solver, c);
+  miniexact_sat_solver_add(solver, 0);
 }
 
+// Parses the "v" lines of the output of a solver. Their literals may span any
+// number of lines. Variables not listed stay false.
 static void
-parse_solver_output(miniexact_sat_solver* solver) {
+parse_solver_output(miniexact_sat_solver* solver,
+                    const char* buf,
+                    size_t len) {
   assert(solver);
   assert(solver->assignments);
-  char stack_buf[BUF_SIZE];
-  char* buf = stack_buf;
-  size_t buf_size = BUF_SIZE;
-  size_t len;
-  while((len = getline(&buf, &buf_size, solver->outfd_handle)) != -1) {
-    if(len > 0 && (buf[0] == 'c' || buf[0] == 'r')) {
-      continue;// Comment line or result line
+  memset(solver->assignments, 0, solver->variables + 1);
+
+  bool line_start = true, values = false, negative = false, digits = false;
+  unsigned int v = 0;
+  for(size_t i = 0; i < len; ++i) {
+    char c = buf[i];
+    if(line_start) {
+      line_start = false;
+      values = c == 'v';
+      if(values)
+        continue;
     }
-    if(len > 0 && (buf[0] == 'v')) {
-      char* numbers = buf + 2;
-      int ret = 0;
-      do {
-        int v = 0;
-        int pos;
-        ret = sscanf(numbers, "%d%n", &v, &pos);
-        numbers += pos + 1;
-        if(v == 0)
-          break;
-
-        uint32_t v_ = abs(v);
-
-        assert(v_ < solver->variables + 1);
-        solver->assignments[v_] = miniexact_sign(v);
-
-        if(v_ == solver->variables)
-          return;
-      } while(ret == 1);
+    if(!values) {
+      line_start = c == '\n';
+    } else if(c >= '0' && c <= '9') {
+      v = v * 10 + (c - '0');
+      digits = true;
+    } else if(c == '-') {
+      negative = true;
+    } else {
+      if(digits && v <= solver->variables)
+        solver->assignments[v] = !negative;
+      v = 0;
+      negative = false;
+      digits = false;
+      line_start = c == '\n';
     }
   }
+  if(digits && v <= solver->variables)
+    solver->assignments[v] = !negative;
+}
+
+// Appends what the solver printed to its output. Returns false once the solver
+// closed its output.
+static bool
+read_output(miniexact_sat_solver_process* process) {
+  if(process->output_size - process->output_len < BUF_SIZE) {
+    process->output_size = process->output_size * 2 + BUF_SIZE;
+    process->output = realloc(process->output, process->output_size);
+  }
+  ssize_t len;
+  do {
+    len = read(process->out,
+               process->output + process->output_len,
+               process->output_size - process->output_len);
+  } while(len < 0 && errno == EINTR);
+  if(len <= 0)
+    return false;
+  process->output_len += len;
+  return true;
+}
+
+static int
+wait_for_exit_code(pid_t pid) {
+  int status;
+  while(waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  if(WIFEXITED(status))
+    return WEXITSTATUS(status);
+  return -1;
 }
 
 int
 miniexact_sat_solver_solve(miniexact_sat_solver* solver) {
-  fclose(solver->infd_handle);
-  solver->infd_handle = NULL;
-  close(solver->infd[1]);
-
-  // Wait for pid to finish.
+  if(solver->one_pass) {
+    char header[64];
+    int len = snprintf(header,
+                       sizeof(header),
+                       "p cnf %u %u\n",
+                       solver->variables,
+                       solver->clauses);
+    for(size_t i = 0; i < solver->processes_count; ++i)
+      write_all(&solver->processes[i], header, len);
+  }
+  miniexact_trc("[SAT] p cnf %u %u", solver->variables, solver->clauses);
+  flush(solver);
+
+  double start_time = miniexact_seconds();
+  size_t count = solver->processes_count;
+  struct pollfd fds[count];
+  for(size_t i = 0; i < count; ++i) {
+    miniexact_sat_solver_process* process = &solver->processes[i];
+    if(process->in >= 0)
+      close(process->in);
+    fds[i].fd = process->out;
+    fds[i].events = POLLIN;
+  }
 
-  int status;
-  waitpid(solver->pid, &status, 0);
-
-  if(WIFEXITED(status)) {
-    int exit_code = WEXITSTATUS(status);
-    switch(exit_code) {
-      case 10:
-        parse_solver_output(solver);
-        fclose(solver->outfd_handle);
-        return 10;
-      case 20:
-        fclose(solver->outfd_handle);
-        return 20;
-      default:
+  // The outputs have to be read while waiting, otherwise a model larger than
+  // the pipe blocks the solver forever.
+  int result = 0;
+  size_t running = count;
+  miniexact_sat_solver_process* winner = NULL;
+  while(running > 0 && !winner) {
+    if(poll(fds, count, -1) < 0) {
+      if(errno == EINTR)
+        continue;
+      break;
+    }
+    for(size_t i = 0; i < count && !winner; ++i) {
+      miniexact_sat_solver_process* process = &solver->processes[i];
+      if(fds[i].fd < 0 || !fds[i].revents || read_output(process))
+        continue;
+
+      close(process->out);
+      fds[i].fd = -1;
+      --running;
+
+      int exit_code = wait_for_exit_code(process->pid);
+      if(exit_code == 10 || exit_code == 20) {
+        winner = process;
+        result = exit_code;
+      } else if(exit_code >= 0) {
         miniexact_err("Child SAT solver process had unexpected exit code %d!",
                       exit_code);
-        fclose(solver->outfd_handle);
-        return exit_code;
+        result = exit_code;
+      } else {
+        miniexact_err("Child SAT solver process had unexpected exit!");
+      }
+    }
+  }
+
+  // The first answer is enough, the other solvers are stopped.
+  for(size_t i = 0; i < count; ++i) {
+    miniexact_sat_solver_process* process = &solver->processes[i];
+    if(fds[i].fd >= 0) {
+      kill(process->pid, SIGKILL);
+      close(process->out);
+      wait_for_exit_code(process->pid);
     }
-  } else {
-    miniexact_err("Child SAT solver process had unexpected exit!");
   }
-  return 0;
+
+  if(winner) {
+    if(winner->portfolio_id != NO_PORTFOLIO) {
+      ++portfolio[winner->portfolio_id].wins;
+      portfolio[winner->portfolio_id].win_time +=
+        miniexact_seconds() - start_time;
+    }
+    if(result == 10) {
+      solver->assignments =
+        realloc(solver->assignments, sizeof(char) * (solver->variables + 1));
+      parse_solver_output(solver, winner->output, winner->output_len);
+    }
+  }
+
+  for(size_t i = 0; i < count; ++i)
+    free(solver->processes[i].output);
+  solver->processes_count = 0;
+
+  return result;
 }
@@ -7,6 +7,7 @@
 #include <miniexact/algorithm_c.h>
 #include <miniexact/algorithm_m.h>
 #include <miniexact/algorithm_x.h>
+#include <miniexact/cancel.h>
 #include <miniexact/miniexact.h>
 #include <miniexact/simple.h>
 #include <miniexact/util.h>
@@ -18,6 +19,7 @@ enum state {
   S_READY = 1u << 3u,
   S_SOLUTIONS_AVAILABLE = 1u << 4u,
   S_DONE = 1u << 5u,
+  S_CANCELLED = 1u << 6u,
 };
 
 struct miniexacts {
@@ -27,12 +29,17 @@ struct miniexacts {
 
   const char** names;
   const char** colors;
+
+  miniexact_cancel* cancel;
+  miniexacts_progress_callback progress;
+  void* progress_userdata;
 };
 
 static struct miniexacts*
 alloc_handle() {
   struct miniexacts* h = calloc(1, sizeof(struct miniexacts));
   h->s = S_ADD_PRIMARY_ITEMS;
+  h->cancel = miniexact_cancel_new();
   return h;
 }
 
@@ -41,6 +48,7 @@ miniexacts_init_x() {
   struct miniexacts* h = alloc_handle();
   miniexact_algorithm_x_set(&h->a);
   miniexact_default_init_problem(&h->a, &h->p);
+  h->p.cancel = h->cancel;
   return h;
 }
 
@@ -49,6 +57,7 @@ miniexacts_init_c() {
   struct miniexacts* h = alloc_handle();
   miniexact_algorithm_c_set(&h->a);
   miniexact_default_init_problem(&h->a, &h->p);
+  h->p.cancel = h->cancel;
   return h;
 }
 
@@ -57,6 +66,7 @@ miniexacts_init_m() {
   struct miniexacts* h = alloc_handle();
   miniexact_algorithm_m_set(&h->a);
   miniexact_default_init_problem(&h->a, &h->p);
+  h->p.cancel = h->cancel;
   return h;
 }
 
@@ -212,17 +222,131 @@ miniexacts_add(struct miniexacts* h,
 
 int
 miniexacts_solve(struct miniexacts* h) {
-  TRY(require_state(h, S_READY | S_SOLUTIONS_AVAILABLE));
+  TRY(require_state(h, S_READY | S_SOLUTIONS_AVAILABLE | S_CANCELLED));
+
+  // Options can no longer be added once solving started.
+  if(h->s == S_READY)
+    TRY(h->a.end_options(&h->a, &h->p));
+
+  // The cancelled search backtracked to the root, start it again.
+  if(h->s == S_CANCELLED) {
+    miniexact_cancel_reset(h->cancel);
+    h->p.state = 0;
+  }
 
   int r = miniexact_solve_problem(&h->a, &h->p);
   if(r == 10) {
     h->s = S_SOLUTIONS_AVAILABLE;
+  } else if(r == MINIEXACT_CANCELLED) {
+    h->s = S_CANCELLED;
   } else {
     h->s = S_DONE;
   }
   return r;
 }
 
+#define DEFAULT_BATCH_SIZE 1024
+
+int
+miniexacts_enumerate(struct miniexacts* h,
+                     miniexacts_solutions_callback it,
+                     unsigned int batch_size,
+                     void* userdata,
+                     long long* reported_count) {
+  assert(h);
+  assert(it);
+  TRY(require_state(
+    h, S_READY | S_SOLUTIONS_AVAILABLE | S_CANCELLED | S_DONE));
+  if(reported_count)
+    *reported_count = 0;
+  if(h->s == S_DONE)
+    return 20;
+
+  if(h->s == S_READY)
+    TRY(h->a.end_options(&h->a, &h->p));
+  if(h->s == S_CANCELLED) {
+    miniexact_cancel_reset(h->cancel);
+    h->p.state = 0;
+  }
+  if(batch_size == 0)
+    batch_size = DEFAULT_BATCH_SIZE;
+
+  // Without multiplicities, every solution has at most one option per primary
+  // item. Longer ones grow the buffer.
+  size_t longest = h->p.primary_item_count + 1;
+  size_t options_capacity = batch_size * longest;
+  int32_t* options = malloc(options_capacity * sizeof(int32_t));
+  uint32_t* offsets = malloc((batch_size + 1) * sizeof(uint32_t));
+  offsets[0] = 0;
+
+  long long reported = 0;
+  unsigned int count = 0;
+  bool stopped = false;
+  int r;
+  while((r = miniexact_solve_problem(&h->a, &h->p)) == 10) {
+    if(offsets[count] + (size_t)h->p.l > options_capacity) {
+      options_capacity = 2 * options_capacity + h->p.l;
+      options = realloc(options, options_capacity * sizeof(int32_t));
+    }
+    offsets[count + 1] = offsets[count] +
+      miniexact_extract_solution_option_indices(&h->p, options + offsets[count]);
+    if(++count == batch_size) {
+      reported += count;
+      count = 0;
+      if(!it(h, options, offsets, batch_size, userdata)) {
+        stopped = true;
+        break;
+      }
+    }
+  }
+  if(count) {
+    reported += count;
+    it(h, options, offsets, count, userdata);
+  }
+
+  free(options);
+  free(offsets);
+
+  if(reported_count)
+    *reported_count = reported;
+  if(stopped) {
+    h->s = S_SOLUTIONS_AVAILABLE;
+    return 10;
+  } else if(r == MINIEXACT_CANCELLED) {
+    h->s = S_CANCELLED;
+    return MINIEXACT_CANCELLED;
+  }
+  h->s = S_DONE;
+  return 20;
+}
+
+void
+miniexacts_cancel(struct miniexacts* h) {
+  assert(h);
+  miniexact_cancel_request(h->cancel);
+}
+
+static bool
+progress_converter(struct miniexact_problem* p,
+                   uint64_t nodes,
+                   void* userdata) {
+  (void)p;
+  struct miniexacts* h = userdata;
+  return h->progress(h, nodes, h->progress_userdata) != 0;
+}
+
+void
+miniexacts_set_progress(struct miniexacts* h,
+                        miniexacts_progress_callback progress,
+                        unsigned int interval,
+                        void* userdata) {
+  assert(h);
+  h->progress = progress;
+  h->progress_userdata = userdata;
+  miniexact_cancel_set_progress(
+    h->cancel, progress ? &progress_converter : NULL, interval, h);
+}
+
 struct userdata_bag {
   struct miniexacts* h;
   miniexacts_solution_iterator it;
@@ -268,10 +392,17 @@ miniexacts_problem(struct miniexacts* h) {
   return &h->p;
 }
 
+const struct miniexact_stats*
+miniexacts_stats(struct miniexacts* h) {
+  assert(h);
+  return &h->p.stats;
+}
+
 void
 miniexacts_free(struct miniexacts* h) {
   if(h) {
     miniexact_problem_free_inner(&h->p, &h->a);
+    miniexact_cancel_free(h->cancel);
     free(h);
   }
 }
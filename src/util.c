@@ -1,27 +1,235 @@
+#include <errno.h>
+#include <inttypes.h>
 #include <string.h>
+#include <time.h>
 
 #include <miniexact/algorithm.h>
+#include <miniexact/algorithm_z.h>
+#include <miniexact/budget.h>
+#include <miniexact/cancel.h>
+#include <miniexact/checkpoint.h>
+#include <miniexact/components.h>
+#include <miniexact/estimate.h>
 #include <miniexact/log.h>
 #include <miniexact/miniexact.h>
 #include <miniexact/ops.h>
+#include <miniexact/parallel.h>
 #include <miniexact/parse.h>
+#include <miniexact/profile.h>
 #include <miniexact/util.h>
 
-int
-miniexact_solve_problem_and_print_solutions(struct miniexact_algorithm* a,
-                                            struct miniexact_problem* p,
-                                            struct miniexact_config* cfg) {
+// With Algorithm M, a solution may only consist of branches that take no
+// option of an item. Such empty solutions are neither printed nor counted.
+static bool
+has_options(struct miniexact_problem* p) {
+  for(miniexact_link j = 0; j < p->l; ++j)
+    if(p->x[j] > p->N && p->x[j] <= p->Z)
+      return true;
+  return false;
+}
+
+bool
+miniexact_print_solution(struct miniexact_problem* p,
+                         struct miniexact_config* cfg) {
+  bool printed = false;
+
+  if(!has_options(p))
+    return false;
+
+  if(cfg->print_options) {
+    printed = true;
+    for(miniexact_link o = 0; o < p->l; ++o) {
+      miniexact_link o_ = p->x[o];
+
+      // Go back to beginning of option
+      while(TOP(o_ - 1) > 0)
+        --o_;
+
+      // This makes printing prettier. With algorithm M, options may be
+      // empty, as branches are taken to resolve multiplicities. These are
+      // expressed in the solution array, but don't directly correspond to
+      // selected options.
+      if(o_ > p->N && o_ <= p->Z) {
+        while(TOP(o_) > 0) {
+          if(NAME(TOP(o_)))
+            printf("%s", NAME(TOP(o_)));
+          else
+            printf("%d", TOP(o_));
+          if(o_ < MINIEXACT_NODES_SIZE(p) && COLOR(o_) > 0) {
+            if(COLOR(o_) < p->color_name_size && p->color_name[COLOR(o_)])
+              printf(":%s", p->color_name[COLOR(o_)]);
+            else
+              printf(":%d", COLOR(o_));
+          }
+          ++o_;
+
+          if(TOP(o_) > 0)
+            printf(" ");
+        }
+        printf(";\n");
+      }
+    }
+  } else if(cfg->print_x) {
+    printed = true;
+    for(size_t i = 0; i < p->l; ++i) {
+      printf("%d ", p->x[i]);
+    }
+    printf("\n");
+  } else {
+    miniexact_link solution[p->l];
+    miniexact_link l = miniexact_extract_solution_option_indices(p, solution);
+    if(l > 0) {
+      for(size_t i = 0; i < l; ++i) {
+        printf("%d ", solution[i]);
+      }
+      printf("\n");
+      printed = true;
+    }
+  }
+
+  return printed;
+}
+
+double
+miniexact_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// compute_next_result, adding the time spent to the stats of p.
+static bool
+next_result(struct miniexact_algorithm* a, struct miniexact_problem* p) {
+  double start = miniexact_seconds();
+  bool has_result = a->compute_next_result(a, p);
+  // A resumed search first finds the solution it was suspended at again.
+  if(has_result && p->checkpoint &&
+     !miniexact_checkpoint_solution(p->checkpoint))
+    has_result = a->compute_next_result(a, p);
+  p->stats.solve_time += miniexact_seconds() - start;
+  return has_result;
+}
+
+void
+miniexact_print_stats(struct miniexact_problem* p, FILE* f) {
+  fprintf(f, "Parse time: %.3fs\n", p->stats.parse_time);
+  fprintf(f, "Solve time: %.3fs\n", p->stats.solve_time);
+#ifdef MINIEXACT_STATS
+  fprintf(f, "Nodes: %" PRIu64 "\n", p->stats.nodes);
+  fprintf(f, "Updates: %" PRIu64 "\n", p->stats.updates);
+  fprintf(f, "Mems: %" PRIu64 "\n", p->stats.mems);
+  fprintf(f, "Choose scans: %" PRIu64 "\n", p->stats.choose_scans);
+#else
+  fprintf(f, "Counters are not available, build with MINIEXACT_STATS.\n");
+#endif
+}
+
+static bool
+uses_algorithm_z(struct miniexact_config* cfg) {
+  return cfg->algorithm_select & MINIEXACT_ALGORITHM_Z;
+}
+
+// Prints the exact number of solutions held in the ZDD of Algorithm Z and
+// writes the ZDD if requested. Returns false if there is no ZDD.
+static bool
+print_zdd_count(struct miniexact_problem* p, struct miniexact_config* cfg) {
+  char* count = miniexact_algorithm_z_count(p);
+  if(!count)
+    return false;
+  printf("Found %s solutions!\n", count);
+  free(count);
+
+  if(cfg->write_zdd) {
+    const char* error = miniexact_algorithm_z_write(p, cfg->write_zdd);
+    if(error) {
+      miniexact_err("Could not write %s: %s", cfg->write_zdd, error);
+      return false;
+    }
+  }
+  return true;
+}
+
+// The decomposition uses the operations of Algorithm C, also fine for X.
+static bool
+uses_components(struct miniexact_config* cfg) {
+  return cfg->components && !uses_algorithm_z(cfg) &&
+         (cfg->algorithm_select &
+          (MINIEXACT_ALGORITHM_X | MINIEXACT_ALGORITHM_C));
+}
+
+static int
+count_solutions(struct miniexact_algorithm* a,
+                struct miniexact_problem* p,
+                struct miniexact_config* cfg) {
+  if(uses_components(cfg)) {
+    uint64_t nr_of_solutions;
+    double start = miniexact_seconds();
+    const char* error =
+      miniexact_components_count_solutions(p, &nr_of_solutions);
+    p->stats.solve_time += miniexact_seconds() - start;
+    if(error) {
+      miniexact_err("%s", error);
+      return EXIT_FAILURE;
+    }
+    printf("Found %" PRIu64 " solutions!\n", nr_of_solutions);
+    return nr_of_solutions ? 10 : 20;
+  }
+
+  bool has_solution = next_result(a, p);
+
+  // Algorithm Z counts on the ZDD instead of visiting every solution.
+  if(uses_algorithm_z(cfg)) {
+    if(!print_zdd_count(p, cfg))
+      return EXIT_FAILURE;
+    return has_solution ? 10 : 20;
+  }
+
+  long long nr_of_solutions = p->checkpoint ? p->checkpoint->solutions : 0;
+  while(has_solution) {
+    if(has_options(p))
+      ++nr_of_solutions;
+    if(p->checkpoint)
+      p->checkpoint->solutions = nr_of_solutions;
+    if(p->budget && !miniexact_budget_solution(p->budget))
+      break;
+    has_solution = next_result(a, p);
+  }
+  printf("Found %lld solutions!\n", nr_of_solutions);
+  return nr_of_solutions ? 10 : 20;
+}
+
+static int
+solve_and_print(struct miniexact_algorithm* a,
+                struct miniexact_problem* p,
+                struct miniexact_config* cfg) {
   int return_code = EXIT_SUCCESS;
-  if(!a->compute_next_result) {
-    miniexact_err("Algorithm does not support solving!");
-    return EXIT_FAILURE;
+
+  if(uses_components(cfg) && cfg->verbose)
+    printf("Active items split into %d independent components.\n",
+           miniexact_components_count(p));
+
+  if(cfg->count)
+    return count_solutions(a, p, cfg);
+
+  if(uses_components(cfg) && !cfg->enumerate) {
+    double start = miniexact_seconds();
+    return_code = miniexact_components_solve(p);
+    p->stats.solve_time += miniexact_seconds() - start;
+    if(return_code == 10)
+      miniexact_print_solution(p, cfg);
+    return return_code;
   }
 
+#ifdef MINIEXACT_THREADS_AVAILABLE
+  if(cfg->threads > 1 && cfg->enumerate && !uses_algorithm_z(cfg))
+    return miniexact_parallel_solve_and_print_solutions(a, p, cfg);
+#endif
+
   int solution = 0;
-  int nr_of_solutions = 0;
+  int nr_of_solutions = p->checkpoint ? p->checkpoint->solutions : 0;
 
   do {
-    bool has_solution = a->compute_next_result(a, p);
+    bool has_solution = next_result(a, p);
     if(!has_solution) {
       return_code = 20;
       break;
@@ -29,57 +237,10 @@ miniexact_solve_problem_and_print_solutions(struct miniexact_algorithm* a,
       ++solution;
       return_code = 10;
 
-      if(cfg->print_options) {
-        ++nr_of_solutions;
-        for(miniexact_link o = 0; o < p->l; ++o) {
-          miniexact_link o_ = p->x[o];
-
-          // Go back to beginning of option
-          while(TOP(o_ - 1) > 0)
-            --o_;
-
-          // This makes printing prettier. With algorithm M, options may be
-          // empty, as branches are taken to resolve multiplicities. These are
-          // expressed in the solution array, but don't directly correspond to
-          // selected options.
-          if(o_ > p->N && o_ <= p->Z) {
-            while(TOP(o_) > 0) {
-              if(NAME(TOP(o_)))
-                printf("%s", NAME(TOP(o_)));
-              else
-                printf("%d", TOP(o_));
-              if(o_ < p->color_size && COLOR(o_) > 0) {
-                if(COLOR(o_) < p->color_name_size && p->color_name[COLOR(o_)])
-                  printf(":%s", p->color_name[COLOR(o_)]);
-                else
-                  printf(":%d", COLOR(o_));
-              }
-              ++o_;
-
-              if(TOP(o_) > 0)
-                printf(" ");
-            }
-            printf(";\n");
-          }
-        }
-      } else if(cfg->print_x) {
+      if(miniexact_print_solution(p, cfg))
         ++nr_of_solutions;
-        for(size_t i = 0; i < p->l; ++i) {
-          printf("%d ", p->x[i]);
-        }
-        printf("\n");
-      } else {
-        miniexact_link solution[p->l];
-        miniexact_link l =
-          miniexact_extract_solution_option_indices(p, solution);
-        if(l > 0) {
-          for(size_t i = 0; i < l; ++i) {
-            printf("%d ", solution[i]);
-          }
-          printf("\n");
-          ++nr_of_solutions;
-        }
-      }
+      if(p->checkpoint)
+        p->checkpoint->solutions = nr_of_solutions;
     }
     if(cfg->enumerate)
       printf("\n");
@@ -88,23 +249,116 @@ miniexact_solve_problem_and_print_solutions(struct miniexact_algorithm* a,
       miniexact_print_problem_matrix(p);
       printf("\n");
     }
-  } while(cfg->enumerate);
+  } while(cfg->enumerate &&
+          (!p->budget || miniexact_budget_solution(p->budget)));
 
-  if(cfg->enumerate) {
+  if(uses_algorithm_z(cfg)) {
+    if(cfg->enumerate || cfg->write_zdd)
+      if(!print_zdd_count(p, cfg))
+        return EXIT_FAILURE;
+  } else if(cfg->enumerate) {
     printf("Found %d solutions!\n", nr_of_solutions);
   }
 
   return return_code;
 }
 
+static int
+solve_and_profile(struct miniexact_algorithm* a,
+                  struct miniexact_problem* p,
+                  struct miniexact_config* cfg) {
+  if(!cfg->profile && !cfg->profile_csv)
+    return solve_and_print(a, p, cfg);
+
+  miniexact_profile profile;
+  miniexact_profile_init(&profile, p);
+  int return_code = solve_and_print(a, p, cfg);
+
+  fflush(stdout);
+  if(cfg->profile)
+    miniexact_profile_print(&profile, stderr);
+  if(cfg->profile_csv) {
+    FILE* f = fopen(cfg->profile_csv, "w");
+    if(f) {
+      miniexact_profile_print_csv(&profile, f);
+      fclose(f);
+    } else {
+      miniexact_err("Could not write %s, error: %s",
+                    cfg->profile_csv,
+                    strerror(errno));
+      return_code = EXIT_FAILURE;
+    }
+  }
+  miniexact_profile_finish(&profile, p);
+  return return_code;
+}
+
+static int
+solve_and_checkpoint(struct miniexact_algorithm* a,
+                     struct miniexact_problem* p,
+                     struct miniexact_config* cfg) {
+  if(!cfg->checkpoint)
+    return solve_and_profile(a, p, cfg);
+
+  miniexact_checkpoint checkpoint;
+  const char* error = miniexact_checkpoint_init(&checkpoint, p, cfg);
+  if(error) {
+    miniexact_err("Could not resume from %s: %s", cfg->checkpoint, error);
+    return EXIT_FAILURE;
+  }
+  int return_code = solve_and_profile(a, p, cfg);
+
+  // A search stopped by its budget is continued when resumed. After the
+  // solution limit, it continues behind the last solution.
+  if(p->budget && p->budget->exhausted) {
+    checkpoint.skip_solution =
+      p->budget->exhausted == MINIEXACT_BUDGET_SOLUTIONS;
+    miniexact_checkpoint_suspend(&checkpoint, p);
+  } else {
+    miniexact_checkpoint_finish(&checkpoint, p);
+  }
+  return return_code;
+}
+
+int
+miniexact_solve_problem_and_print_solutions(struct miniexact_algorithm* a,
+                                            struct miniexact_problem* p,
+                                            struct miniexact_config* cfg) {
+  if(!a->compute_next_result) {
+    miniexact_err("Algorithm does not support solving!");
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->estimate)
+    return miniexact_estimate_and_print(a, p, cfg);
+
+  if(!miniexact_budget_configured(cfg))
+    return solve_and_checkpoint(a, p, cfg);
+
+  miniexact_budget budget;
+  miniexact_budget_init(&budget, p, cfg);
+  int return_code = solve_and_checkpoint(a, p, cfg);
+  if(budget.exhausted) {
+    fflush(stdout);
+    miniexact_budget_print(&budget, stderr);
+    return_code = MINIEXACT_BUDGET_EXHAUSTED;
+  }
+  miniexact_budget_finish(&budget, p);
+  return return_code;
+}
+
 int
 miniexact_solve_problem(struct miniexact_algorithm* a,
                         struct miniexact_problem* p) {
   assert(a);
   assert(p);
-  bool has_result = a->compute_next_result(a, p);
+  bool has_result = next_result(a, p);
   if(has_result)
     return 10;
+  else if(p->cancel && miniexact_cancel_stopped(p->cancel))
+    return MINIEXACT_CANCELLED;
+  else if(p->budget && p->budget->exhausted)
+    return MINIEXACT_BUDGET_EXHAUSTED;
   else
     return 20;
 }
@@ -136,7 +390,7 @@ miniexact_iterate_solution_options_str(struct miniexact_problem* p,
     if(o_ > p->N && o_ <= p->Z) {
       while(TOP(o_) > 0) {
         names[i] = NAME(TOP(o_));
-        if(TOP(o_) < p->color_size && COLOR(TOP(o_)) > 0) {
+        if(TOP(o_) < MINIEXACT_NODES_SIZE(p) && COLOR(TOP(o_)) > 0) {
           colors[i] = p->color_name[COLOR(TOP(o_))];
         } else {
           colors[i] = NULL;
@@ -11,6 +11,7 @@
 
 %template(vectorstr) std::vector<char*>;
 %template(vectori) std::vector<int32_t>;
+%template(vectorvectori) std::vector<std::vector<int32_t>>;
 
 %include <miniexact/miniexact.h>
 %include <miniexact/simple.h>
@@ -0,0 +1,138 @@
+// A minimal IPASIR solver for the tests. It keeps all clauses, solves them by
+// backtracking with unit propagation and counts how it is called, so that
+// tests can check that a problem is encoded once and only blocking clauses
+// follow.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct mock_solver {
+  int32_t* lits;
+  size_t lits_size;
+  size_t lits_capacity;
+  int32_t variables;
+  signed char* values;
+} mock_solver;
+
+static int solves = 0;
+static int clauses = 0;
+
+int
+mock_ipasir_solves(void) {
+  return solves;
+}
+
+int
+mock_ipasir_clauses(void) {
+  return clauses;
+}
+
+const char*
+ipasir_signature(void) {
+  return "mock";
+}
+
+void*
+ipasir_init(void) {
+  solves = 0;
+  clauses = 0;
+  return calloc(1, sizeof(mock_solver));
+}
+
+void
+ipasir_release(void* solver) {
+  mock_solver* s = solver;
+  free(s->lits);
+  free(s->values);
+  free(s);
+}
+
+void
+ipasir_add(void* solver, int32_t lit) {
+  mock_solver* s = solver;
+  if(s->lits_size == s->lits_capacity) {
+    s->lits_capacity = s->lits_capacity ? s->lits_capacity * 2 : 64;
+    s->lits = realloc(s->lits, s->lits_capacity * sizeof(int32_t));
+  }
+  s->lits[s->lits_size++] = lit;
+  if(lit == 0)
+    ++clauses;
+  else if(abs(lit) > s->variables)
+    s->variables = abs(lit);
+}
+
+// Assigns the last open literal of every clause whose other literals are
+// false, until nothing changes. Assigned variables are pushed onto trail.
+// Returns false on a conflict.
+static int
+propagate(mock_solver* s, int32_t* trail, size_t* trail_size) {
+  int changed = 1;
+  while(changed) {
+    changed = 0;
+    size_t i = 0;
+    while(i < s->lits_size) {
+      int satisfied = 0, open = 0;
+      int32_t unit = 0;
+      for(; s->lits[i]; ++i) {
+        int32_t lit = s->lits[i];
+        int v = s->values[abs(lit)];
+        if(v == 0) {
+          ++open;
+          unit = lit;
+        } else if((lit > 0) == (v > 0)) {
+          satisfied = 1;
+        }
+      }
+      ++i;
+      if(satisfied || open > 1)
+        continue;
+      if(open == 0)
+        return 0;
+      s->values[abs(unit)] = unit > 0 ? 1 : -1;
+      trail[(*trail_size)++] = abs(unit);
+      changed = 1;
+    }
+  }
+  return 1;
+}
+
+// Backtracking with unit propagation, trying false first.
+static int
+search(mock_solver* s, int32_t* trail, size_t trail_size) {
+  size_t start = trail_size;
+  if(propagate(s, trail, &trail_size)) {
+    int32_t var = 1;
+    while(var <= s->variables && s->values[var])
+      ++var;
+    if(var > s->variables)
+      return 1;
+    for(int v = -1; v <= 1; v += 2) {
+      s->values[var] = v;
+      trail[trail_size] = var;
+      if(search(s, trail, trail_size + 1))
+        return 1;
+    }
+    s->values[var] = 0;
+  }
+  while(trail_size > start)
+    s->values[trail[--trail_size]] = 0;
+  return 0;
+}
+
+int
+ipasir_solve(void* solver) {
+  mock_solver* s = solver;
+  ++solves;
+  free(s->values);
+  s->values = calloc(s->variables + 1, 1);
+  int32_t* trail = malloc((s->variables + 1) * sizeof(int32_t));
+  int result = search(s, trail, 0) ? 10 : 20;
+  free(trail);
+  return result;
+}
+
+int32_t
+ipasir_val(void* solver, int32_t lit) {
+  mock_solver* s = solver;
+  return s->values[abs(lit)] > 0 ? lit : -lit;
+}
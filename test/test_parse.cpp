@@ -1,3 +1,6 @@
+#include <cstdlib>
+#include <string>
+
 #include <catch2/catch_test_macros.hpp>
 
 #include <miniexact/algorithm.h>
@@ -175,3 +178,128 @@ TEST_CASE("parse standard colored XCC example") {
   //   miniexact_problem_free(p);
   // }
 }
+
+TEST_CASE("look up many item and color names") {
+  std::string str = "<";
+  for(int i = 0; i < 1000; ++i)
+    str += " p" + std::to_string(i);
+  str += " > [";
+  for(int i = 0; i < 1000; ++i)
+    str += " s" + std::to_string(i);
+  str += " ]";
+  for(int i = 0; i < 1000; ++i)
+    str += " p" + std::to_string(i) + " s" + std::to_string(i) + ":c" +
+           std::to_string(i % 300) + ";";
+
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_c_set(&algorithm);
+
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+  REQUIRE(p);
+
+  REQUIRE(p->primary_item_count == 1000);
+  REQUIRE(p->secondary_item_count == 1000);
+  REQUIRE(miniexact_item_from_ident(p.get(), "p0") == 1);
+  REQUIRE(miniexact_item_from_ident(p.get(), "p999") == 1000);
+  REQUIRE(miniexact_item_from_ident(p.get(), "s0") == 1001);
+  REQUIRE(miniexact_item_from_ident(p.get(), "s999") == 2000);
+  REQUIRE(miniexact_item_from_ident(p.get(), "p1000") == -1);
+  REQUIRE(miniexact_color_from_ident(p.get(), "c0") == 1);
+  REQUIRE(miniexact_color_from_ident(p.get(), "c299") == 300);
+  REQUIRE(miniexact_color_from_ident(p.get(), "c300") == -1);
+}
+
+TEST_CASE("reject identifiers that do not fit into the parser") {
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_x_set(&algorithm);
+
+  std::string longest(4095, 'a');
+  std::string str = "<" + longest + "> " + longest + ";";
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+  REQUIRE(p);
+  REQUIRE(p->primary_item_count == 1);
+  REQUIRE(miniexact_item_from_ident(p.get(), longest.c_str()) == 1);
+
+  std::string too_long = longest + "ab";
+  str = "<" + too_long + "> " + too_long + ";";
+  REQUIRE(!miniexact_parse_problem(&algorithm, str.c_str()));
+
+  str = "<" + longest + "b " + longest + "c> " + longest + "b;";
+  REQUIRE(!miniexact_parse_problem(&algorithm, str.c_str()));
+}
+
+namespace {
+struct counting_pool {
+  size_t live = 0;
+  size_t total = 0;
+};
+
+void*
+counting_malloc(size_t size, void* userdata) {
+  auto pool = static_cast<counting_pool*>(userdata);
+  ++pool->live;
+  ++pool->total;
+  return malloc(size);
+}
+
+void*
+counting_realloc(void* ptr, size_t size, void* userdata) {
+  auto pool = static_cast<counting_pool*>(userdata);
+  if(!ptr) {
+    ++pool->live;
+    ++pool->total;
+  }
+  return realloc(ptr, size);
+}
+
+void
+counting_free(void* ptr, void* userdata) {
+  auto pool = static_cast<counting_pool*>(userdata);
+  if(ptr)
+    --pool->live;
+  free(ptr);
+}
+}
+
+TEST_CASE("parse into a compacted arena through a custom allocator") {
+  const char* str = "<a b c d e f g> c e; a d g; b c f; a d f; b g; d e g;";
+
+  counting_pool pool;
+  miniexact_allocator allocator
+    = { &counting_malloc, &counting_realloc, &counting_free, &pool };
+  miniexact_set_allocator(&allocator);
+
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_x_set(&algorithm);
+
+  {
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+    REQUIRE(p);
+    REQUIRE(pool.total > 0);
+
+    // Matrix and names are right-sized and live in the arena.
+    REQUIRE(p->arena);
+    auto in_arena = [&](const void* ptr) {
+      auto c = static_cast<const char*>(ptr);
+      auto a = static_cast<const char*>(p->arena);
+      return c >= a && c < a + p->arena_size;
+    };
+    REQUIRE(in_arena(p->llink));
+    REQUIRE(in_arena(p->name));
+    REQUIRE(in_arena(p->name[1]));
+    REQUIRE(p->llink_capacity == p->llink_size);
+    REQUIRE(p->cost_capacity == p->cost_size);
+
+    REQUIRE(miniexact_item_from_ident(p.get(), "g") == 7);
+    REQUIRE(algorithm.compute_next_result(&algorithm, p.get()));
+    REQUIRE(p->l == 3);
+
+    // Growing an array in the arena moves it out again.
+    miniexact_link color = miniexact_color_from_ident_or_insert(p.get(), "red");
+    REQUIRE(std::string(p->color_name[color]) == "red");
+    REQUIRE_FALSE(in_arena(p->color_name));
+  }
+
+  REQUIRE(pool.live == 0);
+  miniexact_set_allocator(nullptr);
+}
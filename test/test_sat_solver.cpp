@@ -1,10 +1,28 @@
 #include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <cstring>
 
+#include <dlfcn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <catch2/catch_test_macros.hpp>
 
+#include <miniexact/algorithm.h>
+#include <miniexact/algorithm_knuth_cnf.h>
+#include <miniexact/ipasir.h>
+#include <miniexact/miniexact.hpp>
+#include <miniexact/parse.h>
 #include <miniexact/sat_solver.h>
+#include <miniexact/util.h>
 
 TEST_CASE("Gather an UNSAT result from a SAT Solver") {
   miniexact_sat_solver solver;
@@ -42,3 +60,257 @@ TEST_CASE("Gather a SAT result from a SAT Solver") {
 
   miniexact_sat_solver_destroy(&solver);
 }
+
+TEST_CASE("A missing IPASIR library falls back to external solvers") {
+  miniexact_ipasir ipasir;
+  REQUIRE(!miniexact_ipasir_open(&ipasir, "libminiexact-no-such-solver.so"));
+  REQUIRE(ipasir.library == nullptr);
+  REQUIRE(ipasir.solver == nullptr);
+}
+
+#ifdef MINIEXACT_IPASIR_MOCK
+// The IPASIR mock of the test tree. Keeping it loaded keeps its counters
+// readable after the solver released it.
+struct ipasir_mock {
+  void* handle;
+  int (*solves)(void);
+  int (*clauses)(void);
+
+  ipasir_mock() {
+    handle = dlopen(MINIEXACT_IPASIR_MOCK, RTLD_NOW | RTLD_LOCAL);
+    REQUIRE(handle);
+    *(void**)&solves = dlsym(handle, "mock_ipasir_solves");
+    *(void**)&clauses = dlsym(handle, "mock_ipasir_clauses");
+    REQUIRE(solves);
+    REQUIRE(clauses);
+  }
+  ~ipasir_mock() { dlclose(handle); }
+};
+
+// All solutions as sorted option indices, each one found once. With cfg, -k
+// solves through the mock, and encoded is set to the clauses of the encoding,
+// i.e. the ones added before the first call.
+static std::set<std::vector<miniexact_link>>
+enumerate(int select,
+          const char* str,
+          miniexact_config* cfg = nullptr,
+          ipasir_mock* mock = nullptr,
+          int* encoded = nullptr) {
+  miniexact_algorithm algorithm;
+  REQUIRE(miniexact_algorithm_from_select(select, &algorithm));
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+  REQUIRE(p);
+  p->cfg = cfg;
+
+  std::set<std::vector<miniexact_link>> solutions;
+  bool first = true;
+  while(algorithm.compute_next_result(&algorithm, p.get())) {
+    if(first && mock && encoded)
+      *encoded = mock->clauses();
+    first = false;
+    // One more, so that data() is valid for the empty solution.
+    std::vector<miniexact_link> solution(p->l + 1);
+    solution.resize(
+      miniexact_extract_solution_option_indices(p.get(), solution.data()));
+    std::sort(solution.begin(), solution.end());
+    REQUIRE(solutions.insert(solution).second);
+  }
+  if(first && mock && encoded)
+    *encoded = mock->clauses();
+  if(algorithm.free_userdata)
+    algorithm.free_userdata(&algorithm, p.get());
+  return solutions;
+}
+
+TEST_CASE("Incremental solving blocks every solution once") {
+  // Domino tilings of a 2 x 3 board.
+  const char* str = "<c0 c1 c2 c3 c4 c5> c0 c1; c1 c2; c3 c4; c4 c5; "
+                    "c0 c3; c1 c4; c2 c5;";
+  ipasir_mock mock;
+  miniexact_config cfg = {};
+  cfg.ipasir = MINIEXACT_IPASIR_MOCK;
+
+  auto expected = enumerate(MINIEXACT_ALGORITHM_X, str);
+  REQUIRE(expected.size() == 3);
+  int encoded = 0;
+  REQUIRE(enumerate(MINIEXACT_ALGORITHM_KNUTH_CNF, str, &cfg, &mock, &encoded)
+          == expected);
+  // One call per solution and one that is UNSAT, with one blocking clause
+  // added before every call but the first.
+  REQUIRE(mock.solves() == (int)expected.size() + 1);
+  REQUIRE(mock.clauses() == encoded + (int)expected.size());
+}
+
+TEST_CASE("Every at-most-one encoding finds the solutions of Algorithm X") {
+  // p has 130 options and z 121, longer than the pairwise (6) and the
+  // sequential (128) encoding are chosen for. Only the 10 options p alone go
+  // together with q z.
+  std::string str = "<p q z>";
+  for(int i = 0; i < 120; ++i)
+    str += " p z;";
+  for(int i = 0; i < 10; ++i)
+    str += " p;";
+  str += " q z;";
+
+  ipasir_mock mock;
+  auto expected = enumerate(MINIEXACT_ALGORITHM_X, str.c_str());
+  REQUIRE(expected.size() == 10);
+
+  for(auto amo : { MINIEXACT_AMO_AUTO,
+                   MINIEXACT_AMO_PAIRWISE,
+                   MINIEXACT_AMO_SEQUENTIAL,
+                   MINIEXACT_AMO_COMMANDER,
+                   MINIEXACT_AMO_PRODUCT }) {
+    miniexact_config cfg = {};
+    cfg.ipasir = MINIEXACT_IPASIR_MOCK;
+    cfg.amo = amo;
+    int encoded = 0;
+    CAPTURE(amo);
+    REQUIRE(enumerate(
+              MINIEXACT_ALGORITHM_KNUTH_CNF, str.c_str(), &cfg, &mock, &encoded)
+            == expected);
+    // Each item is covered at least once, and each pair of its options
+    // excluded once.
+    if(amo == MINIEXACT_AMO_PAIRWISE)
+      REQUIRE(encoded == 3 + 130 * 129 / 2 + 121 * 120 / 2);
+  }
+}
+
+TEST_CASE("The SAT encoding solves XCC and MCC problems like C and M") {
+  ipasir_mock mock;
+  miniexact_config cfg = {};
+  cfg.ipasir = MINIEXACT_IPASIR_MOCK;
+  auto check = [&](int select, const char* str, size_t count) {
+    auto expected = enumerate(select, str);
+    REQUIRE(expected.size() == count);
+    REQUIRE(enumerate(MINIEXACT_ALGORITHM_KNUTH_CNF, str, &cfg, &mock) ==
+            expected);
+    return expected;
+  };
+  using solution = std::vector<miniexact_link>;
+
+  // Options agreeing on the color of x or y go together.
+  check(MINIEXACT_ALGORITHM_C,
+        "<a b c> [x y] a x:1; a x:2 y:1; b x:1; b y:2; c y:1; c x:2; c;",
+        3);
+
+  // {1, 3} is contained in {1, 2, 3}, so blocking only the chosen options
+  // would lose the larger solution.
+  auto supersets =
+    check(MINIEXACT_ALGORITHM_M, "<a : 1;2 b : 1> a; a; b; a b;", 6);
+  REQUIRE(supersets.count(solution{ 1, 3 }));
+  REQUIRE(supersets.count(solution{ 1, 2, 3 }));
+
+  // Option 2 covers no primary item and is never chosen.
+  auto secondary =
+    check(MINIEXACT_ALGORITHM_C, "<a b> [x] a x; x; b; a b x;", 2);
+  for(const auto& s : secondary)
+    REQUIRE(std::find(s.begin(), s.end(), 2) == s.end());
+
+  // The empty solution is found once, and blocked like any other.
+  auto empty = check(MINIEXACT_ALGORITHM_M, "<a : 0;1 b : 0;1> a; b;", 4);
+  REQUIRE(empty.count(solution{}));
+}
+#endif
+
+TEST_CASE("A one-pass CNF gets its header and model when solving") {
+  miniexact_sat_solver solver;
+  std::memset(&solver, 0, sizeof(solver));
+  char* arr[] = { (char*)"-c",
+                  (char*)"read h; cat > /dev/null; "
+                         "test \"$h\" = \"p cnf 12 2\" || exit 1; "
+                         "echo \"c comment -7\"; echo \"s SATISFIABLE\"; "
+                         "echo \"v 1 -2 -10\"; echo \"v 12 0\"; exit 10",
+                  NULL };
+  miniexact_sat_solver_init_one_pass(&solver, 2, (char*)"/bin/sh", arr, NULL);
+  miniexact_sat_solver_binary(&solver, 1, -12);
+  miniexact_sat_solver_ternary(&solver, -2, 10, 12);
+  int status = miniexact_sat_solver_solve(&solver);
+  REQUIRE(status == 10);
+  REQUIRE(solver.variables == 12);
+  REQUIRE(solver.clauses == 2);
+
+  REQUIRE(solver.assignments[1] == true);
+  REQUIRE(solver.assignments[2] == false);
+  REQUIRE(solver.assignments[7] == false);
+  REQUIRE(solver.assignments[10] == false);
+  REQUIRE(solver.assignments[12] == true);
+
+  miniexact_sat_solver_destroy(&solver);
+}
+
+static int sigpipe_count = 0;
+
+static void
+count_sigpipe(int) {
+  ++sigpipe_count;
+}
+
+TEST_CASE("A portfolio uses the first answer and stops the other solvers") {
+  const auto dir = std::filesystem::temp_directory_path() / "miniexact_pf";
+  std::filesystem::create_directories(dir);
+  auto script = [&](const char* name, const char* body) {
+    const auto path = dir / name;
+    std::ofstream(path) << "#!/bin/sh\n" << body << "\n";
+    std::filesystem::permissions(path, std::filesystem::perms::owner_all);
+    return path.string();
+  };
+  // One solver exits before reading its input, one never answers.
+  std::string list = script("early", "exit 1") + "," +
+                     script("slow", "exec sleep 60") + "," +
+                     script("answer",
+                            "cat > /dev/null; echo \"v 1 -2 0\"; exit 10");
+
+  void (*previous)(int) = std::signal(SIGPIPE, count_sigpipe);
+  miniexact_sat_solver_set_portfolio(list.c_str());
+
+  miniexact_sat_solver solver;
+  std::memset(&solver, 0, sizeof(solver));
+  for(int round = 1; round <= 2; ++round) {
+    miniexact_sat_solver_find_and_init(&solver, 2, 2);
+    REQUIRE(solver.processes_count == 3);
+    std::vector<pid_t> pids;
+    for(size_t i = 0; i < solver.processes_count; ++i)
+      pids.push_back(solver.processes[i].pid);
+
+    // Gives the early solver time to exit, so that writing to it fails.
+    usleep(100000);
+    miniexact_sat_solver_unit(&solver, 1);
+    miniexact_sat_solver_binary(&solver, -1, -2);
+    REQUIRE(miniexact_sat_solver_solve(&solver) == 10);
+    REQUIRE(solver.assignments[1] == true);
+    REQUIRE(solver.assignments[2] == false);
+
+    // Every solver was reaped, the slow one after being killed.
+    for(pid_t pid : pids) {
+      REQUIRE(waitpid(pid, nullptr, WNOHANG) == -1);
+      REQUIRE(errno == ECHILD);
+    }
+
+    std::FILE* tmp = std::tmpfile();
+    REQUIRE(tmp);
+    miniexact_sat_solver_print_portfolio_stats(tmp);
+    std::rewind(tmp);
+    char line[256];
+    REQUIRE(std::fgets(line, sizeof(line), tmp));
+    std::vector<std::string> rows;
+    while(std::fgets(line, sizeof(line), tmp)) {
+      std::istringstream row(line);
+      std::string name;
+      size_t races, wins;
+      row >> name >> races >> wins;
+      REQUIRE(races == (size_t)round);
+      rows.push_back(name + " " + std::to_string(wins));
+    }
+    std::fclose(tmp);
+    REQUIRE(rows == std::vector<std::string>{
+                      "early 0", "slow 0", "answer " + std::to_string(round) });
+  }
+  miniexact_sat_solver_destroy(&solver);
+  miniexact_sat_solver_set_portfolio(nullptr);
+
+  // SIGPIPE was only ignored while writing.
+  REQUIRE(sigpipe_count == 0);
+  REQUIRE(std::signal(SIGPIPE, previous) == count_sigpipe);
+  std::filesystem::remove_all(dir);
+}
@@ -1,13 +1,93 @@
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 
+#include <unistd.h>
+
 #include <catch2/catch_test_macros.hpp>
 
 #include <miniexact/algorithm.h>
+#include <miniexact/algorithm_c.h>
+#include <miniexact/algorithm_dc.h>
 #include <miniexact/algorithm_m.h>
 #include <miniexact/algorithm_x.h>
+#include <miniexact/algorithm_x_bitset.h>
+#include <miniexact/algorithm_z.h>
+#include <miniexact/assume.h>
+#include <miniexact/binary.h>
+#include <miniexact/budget.h>
+#include <miniexact/cancel.h>
+#include <miniexact/checkpoint.h>
+#include <miniexact/components.h>
+#include <miniexact/estimate.h>
+#include <miniexact/parallel.h>
 #include <miniexact/parse.h>
+#include <miniexact/simple.hpp>
+#include <miniexact/profile.h>
 #include <miniexact/miniexact.h>
+#include <miniexact/util.h>
+
+// Domino tilings of an n x n board. With multiplicities, every cell is given
+// as c : 1, so that Algorithm M solves the same problem as X and C.
+static std::string
+domino_problem(int n, bool multiplicities = true) {
+  std::string str = "<";
+  for(int c = 0; c < n * n; ++c)
+    str += " c" + std::to_string(c) + (multiplicities ? " : 1" : "");
+  str += " >";
+  for(int r = 0; r < n; ++r)
+    for(int c = 0; c < n; ++c) {
+      std::string cell = " c" + std::to_string(r * n + c);
+      if(c + 1 < n)
+        str += cell + " c" + std::to_string(r * n + c + 1) + ";";
+      if(r + 1 < n)
+        str += cell + " c" + std::to_string((r + 1) * n + c) + ";";
+    }
+  return str;
+}
+
+// Runs check once with each of Algorithms X, C and M.
+template<typename F>
+static void
+for_each_xcm(F check) {
+  for(auto set : { &miniexact_algorithm_x_set,
+                   &miniexact_algorithm_c_set,
+                   &miniexact_algorithm_m_set }) {
+    miniexact_algorithm algorithm;
+    set(&algorithm);
+    check(algorithm);
+  }
+}
+
+// Runs solve with stdout redirected into a temporary file and returns what it
+// printed.
+template<typename F>
+static std::string
+capture_stdout(F solve) {
+  std::fflush(stdout);
+  FILE* tmp = std::tmpfile();
+  REQUIRE(tmp);
+  int saved = dup(STDOUT_FILENO);
+  dup2(fileno(tmp), STDOUT_FILENO);
+  solve();
+  std::fflush(stdout);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+
+  std::string out;
+  std::rewind(tmp);
+  char buf[4096];
+  size_t len;
+  while((len = std::fread(buf, 1, sizeof(buf), tmp)) > 0)
+    out.append(buf, len);
+  std::fclose(tmp);
+  return out;
+}
 
 TEST_CASE("solve standard XCC example") {
   const char* str = "<a b c d e f g> c e; a d g; b c f; a d f; b g; d e g;";
@@ -56,3 +136,1005 @@ TEST_CASE("solve small MCC example") {
   CAPTURE(solution_unsorted);
   REQUIRE_FALSE(has_duplicates);
 }
+
+TEST_CASE("counting and enumerating MCC solutions agree") {
+  // M also visits the empty solution, which is neither printed nor counted.
+  const char* str = "< p0 p1 p2 > p2 p0 p1; p0; p2;";
+
+  auto run = [&](bool count, std::vector<std::string>* solutions) {
+    miniexact_algorithm algorithm;
+    miniexact_algorithm_m_set(&algorithm);
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+    REQUIRE(p);
+    miniexact_config cfg = {};
+    cfg.count = count;
+    cfg.enumerate = !count;
+    std::istringstream out(capture_stdout([&]() {
+      miniexact_solve_problem_and_print_solutions(&algorithm, p.get(), &cfg);
+    }));
+    std::string found;
+    for(std::string line; std::getline(out, line);) {
+      if(line.rfind("Found", 0) == 0)
+        found = line;
+      else if(!line.empty() && solutions)
+        solutions->push_back(line);
+    }
+    return found;
+  };
+
+  std::vector<std::string> solutions;
+  REQUIRE(run(false, &solutions) == "Found 7 solutions!");
+  REQUIRE(solutions.size() == 7);
+  REQUIRE(run(true, nullptr) == "Found 7 solutions!");
+}
+
+TEST_CASE("solve a cloned XCC problem independently") {
+  const char* str = "<a b c d e f g> c e; a d g; b c f; a d f; b g; d e g;";
+
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_x_set(&algorithm);
+
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+  REQUIRE(p);
+
+  miniexact_problem_ptr c(miniexact_problem_clone(p.get()));
+  REQUIRE(c);
+  REQUIRE(c->llink != p->llink);
+  REQUIRE(std::string(c->name[1]) == "a");
+
+  REQUIRE(algorithm.compute_next_result(&algorithm, c.get()));
+  REQUIRE(algorithm.compute_next_result(&algorithm, p.get()));
+
+  std::vector<miniexact_link> solution(c->l);
+  miniexact_extract_solution_option_indices(c.get(), solution.data());
+  std::sort(solution.begin(), solution.end());
+  REQUIRE(solution == std::vector<miniexact_link>{ 1, 4, 5 });
+}
+
+#ifdef MINIEXACT_THREADS_AVAILABLE
+TEST_CASE("parallel enumeration finds the solutions of the serial one") {
+  std::string str = domino_problem(6, false);
+
+  // Sorted solutions as sorted option indices, and the final count.
+  auto enumerate = [&](miniexact_algorithm_id id, int threads) {
+    miniexact_algorithm algorithm;
+    REQUIRE(miniexact_algorithm_from_select(id, &algorithm));
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(p);
+    miniexact_config cfg = {};
+    cfg.algorithm_select = id;
+    cfg.enumerate = 1;
+    cfg.threads = threads;
+    std::istringstream out(capture_stdout([&]() {
+      REQUIRE(miniexact_solve_problem_and_print_solutions(
+                &algorithm, p.get(), &cfg) == 20);
+    }));
+
+    std::vector<std::vector<int>> solutions;
+    std::string found;
+    for(std::string line; std::getline(out, line);) {
+      if(line.rfind("Found", 0) == 0) {
+        found = line;
+      } else if(!line.empty()) {
+        std::istringstream options(line);
+        std::vector<int> solution;
+        for(int o; options >> o;)
+          solution.push_back(o);
+        std::sort(solution.begin(), solution.end());
+        solutions.push_back(solution);
+      }
+    }
+    std::sort(solutions.begin(), solutions.end());
+    return std::make_pair(solutions, found);
+  };
+
+  for(auto id : { MINIEXACT_ALGORITHM_X, MINIEXACT_ALGORITHM_C }) {
+    auto serial = enumerate(id, 1);
+    REQUIRE(serial.first.size() == 6728);
+    REQUIRE(serial.second == "Found 6728 solutions!");
+    REQUIRE(enumerate(id, 4) == serial);
+  }
+}
+#endif
+
+TEST_CASE("solve an MCC problem loaded from a binary file") {
+  const char* str = "<a : 2 b : 1;2> a; a b; b;";
+  const std::string path =
+    (std::filesystem::temp_directory_path() / "miniexact_test_problem.bin")
+      .string();
+
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_m_set(&algorithm);
+
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+  REQUIRE(p);
+  REQUIRE(miniexact_write_problem_binary(p.get(), path.c_str()) == nullptr);
+
+  miniexact_problem_ptr b(miniexact_parse_problem_file(&algorithm, path.c_str()));
+  std::remove(path.c_str());
+  REQUIRE(b);
+  REQUIRE(b->mapped);
+  REQUIRE(b->N == p->N);
+  REQUIRE(b->primary_item_count == p->primary_item_count);
+  REQUIRE(std::string(b->name[2]) == "b");
+  REQUIRE(b->slack_size == p->slack_size);
+  REQUIRE(b->slack[1] == 0);
+  REQUIRE(b->slack[2] == 1);
+
+  while(algorithm.compute_next_result(&algorithm, p.get())) {
+    REQUIRE(algorithm.compute_next_result(&algorithm, b.get()));
+    REQUIRE(b->l == p->l);
+
+    std::vector<miniexact_link> expected(p->l), loaded(b->l);
+    miniexact_extract_solution_option_indices(p.get(), expected.data());
+    miniexact_extract_solution_option_indices(b.get(), loaded.data());
+    REQUIRE(loaded == expected);
+  }
+  REQUIRE_FALSE(algorithm.compute_next_result(&algorithm, b.get()));
+}
+
+TEST_CASE("bucket MRV enumerates the same solutions as MRV") {
+  const char* str = "<a b c d> [x] a b x:A; c d; a c x:B; b d; a; b; c; d;";
+
+  auto enumerate = [&](miniexact_choose_i choose_i) {
+    miniexact_algorithm algorithm;
+    miniexact_algorithm_c_set(&algorithm);
+    algorithm.choose_i = choose_i;
+
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+    REQUIRE(p);
+
+    std::vector<std::vector<miniexact_link>> solutions;
+    while(algorithm.compute_next_result(&algorithm, p.get())) {
+      std::vector<miniexact_link> solution(p->l);
+      miniexact_extract_solution_option_indices(p.get(), solution.data());
+      std::sort(solution.begin(), solution.end());
+      solutions.push_back(solution);
+    }
+    std::sort(solutions.begin(), solutions.end());
+    return solutions;
+  };
+
+  auto expected = enumerate(&miniexact_choose_i_mrv);
+  REQUIRE(expected.size() == 7);
+  REQUIRE(enumerate(&miniexact_choose_i_mrv_bucket) == expected);
+}
+
+TEST_CASE("Algorithm Z enumerates and counts the same solutions as X") {
+  const char* str = "<a b c d> [x] a b x; c d; a c; b d; a; b; c; d;";
+
+  auto enumerate = [&](void (*set)(miniexact_algorithm*), std::string* count) {
+    miniexact_algorithm algorithm;
+    set(&algorithm);
+
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+    REQUIRE(p);
+
+    std::vector<std::vector<miniexact_link>> solutions;
+    while(algorithm.compute_next_result(&algorithm, p.get())) {
+      std::vector<miniexact_link> solution(p->l);
+      miniexact_extract_solution_option_indices(p.get(), solution.data());
+      std::sort(solution.begin(), solution.end());
+      solutions.push_back(solution);
+    }
+    std::sort(solutions.begin(), solutions.end());
+
+    if(count) {
+      char* c = miniexact_algorithm_z_count(p.get());
+      REQUIRE(c);
+      *count = c;
+      free(c);
+    }
+    if(algorithm.free_userdata)
+      algorithm.free_userdata(&algorithm, p.get());
+    return solutions;
+  };
+
+  std::string count;
+  auto expected = enumerate(&miniexact_algorithm_x_set, nullptr);
+  REQUIRE(expected.size() == 7);
+  REQUIRE(enumerate(&miniexact_algorithm_z_set, &count) == expected);
+  REQUIRE(count == "7");
+}
+
+TEST_CASE("Algorithm Z counts domino tilings beyond 32 bits") {
+  std::string str = domino_problem(10, false);
+
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_z_set(&algorithm);
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+  REQUIRE(p);
+  REQUIRE(algorithm.compute_next_result(&algorithm, p.get()));
+
+  char* count = miniexact_algorithm_z_count(p.get());
+  REQUIRE(count);
+  REQUIRE(std::string(count) == "258584046368");
+  free(count);
+  algorithm.free_userdata(&algorithm, p.get());
+}
+
+TEST_CASE("independent components multiply their solution counts") {
+  // Two copies of the 7 solution problem above, plus one with colors.
+  const char* str = "<a b c d e f g h i j> [x y z] a b x; c d; a c; b d; a; b;"
+                    " c; d; e f y; g h; e g; f h; e; f; g; h; i z:A; j z:B;"
+                    " i j; i; j;";
+
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_c_set(&algorithm);
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+  REQUIRE(p);
+
+  REQUIRE(miniexact_components_count(p.get()) == 3);
+
+  uint64_t count = 0;
+  REQUIRE(miniexact_components_count_solutions(p.get(), &count) == nullptr);
+  REQUIRE(count == 7 * 7 * 4);
+
+  REQUIRE(miniexact_components_solve(p.get()) == 10);
+  std::vector<miniexact_link> solution(p->l);
+  miniexact_link l =
+    miniexact_extract_solution_option_indices(p.get(), solution.data());
+  REQUIRE(l >= 5);
+
+  // Both searches restore the matrix, so C still finds every solution.
+  size_t solutions = 0;
+  while(algorithm.compute_next_result(&algorithm, p.get()))
+    ++solutions;
+  REQUIRE(solutions == 7 * 7 * 4);
+}
+
+TEST_CASE("a component without solutions stops the search") {
+  const char* str = "<a b c d e f g> a b; c d; a c; b d; e f; f g;";
+
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_x_set(&algorithm);
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+  REQUIRE(p);
+
+  uint64_t count = 1;
+  REQUIRE(miniexact_components_count_solutions(p.get(), &count) == nullptr);
+  REQUIRE(count == 0);
+  REQUIRE(miniexact_components_solve(p.get()) == 20);
+  REQUIRE(p->l == 0);
+}
+
+TEST_CASE("dancing cells enumerate the same solutions as Algorithm C") {
+  const char* str = "<a b c d e> [x y] a b x:A; c d y; a c x:B; b d x:A y:C;"
+                    " a; b; c; d; e x:A; e y:C; e x:B y;";
+
+  auto enumerate = [&](void (*set)(miniexact_algorithm*)) {
+    miniexact_algorithm algorithm;
+    set(&algorithm);
+
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+    REQUIRE(p);
+
+    std::vector<std::vector<miniexact_link>> solutions;
+    while(algorithm.compute_next_result(&algorithm, p.get())) {
+      std::vector<miniexact_link> solution(p->l);
+      miniexact_extract_solution_option_indices(p.get(), solution.data());
+      std::sort(solution.begin(), solution.end());
+      solutions.push_back(solution);
+    }
+    std::sort(solutions.begin(), solutions.end());
+
+    if(algorithm.free_userdata)
+      algorithm.free_userdata(&algorithm, p.get());
+    return solutions;
+  };
+
+  auto expected = enumerate(&miniexact_algorithm_c_set);
+  REQUIRE(expected.size() == 11);
+  REQUIRE(enumerate(&miniexact_algorithm_dc_set) == expected);
+}
+
+TEST_CASE("bitset Algorithm X finds the solutions of X in the same order") {
+  const char* str = "<a b c d> [x] a b x; c d; a c; b d; a; b; c d x; c; d;";
+
+  auto enumerate = [&](void (*set)(miniexact_algorithm*)) {
+    miniexact_algorithm algorithm;
+    set(&algorithm);
+
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+    REQUIRE(p);
+
+    std::vector<std::vector<miniexact_link>> solutions;
+    while(algorithm.compute_next_result(&algorithm, p.get())) {
+      std::vector<miniexact_link> solution(p->l);
+      miniexact_extract_solution_option_indices(p.get(), solution.data());
+      solutions.push_back(solution);
+    }
+
+    if(algorithm.free_userdata)
+      algorithm.free_userdata(&algorithm, p.get());
+    return solutions;
+  };
+
+  auto expected = enumerate(&miniexact_algorithm_x_set);
+  REQUIRE(expected.size() == 8);
+  REQUIRE(enumerate(&miniexact_algorithm_x_bitset_set) == expected);
+}
+
+TEST_CASE("bitset Algorithm X falls back to dancing links for many items") {
+  std::string str = "<";
+  for(int i = 0; i <= MINIEXACT_BITSET_MAX_ITEMS; ++i)
+    str += " i" + std::to_string(i);
+  str += " >";
+  for(int i = 0; i <= MINIEXACT_BITSET_MAX_ITEMS; ++i)
+    str += " i" + std::to_string(i) + ";";
+
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_x_bitset_set(&algorithm);
+  auto bitset = algorithm.compute_next_result;
+
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+  REQUIRE(p);
+  REQUIRE(algorithm.compute_next_result(&algorithm, p.get()));
+  REQUIRE(algorithm.compute_next_result != bitset);
+  REQUIRE(p->l == MINIEXACT_BITSET_MAX_ITEMS + 1);
+  REQUIRE_FALSE(algorithm.compute_next_result(&algorithm, p.get()));
+}
+
+TEST_CASE("preprocessing removes blocked options and keeps option indices") {
+  // b only accepts x:A, so a x:B and c x:B are blocked. Afterwards, x is A in
+  // every remaining option.
+  const char* str = "<a b c> [x] a x:A; a x:B; b x:A; c; c x:B;";
+
+  miniexact_algorithm algorithm;
+  REQUIRE(miniexact_algorithm_from_select(
+    MINIEXACT_ALGORITHM_C | MINIEXACT_ALGORITHM_PREPROCESS, &algorithm));
+
+  miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+  REQUIRE(p);
+  REQUIRE(p->preprocess.removed_options == 2);
+  REQUIRE(p->preprocess.removed_secondary_items == 1);
+  REQUIRE(p->Z + 1 == (int)MINIEXACT_NODES_SIZE(p.get()));
+
+  REQUIRE(algorithm.compute_next_result(&algorithm, p.get()));
+  std::vector<miniexact_link> solution(p->l);
+  miniexact_extract_solution_option_indices(p.get(), solution.data());
+  std::sort(solution.begin(), solution.end());
+  REQUIRE(solution == std::vector<miniexact_link>{ 1, 3, 4 });
+  REQUIRE_FALSE(algorithm.compute_next_result(&algorithm, p.get()));
+}
+
+TEST_CASE("dancing cells skips secondary items detached by preprocessing") {
+  auto solve = [](int select, const char* str) {
+    miniexact_algorithm algorithm;
+    REQUIRE(miniexact_algorithm_from_select(select, &algorithm));
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+    REQUIRE(p);
+
+    std::set<std::vector<miniexact_link>> solutions;
+    while(algorithm.compute_next_result(&algorithm, p.get())) {
+      std::vector<miniexact_link> solution(p->l);
+      solution.resize(
+        miniexact_extract_solution_option_indices(p.get(), solution.data()));
+      std::sort(solution.begin(), solution.end());
+      REQUIRE(solutions.insert(solution).second);
+    }
+    if(algorithm.free_userdata)
+      algorithm.free_userdata(&algorithm, p.get());
+    return solutions;
+  };
+
+  for(const char* str :
+      { "< p0 p1 p2 > [ s0 ] p1 s0; p1 p0; p2; p1 p0 p2; p2 p0;",
+        "< p0 p1 > [ s0 s1 s2 ] p1 p0 s2; p0 s0; p0 p1 s2; p1 s0 s1 s2; p1;" }) {
+    auto expected = solve(MINIEXACT_ALGORITHM_C, str);
+    REQUIRE(expected.size() == 3);
+    REQUIRE(solve(MINIEXACT_ALGORITHM_DC | MINIEXACT_ALGORITHM_PREPROCESS,
+                  str) == expected);
+  }
+}
+
+TEST_CASE("resuming from a checkpoint continues the enumeration") {
+  std::string str = domino_problem(6);
+  const std::string path =
+    (std::filesystem::temp_directory_path() / "miniexact_test.checkpoint")
+      .string();
+  std::remove(path.c_str());
+
+  for_each_xcm([&](miniexact_algorithm& algorithm) {
+    miniexact_config cfg = {};
+    cfg.algorithm_select = MINIEXACT_ALGORITHM_X;
+    cfg.checkpoint = path.c_str();
+
+    auto next = [&](miniexact_problem* p,
+                    std::vector<std::vector<miniexact_link>>& solutions) {
+      if(!algorithm.compute_next_result(&algorithm, p))
+        return false;
+      std::vector<miniexact_link> solution(p->l);
+      solution.resize(
+        miniexact_extract_solution_option_indices(p, solution.data()));
+      solutions.push_back(solution);
+      if(p->checkpoint)
+        p->checkpoint->solutions = solutions.size();
+      return true;
+    };
+
+    std::vector<std::vector<miniexact_link>> expected;
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(p);
+    while(next(p.get(), expected))
+      ;
+    REQUIRE(expected.size() == 6728);
+
+    // Write a checkpoint as soon as possible and stop right after it, like
+    // a preempted run.
+    std::vector<std::vector<miniexact_link>> before;
+    miniexact_checkpoint checkpoint;
+    p.reset(miniexact_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(miniexact_checkpoint_init(&checkpoint, p.get(), &cfg) == nullptr);
+    checkpoint.interval = 0;
+    while(!std::filesystem::exists(path))
+      REQUIRE(next(p.get(), before));
+
+    cfg.resume = 1;
+    p.reset(miniexact_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(miniexact_checkpoint_init(&checkpoint, p.get(), &cfg) == nullptr);
+    REQUIRE(checkpoint.replay_size > 0);
+    REQUIRE(checkpoint.solutions <= (long long)before.size());
+    before.resize(checkpoint.solutions);
+    while(next(p.get(), before))
+      ;
+    REQUIRE(before == expected);
+
+    miniexact_checkpoint_finish(&checkpoint, p.get());
+    REQUIRE_FALSE(std::filesystem::exists(path));
+  });
+}
+
+TEST_CASE("resuming with a node limit below the replay depth progresses") {
+  std::string str = domino_problem(4);
+  const std::string path =
+    (std::filesystem::temp_directory_path() / "miniexact_test.checkpoint")
+      .string();
+  std::remove(path.c_str());
+
+  for_each_xcm([&](miniexact_algorithm& algorithm) {
+    miniexact_config cfg = {};
+    cfg.algorithm_select = MINIEXACT_ALGORITHM_X;
+    cfg.checkpoint = path.c_str();
+    cfg.resume = 1;
+    // Solutions are 8 levels deep.
+    cfg.node_limit = 3;
+
+    long long solutions = 0;
+    for(int runs = 1;; ++runs) {
+      REQUIRE(runs < 1000);
+      miniexact_problem_ptr p(
+        miniexact_parse_problem(&algorithm, str.c_str()));
+      REQUIRE(p);
+      miniexact_budget budget;
+      miniexact_budget_init(&budget, p.get(), &cfg);
+      miniexact_checkpoint checkpoint;
+      REQUIRE(miniexact_checkpoint_init(&checkpoint, p.get(), &cfg) ==
+              nullptr);
+
+      while(algorithm.compute_next_result(&algorithm, p.get()))
+        ++checkpoint.solutions;
+      solutions = checkpoint.solutions;
+      miniexact_budget_finish(&budget, p.get());
+      if(!budget.exhausted) {
+        miniexact_checkpoint_finish(&checkpoint, p.get());
+        REQUIRE(runs > 1);
+        break;
+      }
+      miniexact_checkpoint_suspend(&checkpoint, p.get());
+    }
+    REQUIRE(solutions == 36);
+    REQUIRE_FALSE(std::filesystem::exists(path));
+  });
+}
+
+TEST_CASE("resuming after the solution limit reports every solution once") {
+  std::string str = domino_problem(4);
+  const std::string path =
+    (std::filesystem::temp_directory_path() / "miniexact_test.checkpoint")
+      .string();
+  std::remove(path.c_str());
+
+  for_each_xcm([&](miniexact_algorithm& algorithm) {
+    miniexact_config cfg = {};
+    cfg.algorithm_select = MINIEXACT_ALGORITHM_X;
+    cfg.enumerate = 1;
+    cfg.checkpoint = path.c_str();
+    cfg.resume = 1;
+    // 36 is a multiple, so the last run stops right at the last solution.
+    cfg.solution_limit = 6;
+
+    std::vector<std::string> solutions;
+    for(int runs = 1;; ++runs) {
+      REQUIRE(runs < 100);
+      miniexact_problem_ptr p(
+        miniexact_parse_problem(&algorithm, str.c_str()));
+      REQUIRE(p);
+      int return_code;
+      std::istringstream out(capture_stdout([&]() {
+        return_code =
+          miniexact_solve_problem_and_print_solutions(&algorithm, p.get(), &cfg);
+      }));
+      for(std::string line; std::getline(out, line);)
+        if(!line.empty() && line.rfind("Found", 0) != 0)
+          solutions.push_back(line);
+      if(return_code != MINIEXACT_BUDGET_EXHAUSTED) {
+        REQUIRE(return_code == 20);
+        REQUIRE(runs == 7);
+        break;
+      }
+    }
+    REQUIRE(solutions.size() == 36);
+    REQUIRE(std::set<std::string>(solutions.begin(), solutions.end()).size() ==
+            36);
+    REQUIRE_FALSE(std::filesystem::exists(path));
+  });
+}
+
+TEST_CASE("search counters are only maintained with MINIEXACT_STATS") {
+  const char* str = "<a b c d e f g> c e; a d g; b c f; a d f; b g; d e g;";
+
+  for(auto set : { &miniexact_algorithm_x_set,
+                   &miniexact_algorithm_dc_set,
+                   &miniexact_algorithm_x_bitset_set }) {
+    miniexact_algorithm algorithm;
+    set(&algorithm);
+
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str));
+    REQUIRE(p);
+    REQUIRE(miniexact_solve_problem(&algorithm, p.get()) == 10);
+    REQUIRE(p->stats.solve_time >= 0);
+
+#ifdef MINIEXACT_STATS
+    // At least one node per option of the solution.
+    REQUIRE(p->stats.nodes >= 3);
+    REQUIRE(p->stats.updates > 0);
+    REQUIRE(p->stats.mems > p->stats.updates);
+    REQUIRE(p->stats.choose_scans > 0);
+#else
+    REQUIRE(p->stats.nodes == 0);
+    REQUIRE(p->stats.mems == 0);
+#endif
+    if(algorithm.free_userdata)
+      algorithm.free_userdata(&algorithm, p.get());
+  }
+}
+
+TEST_CASE("the search profile accounts for every node of the tree") {
+  std::string str = domino_problem(4);
+
+  for_each_xcm([&](miniexact_algorithm& algorithm) {
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(p);
+
+    miniexact_profile profile;
+    miniexact_profile_init(&profile, p.get());
+    int solutions = 0;
+    while(algorithm.compute_next_result(&algorithm, p.get()))
+      ++solutions;
+    REQUIRE(solutions == 36);
+
+    // Every tiling places 8 dominoes, so the tree has 8 levels below the
+    // root, and every node that was entered is left again.
+    REQUIRE(profile.levels_size == 9);
+    REQUIRE(profile.levels[0].nodes == 1);
+    REQUIRE(profile.levels[8].nodes == 36);
+    for(size_t l = 1; l < profile.levels_size; ++l) {
+      REQUIRE(profile.levels[l].backtracks == profile.levels[l].nodes);
+    }
+    REQUIRE(profile.levels[0].choices == 1);
+    REQUIRE(profile.levels[0].len_sum == 2);
+
+    miniexact_profile_finish(&profile, p.get());
+    REQUIRE(p->profile == nullptr);
+  });
+}
+
+TEST_CASE("random paths estimate the size of the search tree") {
+  std::string str = domino_problem(4);
+
+  for_each_xcm([&](miniexact_algorithm& algorithm) {
+    // Without branching, every path is the whole tree.
+    miniexact_problem_ptr p(
+      miniexact_parse_problem(&algorithm, "<a : 1 b : 1> a; b;"));
+    REQUIRE(p);
+    miniexact_estimate e;
+    miniexact_estimate_init(&e, p.get(), 0);
+    for(int i = 0; i < 10; ++i)
+      miniexact_estimate_walk(&e, &algorithm, p.get());
+    double error;
+    REQUIRE(miniexact_estimate_mean(&e, &e.nodes, &error) == 3);
+    REQUIRE(error == 0);
+    REQUIRE(miniexact_estimate_mean(&e, &e.solutions, &error) == 1);
+    miniexact_estimate_finish(&e, p.get());
+
+    // The exact tree has 36 solutions, count its nodes with a profile.
+    p.reset(miniexact_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(p);
+    miniexact_profile profile;
+    miniexact_profile_init(&profile, p.get());
+    while(algorithm.compute_next_result(&algorithm, p.get()))
+      ;
+    double nodes = 0;
+    for(size_t l = 0; l < profile.levels_size; ++l)
+      nodes += profile.levels[l].nodes;
+    miniexact_profile_finish(&profile, p.get());
+
+    // Walks leave the problem intact, so the search can be repeated.
+    p->state = 0;
+    miniexact_estimate_init(&e, p.get(), 0);
+    for(int i = 0; i < 20000; ++i)
+      miniexact_estimate_walk(&e, &algorithm, p.get());
+    REQUIRE(e.walks == 20000);
+    double estimated = miniexact_estimate_mean(&e, &e.nodes, &error);
+    REQUIRE(error > 0);
+    REQUIRE(estimated > nodes * 0.9);
+    REQUIRE(estimated < nodes * 1.1);
+    estimated = miniexact_estimate_mean(&e, &e.solutions, &error);
+    REQUIRE(estimated > 36 * 0.9);
+    REQUIRE(estimated < 36 * 1.1);
+    miniexact_estimate_finish(&e, p.get());
+    REQUIRE(p->estimate == nullptr);
+  });
+
+  // Items with slack also branch on taking none of their options.
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_m_set(&algorithm);
+  miniexact_problem_ptr p(miniexact_parse_problem(
+    &algorithm, "< a:0;2 b:1 c:1 > a b; a c; b c; a; b; c;"));
+  REQUIRE(p);
+  int solutions = 0;
+  while(algorithm.compute_next_result(&algorithm, p.get()))
+    ++solutions;
+  REQUIRE(solutions == 9);
+
+  p->state = 0;
+  miniexact_estimate e;
+  miniexact_estimate_init(&e, p.get(), 0);
+  for(int i = 0; i < 20000; ++i)
+    miniexact_estimate_walk(&e, &algorithm, p.get());
+  double error;
+  double estimated = miniexact_estimate_mean(&e, &e.solutions, &error);
+  REQUIRE(estimated > 9 * 0.9);
+  REQUIRE(estimated < 9 * 1.1);
+  miniexact_estimate_finish(&e, p.get());
+}
+
+TEST_CASE("a search stopped by its node budget can continue") {
+  std::string str = domino_problem(4);
+
+  auto check = [&](miniexact_algorithm& algorithm) {
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(p);
+
+    miniexact_config cfg = {};
+    cfg.node_limit = 10;
+    REQUIRE(miniexact_budget_configured(&cfg));
+    miniexact_budget budget;
+    miniexact_budget_init(&budget, p.get(), &cfg);
+
+    int solutions = 0;
+    while(algorithm.compute_next_result(&algorithm, p.get()))
+      ++solutions;
+    REQUIRE(budget.exhausted == MINIEXACT_BUDGET_NODES);
+    REQUIRE(budget.nodes == 10);
+    // Solutions are 8 levels deep.
+    REQUIRE(solutions <= 2);
+    miniexact_budget_finish(&budget, p.get());
+    REQUIRE(p->budget == nullptr);
+
+    while(algorithm.compute_next_result(&algorithm, p.get()))
+      ++solutions;
+    REQUIRE(solutions == 36);
+
+    if(algorithm.free_userdata)
+      algorithm.free_userdata(&algorithm, p.get());
+  };
+  for_each_xcm(check);
+  miniexact_algorithm dc;
+  miniexact_algorithm_dc_set(&dc);
+  check(dc);
+}
+
+TEST_CASE("the memory limit of one file does not stop the next one") {
+  std::string str = domino_problem(6, false);
+  miniexact_config cfg = {};
+  cfg.memory_limit = 8;
+
+  // Solves one file, growing the process by grow MiB during the search.
+  auto solve = [&](size_t grow) {
+    miniexact_algorithm algorithm;
+    miniexact_algorithm_x_set(&algorithm);
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(p);
+    miniexact_budget budget;
+    miniexact_budget_init(&budget, p.get(), &cfg);
+
+    std::vector<char> memory(grow * 1024 * 1024, 1);
+    int solutions = 0;
+    while(algorithm.compute_next_result(&algorithm, p.get()))
+      ++solutions;
+    miniexact_budget_finish(&budget, p.get());
+    return std::make_pair(solutions, budget.exhausted);
+  };
+
+  if(miniexact_current_memory() == 0)
+    return;
+  REQUIRE(solve(32).second == MINIEXACT_BUDGET_MEMORY);
+  auto second = solve(0);
+  REQUIRE(second.second == MINIEXACT_BUDGET_NONE);
+  REQUIRE(second.first == 6728);
+}
+
+TEST_CASE("a cancelled search backtracks to the root and can start again") {
+  auto check = [](miniexact_algorithm& algorithm,
+                  const char* problem,
+                  int expected) {
+    miniexact_problem_ptr p(miniexact_parse_problem(&algorithm, problem));
+    REQUIRE(p);
+    miniexact_cancel* cancel = miniexact_cancel_new();
+    p->cancel = cancel;
+
+    // Cancel after the first solution, noticed at the next node.
+    miniexact_cancel_set_progress(cancel, nullptr, 1, nullptr);
+    REQUIRE(miniexact_solve_problem(&algorithm, p.get()) == 10);
+    std::vector<miniexact_link> first(p->l);
+    miniexact_extract_solution_option_indices(p.get(), first.data());
+    miniexact_cancel_request(cancel);
+    REQUIRE(miniexact_solve_problem(&algorithm, p.get()) ==
+            MINIEXACT_CANCELLED);
+    REQUIRE(p->l == 0);
+
+    // The matrix is restored, so the search finds everything again.
+    miniexact_cancel_reset(cancel);
+    p->state = 0;
+    int solutions = 0;
+    while(miniexact_solve_problem(&algorithm, p.get()) == 10) {
+      if(solutions++ == 0) {
+        std::vector<miniexact_link> again(p->l);
+        miniexact_extract_solution_option_indices(p.get(), again.data());
+        REQUIRE(again == first);
+      }
+    }
+    REQUIRE(solutions == expected);
+
+    miniexact_cancel_free(cancel);
+  };
+
+  std::string str = domino_problem(4);
+  for_each_xcm([&](miniexact_algorithm& algorithm) {
+    check(algorithm, str.c_str(), 36);
+  });
+
+  // Cancelling M also skips the branches without an option of an item.
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_m_set(&algorithm);
+  check(algorithm, "< a:0;2 b:1 c:1 > a b; a c; b c; a; b; c;", 9);
+}
+
+TEST_CASE("the simple API is cancelled by its progress callback") {
+  miniexacts_x h;
+  h.primary("a");
+  h.primary("b");
+  h.primary("c");
+  h.add(std::vector<const char*>{ "a", "b" });
+  h.add(std::vector<const char*>{ "c" });
+  h.add(std::vector<const char*>{ "a" });
+  h.add(std::vector<const char*>{ "b", "c" });
+
+  int calls = 0;
+  h.progress(
+    [&calls](uint64_t nodes) {
+      REQUIRE(nodes > 0);
+      // Two nodes lead to the first solution.
+      return ++calls < 3;
+    },
+    1);
+  REQUIRE(h.solve() == 10);
+  REQUIRE(h.solve() == 40);
+  REQUIRE(h.cancelled());
+
+  // Starts again from the first solution.
+  h.progress(nullptr);
+  int solutions = 0;
+  while(h.solve() == 10)
+    ++solutions;
+  REQUIRE(solutions == 2);
+}
+
+TEST_CASE("the simple API enumerates solutions in batches") {
+  auto tilings = []() {
+    auto h = std::make_unique<miniexacts_x>();
+    for(int c = 0; c < 16; ++c)
+      h->primary(("c" + std::to_string(c)).c_str());
+    for(int r = 0; r < 4; ++r)
+      for(int c = 0; c < 4; ++c) {
+        std::string cell = "c" + std::to_string(r * 4 + c);
+        if(c + 1 < 4) {
+          std::string right = "c" + std::to_string(r * 4 + c + 1);
+          h->add(std::vector<const char*>{ cell.c_str(), right.c_str() });
+        }
+        if(r + 1 < 4) {
+          std::string below = "c" + std::to_string((r + 1) * 4 + c);
+          h->add(std::vector<const char*>{ cell.c_str(), below.c_str() });
+        }
+      }
+    return h;
+  };
+
+  std::vector<std::vector<int32_t>> expected;
+  auto h = tilings();
+  while(h->solve() == 10)
+    expected.push_back(h->selected_options());
+  REQUIRE(expected.size() == 36);
+
+  h = tilings();
+  std::vector<std::vector<int32_t>> solutions;
+  unsigned int batches = 0;
+  long long count = h->enumerate(
+    [&](const int32_t* options, const uint32_t* offsets, unsigned int count) {
+      REQUIRE(count <= 10);
+      ++batches;
+      for(unsigned int k = 0; k < count; ++k)
+        solutions.emplace_back(options + offsets[k], options + offsets[k + 1]);
+      return true;
+    },
+    10);
+  REQUIRE(count == 36);
+  REQUIRE(batches == 4);
+  REQUIRE(solutions == expected);
+
+  // Stopping early continues with the next solution.
+  h = tilings();
+  auto first = h->next_solutions(20);
+  REQUIRE(first.size() == 20);
+  REQUIRE(h->solve() == 10);
+  REQUIRE(h->selected_options() == expected[20]);
+  auto rest = h->next_solutions(100);
+  REQUIRE(rest.size() == 15);
+  REQUIRE(h->next_solutions().empty());
+  first.push_back(expected[20]);
+  first.insert(first.end(), rest.begin(), rest.end());
+  REQUIRE(first == expected);
+
+  // Cancelling during the enumeration is reported, and the next one starts
+  // again from the first solution.
+  h = tilings();
+  h->progress(nullptr, 1);
+  long long before = h->enumerate(
+    [&](const int32_t*, const uint32_t*, unsigned int) {
+      h->cancel();
+      return true;
+    },
+    1);
+  REQUIRE(before < 36);
+  REQUIRE(h->cancelled());
+  REQUIRE_FALSE(h->has_solution());
+  REQUIRE(h->next_solutions(100) == expected);
+  REQUIRE_FALSE(h->cancelled());
+  REQUIRE_FALSE(h->has_solution());
+}
+
+TEST_CASE("assumptions force and forbid options on one matrix") {
+  std::string str = domino_problem(4);
+
+  using solution = std::vector<miniexact_link>;
+  auto enumerate = [](miniexact_algorithm* a,
+                      miniexact_problem* p,
+                      miniexact_assumptions* s) {
+    std::vector<solution> solutions;
+    while(miniexact_assumptions_solve(s, a, p) == 10) {
+      solution sol(s->forced_size + p->l);
+      miniexact_assumptions_extract_solution(s, p, sol.data());
+      std::sort(sol.begin(), sol.end());
+      solutions.push_back(sol);
+    }
+    return solutions;
+  };
+
+  for_each_xcm([&](const miniexact_algorithm& mrv) {
+    for(bool buckets : { false, true }) {
+      // Buckets replace MRV, not the heuristic of M.
+      miniexact_algorithm algorithm = mrv;
+      if(buckets && algorithm.choose_i == &miniexact_choose_i_mrv)
+        algorithm.choose_i = &miniexact_choose_i_mrv_bucket;
+
+      miniexact_problem_ptr p(
+        miniexact_parse_problem(&algorithm, str.c_str()));
+      REQUIRE(p);
+      miniexact_assumptions s;
+      REQUIRE(miniexact_assumptions_init(&s, p.get()) == nullptr);
+      REQUIRE(s.options == 24);
+
+      std::vector<solution> all = enumerate(&algorithm, p.get(), &s);
+      REQUIRE(all.size() == 36);
+
+      uint32_t seed = 1;
+      auto random = [&seed](miniexact_link n) {
+        seed = seed * 1103515245u + 12345u;
+        return (miniexact_link)((seed >> 16) % n) + 1;
+      };
+      for(int t = 0; t < 50; ++t) {
+        solution force, forbid;
+        for(int k = random(3) - 1; k > 0; --k)
+          force.push_back(random(24));
+        for(int k = random(4) - 1; k > 0; --k)
+          forbid.push_back(random(24));
+
+        // Stop some instances after the first solution.
+        if(t % 3 == 0) {
+          REQUIRE(miniexact_assume(&s,
+                                   &algorithm,
+                                   p.get(),
+                                   force.data(),
+                                   force.size(),
+                                   forbid.data(),
+                                   forbid.size()) == nullptr);
+          miniexact_assumptions_solve(&s, &algorithm, p.get());
+        }
+
+        REQUIRE(miniexact_assume(&s,
+                                 &algorithm,
+                                 p.get(),
+                                 force.data(),
+                                 force.size(),
+                                 forbid.data(),
+                                 forbid.size()) == nullptr);
+        std::vector<solution> expected;
+        for(const solution& sol : all) {
+          auto has = [&sol](miniexact_link o) {
+            return std::binary_search(sol.begin(), sol.end(), o);
+          };
+          if(std::all_of(force.begin(), force.end(), has) &&
+             std::none_of(forbid.begin(), forbid.end(), has))
+            expected.push_back(sol);
+        }
+        std::vector<solution> found = enumerate(&algorithm, p.get(), &s);
+        std::sort(expected.begin(), expected.end());
+        std::sort(found.begin(), found.end());
+        REQUIRE(found == expected);
+      }
+
+      // The original matrix finds the solutions in the same order.
+      miniexact_assumptions_undo(&s, &algorithm, p.get());
+      REQUIRE(enumerate(&algorithm, p.get(), &s) == all);
+      miniexact_assumptions_free(&s, &algorithm, p.get());
+    }
+  });
+
+  // Purified colors are restored, too.
+  miniexact_algorithm algorithm;
+  miniexact_algorithm_c_set(&algorithm);
+  miniexact_problem_ptr p(miniexact_parse_problem(
+    &algorithm,
+    "< p q r > [ x y ] p q x y:A; p r x:A y; p x:B; q x:A; r y; q x:B;"));
+  REQUIRE(p);
+  miniexact_assumptions s;
+  REQUIRE(miniexact_assumptions_init(&s, p.get()) == nullptr);
+  REQUIRE(enumerate(&algorithm, p.get(), &s) ==
+          std::vector<solution>{ { 2, 4 }, { 3, 5, 6 } });
+
+  miniexact_link force[] = { 2, 3 };
+  REQUIRE(miniexact_assume(&s, &algorithm, p.get(), force, 2, nullptr, 0) ==
+          nullptr);
+  REQUIRE(s.conflict);
+  REQUIRE(miniexact_assumptions_solve(&s, &algorithm, p.get()) == 20);
+
+  REQUIRE(miniexact_assume(&s, &algorithm, p.get(), force + 1, 1, nullptr, 0) ==
+          nullptr);
+  REQUIRE(enumerate(&algorithm, p.get(), &s) ==
+          std::vector<solution>{ { 3, 5, 6 } });
+
+  miniexact_link unknown = 7;
+  REQUIRE(miniexact_assume(&s, &algorithm, p.get(), &unknown, 1, nullptr, 0) !=
+          nullptr);
+  miniexact_assumptions_undo(&s, &algorithm, p.get());
+  REQUIRE(enumerate(&algorithm, p.get(), &s).size() == 2);
+  miniexact_assumptions_free(&s, &algorithm, p.get());
+
+  // Multiplicities are not supported.
+  miniexact_algorithm_m_set(&algorithm);
+  p.reset(miniexact_parse_problem(&algorithm, "< a:0;2 b > a b; a;"));
+  REQUIRE(p);
+  REQUIRE(miniexact_assumptions_init(&s, p.get()) != nullptr);
+}